@@ -11,8 +11,19 @@
 #include <zivid_camera/CaptureGeneralConfig.h>
 #include <zivid_camera/Capture2DFrameConfig.h>
 #include <zivid_camera/Capture.h>
+#include <zivid_camera/CaptureAction.h>
+#include <zivid_camera/CaptureScheduled.h>
+#include <zivid_camera/CaptureWithSettings.h>
 #include <zivid_camera/Capture2D.h>
+#include <zivid_camera/Capture2DScheduled.h>
+#include <zivid_camera/CaptureBoth.h>
 #include <zivid_camera/CaptureAssistantSuggestSettings.h>
+#include <zivid_camera/CaptureAssistantSuggestSettingsCached.h>
+#include <zivid_camera/ClearSuggestedSettingsCache.h>
 #include <zivid_camera/CameraInfoModelName.h>
 #include <zivid_camera/CameraInfoSerialNumber.h>
 #include <zivid_camera/IsConnected.h>
+#include <zivid_camera/SavePreset.h>
+#include <zivid_camera/SelectPreset.h>
+#include <zivid_camera/CompressedPointCloud.h>
+#include <zivid_camera/PointCloudStats.h>
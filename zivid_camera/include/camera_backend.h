@@ -0,0 +1,52 @@
+#pragma once
+
+#include <Zivid/CameraIntrinsics.h>
+#include <Zivid/CaptureAssistant.h>
+#include <Zivid/Frame.h>
+#include <Zivid/Image.h>
+#include <Zivid/PointCloud.h>
+#include <Zivid/Settings.h>
+#include <Zivid/Settings2D.h>
+
+#include <chrono>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace zivid_camera
+{
+// The result of a 3D capture performed by a CameraBackend
+struct CapturedFrame
+{
+  Zivid::PointCloud point_cloud;
+  // The Zivid::Frame that the point cloud belongs to. Only set by backends that capture via the Zivid SDK.
+  std::optional<Zivid::Frame> frame;
+  // The time at which the capture was originally taken, if it should be used instead of the current time in the
+  // published messages. Set by backends that replay recorded captures.
+  std::optional<std::chrono::system_clock::time_point> timestamp;
+};
+
+// Interface to the device that performs the captures. ZividCamera only talks to the camera via this interface, which
+// makes it possible to run the ROS side of the driver against other sources than a Zivid camera.
+class CameraBackend
+{
+public:
+  virtual ~CameraBackend() = default;
+
+  virtual std::string modelName() = 0;
+  virtual std::string serialNumber() = 0;
+
+  virtual bool isConnected() = 0;
+  // Re-connect to the camera if it is available. Returns true if the camera was re-connected.
+  virtual bool reconnectIfAvailable() = 0;
+
+  // The current (default) settings of the camera. Used to find the default, min and max values of the settings.
+  virtual Zivid::Settings settings() = 0;
+  virtual Zivid::CameraIntrinsics intrinsics() = 0;
+
+  virtual CapturedFrame capture(const std::vector<Zivid::Settings>& settings) = 0;
+  virtual Zivid::Image<Zivid::RGBA8> capture2D(const Zivid::Settings2D& settings) = 0;
+  virtual std::vector<Zivid::Settings>
+  suggestSettings(const Zivid::CaptureAssistant::SuggestSettingsParameters& parameters) = 0;
+};
+}  // namespace zivid_camera
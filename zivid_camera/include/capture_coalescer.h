@@ -0,0 +1,67 @@
+#pragma once
+
+#include <Zivid/Settings.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Lets concurrent capture requests with identical settings share one acquisition. A request joins an acquisition
+// with the same settings if it is still waiting for the camera, or if it started at most `freshness_window` before
+// the request arrived. All the joined requests return when the acquisition has been published, so every client
+// gets a frame that was captured no earlier than freshness_window before its request.
+
+namespace zivid_camera
+{
+class CaptureCoalescer
+{
+public:
+  struct Statistics
+  {
+    std::uint64_t num_requests;
+    std::uint64_t num_acquisitions;
+    // Requests that were satisfied by the acquisition of another request
+    std::uint64_t num_coalesced;
+  };
+
+  // Runs a job when the camera is available, exclusively of the other users of the camera
+  using RunExclusive = std::function<void(const std::function<void()>& job)>;
+
+  explicit CaptureCoalescer(std::chrono::nanoseconds freshness_window);
+
+  // Run `acquire` with run_exclusive, or wait for an acquisition with the same key that this request can join.
+  // Exceptions from the acquisition are rethrown in all the requests that joined it.
+  void request(const std::string& key, const RunExclusive& run_exclusive, const std::function<void()>& acquire);
+
+  Statistics statistics() const;
+
+private:
+  // Value-initialized when created, so that the acquisition is not started or done
+  struct Acquisition
+  {
+    bool started;
+    std::chrono::steady_clock::time_point start_time;
+    bool done;
+    std::exception_ptr error;
+  };
+
+  bool canJoin(const Acquisition& acquisition, std::chrono::steady_clock::time_point now) const;
+
+  const std::chrono::nanoseconds freshness_window_;
+  mutable std::mutex mutex_;
+  std::condition_variable acquisition_done_;
+  // The latest acquisition of each key that has not completed
+  std::unordered_map<std::string, std::shared_ptr<Acquisition>> acquisitions_;
+  Statistics statistics_;
+};
+
+// Key of the captures with `settings`
+std::string captureCoalescingKey(const std::vector<Zivid::Settings>& settings);
+}  // namespace zivid_camera
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <chrono>
+
+namespace zivid_camera
+{
+// Limits the rate of captures returned by backends that can capture faster than a real camera
+class CaptureRateLimiter
+{
+public:
+  // Maximum number of captures per second. If 0 the rate is not limited.
+  explicit CaptureRateLimiter(double rate);
+
+  // Sleep until the next capture is allowed
+  void waitForNextCaptureSlot();
+
+private:
+  double rate_;
+  std::chrono::steady_clock::time_point next_capture_time_;
+};
+}  // namespace zivid_camera
@@ -0,0 +1,135 @@
+#pragma once
+
+#include "camera_backend.h"
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Records captures to disk from a pool of background writer threads, so that the capture path never waits on disk
+// I/O. Captures are queued in memory up to a configurable number of bytes. If the queue is full when a capture arrives,
+// the capture is dropped and counted.
+//
+// Supported file formats:
+//  - zdf: The native Zivid format, written with Zivid::Frame::save. Captures without a Zivid::Frame (e.g. from the
+//    synthetic camera) are written in the chunked format instead.
+//  - chunked (.zpc): Little-endian binary format that can be memory-mapped. The file starts with a
+//    RecordingFileHeader, followed by num_chunks RecordingChunkIndexEntry. Each chunk holds rows_per_chunk rows (fewer
+//    for the last chunk) of points with the same layout as the data of the PointCloud2 messages on the `points` topic
+//    (x, y, z in meters, contrast, rgba; 20 bytes per point). The chunks start at offsets aligned to
+//    recording_chunk_alignment bytes.
+//  - pcd: PCL's binary PCD format, with fields x y z c rgb.
+
+namespace zivid_camera
+{
+constexpr char recording_file_magic[4] = { 'Z', 'P', 'C', 'R' };
+constexpr std::uint32_t recording_file_version = 1;
+constexpr std::size_t recording_chunk_alignment = 4096;
+
+struct RecordingFileHeader
+{
+  char magic[4];
+  std::uint32_t version;
+  std::uint32_t width;
+  std::uint32_t height;
+  std::uint32_t point_step;
+  std::uint32_t rows_per_chunk;
+  std::uint32_t num_chunks;
+  std::uint32_t header_seq;
+  std::uint32_t stamp_sec;
+  std::uint32_t stamp_nsec;
+  char frame_id[64];
+};
+
+struct RecordingChunkIndexEntry
+{
+  std::uint64_t offset;
+  std::uint64_t size;
+  std::uint32_t first_row;
+  std::uint32_t num_rows;
+};
+
+enum class RecordingFormat
+{
+  Zdf,
+  Chunked,
+  Pcd
+};
+
+RecordingFormat recordingFormatFromString(const std::string& name);
+
+struct RecordingMetadata
+{
+  std::uint32_t header_seq;
+  std::uint32_t stamp_sec;
+  std::uint32_t stamp_nsec;
+  std::string frame_id;
+};
+
+class CaptureRecorder
+{
+public:
+  struct Parameters
+  {
+    std::string directory;
+    RecordingFormat format;
+    std::size_t num_threads;
+    // Maximum total size of the point clouds waiting to be written
+    std::size_t max_queue_bytes;
+    std::size_t rows_per_chunk;
+  };
+
+  struct Statistics
+  {
+    std::uint64_t num_recorded;
+    std::uint64_t num_dropped;
+    std::uint64_t num_failed;
+    std::size_t queue_length;
+    std::size_t queue_bytes;
+    std::string last_error;
+  };
+
+  explicit CaptureRecorder(const Parameters& parameters);
+  // Waits for the queued captures to be written
+  ~CaptureRecorder();
+  CaptureRecorder(const CaptureRecorder&) = delete;
+  CaptureRecorder& operator=(const CaptureRecorder&) = delete;
+
+  // Queue the capture for writing. Returns false if the capture was dropped because the queue is full. Never blocks on
+  // disk I/O. The capture is shared, so that it can also be used by the caller while it is waiting to be written.
+  bool record(const RecordingMetadata& metadata, std::shared_ptr<const CapturedFrame> frame);
+
+  Statistics statistics() const;
+
+  const Parameters& parameters() const
+  {
+    return parameters_;
+  }
+
+private:
+  struct Job
+  {
+    RecordingMetadata metadata;
+    std::shared_ptr<const CapturedFrame> frame;
+    std::size_t size;
+  };
+
+  void writerThread();
+  void write(const Job& job) const;
+
+  Parameters parameters_;
+  mutable std::mutex mutex_;
+  std::condition_variable queue_not_empty_;
+  std::deque<Job> queue_;
+  std::size_t queue_bytes_;
+  bool stop_;
+  Statistics statistics_;
+  std::vector<std::thread> threads_;
+};
+}  // namespace zivid_camera
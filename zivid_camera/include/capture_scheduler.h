@@ -0,0 +1,86 @@
+#pragma once
+
+#include "realtime.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+// Gives the camera to one capture job at a time, in priority order. Jobs are never interrupted, so a waiting job with
+// a higher priority runs as soon as the current job has finished (preemption at job boundaries). Among jobs with the
+// same priority, jobs with a deadline run first, by earliest deadline, followed by the jobs without a deadline in the
+// order they arrived. A job that has not started by its deadline, or that is cancelled while it waits, is dropped.
+
+namespace zivid_camera
+{
+class CaptureScheduler
+{
+public:
+  struct Request
+  {
+    // Higher values run first
+    int priority;
+    // Latest time at which the job may start
+    std::optional<std::chrono::steady_clock::time_point> deadline;
+  };
+
+  struct WaitStatistics
+  {
+    int priority;
+    // Time from the request until the job started, for the jobs that started since the previous call
+    LatencyStatistics::Summary wait;
+    std::uint64_t num_expired;
+  };
+
+  CaptureScheduler();
+
+  // Wait for the turn of the request, and run job on the calling thread. Throws std::runtime_error without running
+  // the job if the deadline passes before it can start. Exceptions from the job are propagated to the caller.
+  void run(const Request& request, const std::function<void()>& job);
+
+  // Same as above, but the job is also dropped (with std::runtime_error) if cancelled is set while the request waits.
+  // Call notifyCancelled() after setting the flag, so that the waiting request sees it. A job that has started is
+  // not affected.
+  void run(const Request& request, const std::function<void()>& job, const std::atomic<bool>& cancelled);
+
+  void notifyCancelled();
+
+  // Number of requests waiting for their turn
+  std::size_t numWaiting();
+
+  // Wait statistics of each priority that has been requested, by increasing priority
+  std::vector<WaitStatistics> takeWaitStatistics();
+
+private:
+  struct Ticket
+  {
+    Request request;
+    std::uint64_t sequence;
+  };
+
+  struct PriorityStatistics
+  {
+    LatencyStatistics wait;
+    std::uint64_t num_expired;
+  };
+
+  void schedule(const Request& request, const std::function<void()>& job, const std::atomic<bool>* cancelled);
+  static bool runsBefore(const Ticket& a, const Ticket& b);
+  bool isNext(const Ticket& ticket) const;
+  PriorityStatistics& statistics(int priority);
+
+  std::mutex mutex_;
+  std::condition_variable turn_changed_;
+  bool busy_;
+  std::uint64_t next_sequence_;
+  std::vector<const Ticket*> waiting_;
+  std::map<int, PriorityStatistics> statistics_;
+};
+}  // namespace zivid_camera
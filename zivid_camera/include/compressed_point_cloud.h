@@ -0,0 +1,52 @@
+#pragma once
+
+#include "point_cloud_codec.h"
+
+#include <sensor_msgs/PointCloud2.h>
+#include <sensor_msgs/PointField.h>
+#include <zivid_camera/CompressedPointCloud.h>
+
+#include <boost/predef.h>
+
+// Helper for subscribers of points/compressed. Link with the zivid_camera_point_cloud_codec library.
+
+namespace zivid_camera
+{
+// Decompress a message from the points/compressed topic into a PointCloud2 with the same layout as the messages on
+// the points topic. The bands are decoded in parallel on thread_pool. Throws std::runtime_error if the message is
+// corrupt.
+inline sensor_msgs::PointCloud2Ptr decompressPointCloud(const CompressedPointCloud& compressed, ThreadPool& thread_pool)
+{
+  auto msg = boost::make_shared<sensor_msgs::PointCloud2>();
+  msg->header = compressed.header;
+  msg->height = compressed.height;
+  msg->width = compressed.width;
+  msg->is_bigendian = BOOST_ENDIAN_BIG_BYTE;
+  msg->is_dense = false;
+  msg->point_step = static_cast<uint32_t>(point_cloud_codec_point_step);
+  msg->row_step = msg->point_step * msg->width;
+
+  const char* names[] = { "x", "y", "z", "c", "rgb" };
+  msg->fields.resize(5);
+  for (std::size_t i = 0; i < msg->fields.size(); i++)
+  {
+    msg->fields[i].name = names[i];
+    msg->fields[i].offset = static_cast<uint32_t>(4 * i);
+    msg->fields[i].datatype = sensor_msgs::PointField::FLOAT32;
+    msg->fields[i].count = 1;
+  }
+
+  EncodedPointCloud encoded{ compressed.band_offsets, compressed.data };
+  msg->data.resize(static_cast<std::size_t>(msg->row_step) * msg->height);
+  decodePointCloud(encoded, compressed.width, compressed.height, compressed.resolution, compressed.rows_per_band,
+                   msg->data.data(), thread_pool);
+  return msg;
+}
+
+// Same as above, on a thread pool with one thread per hardware thread that is shared by all calls
+inline sensor_msgs::PointCloud2Ptr decompressPointCloud(const CompressedPointCloud& compressed)
+{
+  static ThreadPool thread_pool(0, 4);
+  return decompressPointCloud(compressed, thread_pool);
+}
+}  // namespace zivid_camera
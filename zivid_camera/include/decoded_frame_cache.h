@@ -0,0 +1,72 @@
+#pragma once
+
+#include "camera_backend.h"
+#include "thread_pool.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace zivid_camera
+{
+// Least-recently-used cache of decoded captures, limited by the total size of the point clouds. Used in file camera
+// mode, where every capture of the same file with the same settings gives the same result. Only the point clouds are
+// kept, not the Zivid::Frame, so the size limit is the memory used by the cache. The point clouds are copied in and
+// out of the cache on thread_pool, so that a hit costs a parallel memory copy instead of a decode.
+class DecodedFrameCache
+{
+public:
+  DecodedFrameCache(std::size_t max_bytes, ThreadPool& thread_pool);
+
+  // Returns a copy of the cached capture, so that the cached point cloud can not be modified by the caller. The
+  // returned capture has no Zivid::Frame.
+  std::optional<CapturedFrame> get(const std::string& key);
+  // Captures larger than max_bytes are not cached
+  void put(const std::string& key, const CapturedFrame& frame);
+
+  std::size_t sizeBytes() const
+  {
+    return size_bytes_;
+  }
+  std::size_t numEntries() const
+  {
+    return entries_.size();
+  }
+  std::uint64_t numHits() const
+  {
+    return num_hits_;
+  }
+  std::uint64_t numMisses() const
+  {
+    return num_misses_;
+  }
+
+private:
+  Zivid::PointCloud copyPointCloud(const Zivid::PointCloud& point_cloud);
+
+  struct Entry
+  {
+    std::string key;
+    Zivid::PointCloud point_cloud;
+    std::optional<std::chrono::system_clock::time_point> timestamp;
+    std::size_t size;
+  };
+
+  std::size_t max_bytes_;
+  ThreadPool& thread_pool_;
+  std::size_t size_bytes_;
+  std::uint64_t num_hits_;
+  std::uint64_t num_misses_;
+  // Most recently used first
+  std::list<Entry> entries_;
+  std::unordered_map<std::string, std::list<Entry>::iterator> index_;
+};
+
+// Key for the capture of `file_path` with `settings`
+std::string decodedFrameCacheKey(const std::string& file_path, const std::vector<Zivid::Settings>& settings);
+}  // namespace zivid_camera
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "thread_pool.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Rectification (undistortion) of images with precomputed remap tables. For each pixel in the rectified image, the
+// table holds the position in the raw image that the pixel is sampled from. The table is computed once from the camera
+// model, so rectifying an image is a single pass of lookups. The rectified images have the same camera matrix as the
+// raw images, and no distortion.
+//
+// The images are processed in square tiles, in parallel. Neighboring pixels in a tile sample from neighboring
+// positions in the raw image, so each tile touches a small part of the raw image.
+
+namespace zivid_camera
+{
+// Pinhole camera with plumb_bob distortion, as published in sensor_msgs/CameraInfo
+struct PinholeCameraModel
+{
+  double fx;
+  double fy;
+  double cx;
+  double cy;
+  double k1;
+  double k2;
+  double p1;
+  double p2;
+  double k3;
+};
+
+bool operator==(const PinholeCameraModel& lhs, const PinholeCameraModel& rhs);
+
+class RectificationMap
+{
+public:
+  RectificationMap(const PinholeCameraModel& model, std::size_t width, std::size_t height);
+
+  const PinholeCameraModel& model() const
+  {
+    return model_;
+  }
+  std::size_t width() const
+  {
+    return width_;
+  }
+  std::size_t height() const
+  {
+    return height_;
+  }
+
+  // Rectify an image with `channels` interleaved 8-bit channels, using bilinear interpolation. Pixels that sample from
+  // outside the raw image are 0.
+  void remapBilinear(const std::uint8_t* src, std::size_t channels, std::uint8_t* dst, ThreadPool& thread_pool) const;
+
+  // Rectify a single-channel float image (e.g. depth), using the nearest raw pixel. Depth is not interpolated across
+  // edges, and missing (NaN) pixels stay missing. Pixels that sample from outside the raw image are NaN.
+  void remapNearest(const float* src, float* dst, ThreadPool& thread_pool) const;
+
+private:
+  // The rectified pixel samples between raw pixels (x0, y0) and (x0 + 1, y0 + 1), with weights wx and wy for the
+  // second pixel in each direction. x0 is negative if the position is outside the raw image.
+  struct Entry
+  {
+    std::int32_t x0;
+    std::int32_t y0;
+    float wx;
+    float wy;
+  };
+
+  template <typename Fn>
+  void forEachTile(ThreadPool& thread_pool, Fn&& fn) const;
+
+  PinholeCameraModel model_;
+  std::size_t width_;
+  std::size_t height_;
+  std::vector<Entry> entries_;
+};
+}  // namespace zivid_camera
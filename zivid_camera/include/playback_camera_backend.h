@@ -0,0 +1,64 @@
+#pragma once
+
+#include "camera_backend.h"
+#include "capture_rate_limiter.h"
+
+#include <Zivid/Application.h>
+#include <Zivid/Camera.h>
+
+#include <cstddef>
+#include <future>
+#include <string>
+#include <vector>
+
+namespace zivid_camera
+{
+// Backend that plays back a sequence of ZDF files. Each capture returns the next file in the sequence, which makes it
+// possible to replay recorded scenes at a controlled rate for load-testing. The next file is decoded in the
+// background while the current capture is being processed.
+class PlaybackCameraBackend : public CameraBackend
+{
+public:
+  struct Parameters
+  {
+    std::vector<std::string> files;
+    // Maximum number of captures per second. If 0 the captures are returned as fast as they can be decoded.
+    double rate;
+    // Use the time stamps stored in the ZDF files instead of the current time
+    bool use_recorded_timestamps;
+    // Start from the first file again after the last file. If false, capture throws after the last file.
+    bool loop;
+  };
+
+  explicit PlaybackCameraBackend(const Parameters& parameters);
+  ~PlaybackCameraBackend() override;
+
+  std::string modelName() override;
+  std::string serialNumber() override;
+  bool isConnected() override;
+  bool reconnectIfAvailable() override;
+  Zivid::Settings settings() override;
+  Zivid::CameraIntrinsics intrinsics() override;
+  CapturedFrame capture(const std::vector<Zivid::Settings>& settings) override;
+  Zivid::Image<Zivid::RGBA8> capture2D(const Zivid::Settings2D& settings) override;
+  std::vector<Zivid::Settings>
+  suggestSettings(const Zivid::CaptureAssistant::SuggestSettingsParameters& parameters) override;
+
+private:
+  void startLoading(std::size_t index);
+  // Starts loading the file after index, unless index is the last file and the playback does not loop
+  void startLoadingAfter(std::size_t index);
+
+  Parameters parameters_;
+  Zivid::Application zivid_;
+  // File camera created from the first file. Provides the settings and intrinsics.
+  Zivid::Camera camera_;
+  CaptureRateLimiter rate_limiter_;
+  std::size_t next_index_;
+  std::future<Zivid::Frame> next_frame_;
+};
+
+// The ZDF files to play back from `path`. If path is a directory, all .zdf files in it sorted by name. Otherwise the
+// path itself.
+std::vector<std::string> playbackFilesFromPath(const std::string& path);
+}  // namespace zivid_camera
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "thread_pool.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Codec for organized point clouds with the layout of the PointCloud2 messages on the `points` topic: 20 bytes per
+// point with fields x, y, z (float32, meters), c (float32, contrast) and rgb (packed RGBA, 4 bytes).
+//
+// The cloud is split into bands of rows that are encoded independently (and in parallel). Within a band every value is
+// predicted from the pixel above it (or to the left of it in the first row of the band) and only the residual is
+// stored:
+//  - x, y and z are quantized to `resolution` meters, and the zig-zag encoded difference to the prediction is stored
+//    as a varint. Missing (NaN) points are stored in a bitmask. If resolution is 0 the float bits are XOR-ed with the
+//    prediction instead, which makes the codec lossless.
+//  - Contrast is always lossless, using the XOR of the float bits.
+//  - The color channels are stored as byte-wise differences, one plane per channel.
+// The residual streams of each band are then entropy coded with zlib (deflate) at the fastest setting.
+//
+// With resolution > 0 the decoded x, y and z values are within resolution / 2 of the original values.
+
+namespace zivid_camera
+{
+struct EncodedPointCloud
+{
+  // Byte offset in data where each band starts
+  std::vector<std::uint32_t> band_offsets;
+  std::vector<std::uint8_t> data;
+};
+
+constexpr std::size_t point_cloud_codec_point_step = 20;
+
+EncodedPointCloud encodePointCloud(const std::uint8_t* points, std::size_t width, std::size_t height,
+                                   float resolution, std::size_t rows_per_band, ThreadPool& thread_pool);
+
+// Decode into `points`, which must have room for width * height points. Throws std::runtime_error if the data is
+// corrupt.
+void decodePointCloud(const EncodedPointCloud& encoded, std::size_t width, std::size_t height, float resolution,
+                      std::size_t rows_per_band, std::uint8_t* points, ThreadPool& thread_pool);
+}  // namespace zivid_camera
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "thread_pool.h"
+
+#include <Zivid/PointCloud.h>
+
+#include <cstddef>
+#include <string>
+
+namespace zivid_camera
+{
+// How the points in each block are reduced to one point when decimating
+enum class DepthReduction
+{
+  // The point with the smallest z, i.e. the closest point
+  Min,
+  // The point with the median z. Less sensitive to outliers than Min.
+  Median
+};
+
+DepthReduction depthReductionFromString(const std::string& name);
+
+// Decimate point_cloud by `factor` in both dimensions. Each output point is a block of factor x factor input points,
+// and incomplete blocks at the right and bottom edges are discarded. The position and contrast of each output point is
+// taken from the valid (non-NaN) point in the block selected by `reduction`; blocks without valid points are NaN. The
+// color is the average color of all points in the block.
+Zivid::PointCloud decimatePointCloud(const Zivid::PointCloud& point_cloud, std::size_t factor,
+                                     DepthReduction reduction, ThreadPool& thread_pool);
+}  // namespace zivid_camera
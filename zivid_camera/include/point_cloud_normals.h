@@ -0,0 +1,28 @@
+#pragma once
+
+#include "point_transform.h"
+#include "thread_pool.h"
+
+#include <Zivid/PointCloud.h>
+
+#include <cstddef>
+#include <cstdint>
+
+// Surface normal estimation on the organized grid of a Zivid::PointCloud. The normal of each point is the cross
+// product of the horizontal and vertical tangents through the point, estimated from the neighbors `neighbor_distance`
+// pixels away in the same row and column. Central differences are used when both neighbors are valid, and one-sided
+// differences when only one of them is. This needs no neighbor search, and runs in a single pass over the grid.
+
+namespace zivid_camera
+{
+// Layout of each point written by copyPointsWithNormalsInMeters: x, y, z (m), contrast, rgba, normal_x, normal_y,
+// normal_z. All fields are 4 bytes.
+constexpr std::size_t point_with_normal_step = 32;
+
+// Write the points and their normals to dst, transforming the points with `transform` (which includes the conversion
+// from mm to m). The normals have unit length, point towards the camera and are rotated with the transform. Points
+// without a valid normal (the point itself or all neighbors in one direction are NaN) get a NaN normal. dst must hold
+// point_cloud.size() * point_with_normal_step bytes.
+void copyPointsWithNormalsInMeters(const Zivid::PointCloud& point_cloud, std::size_t neighbor_distance,
+                                   const PointTransform& transform, std::uint8_t* dst, ThreadPool& thread_pool);
+}  // namespace zivid_camera
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "thread_pool.h"
+
+#include <Zivid/PointCloud.h>
+
+#include <string>
+
+// Base class of the pluginlib plugins that post-process each captured point cloud inside the driver, before it is
+// converted to ROS messages. The plugins run in the process of the driver, and modify the point cloud in place, so a
+// filter in the chain costs no serialization or copies. Plugins are exported with PLUGINLIB_EXPORT_CLASS(MyProcessor,
+// zivid_camera::PointCloudProcessor), and are configured with the processors parameter of the driver.
+
+namespace ros
+{
+class NodeHandle;
+}
+
+namespace zivid_camera
+{
+class PointCloudProcessor
+{
+public:
+  virtual ~PointCloudProcessor() = default;
+
+  // Called once, before the first call to process. nh is in the namespace processors/<name> under the private
+  // namespace of the driver, where the processor reads its parameters. Throw std::runtime_error if the configuration
+  // is invalid.
+  virtual void initialize(const std::string& name, ros::NodeHandle& nh) = 0;
+
+  // Modify the organized point cloud in place. x, y and z are in mm in the optical frame of the camera. Remove points
+  // by setting x, y and z to NaN, since the point cloud must keep its size. thread_pool can be used to process the
+  // point cloud in parallel.
+  virtual void process(Zivid::PointCloud& point_cloud, ThreadPool& thread_pool) = 0;
+};
+}  // namespace zivid_camera
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "point_cloud_processor.h"
+#include "realtime.h"
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Runs the configured PointCloudProcessor plugins in order on each captured point cloud, and measures the time spent
+// in each of them.
+
+namespace zivid_camera
+{
+class PointCloudProcessorChain
+{
+public:
+  struct Timing
+  {
+    std::string name;
+    LatencyStatistics::Summary summary;
+    std::chrono::nanoseconds max_overall;
+  };
+
+  void add(const std::string& name, std::shared_ptr<PointCloudProcessor> processor);
+  bool empty() const;
+
+  // Run the processors in the order they were added. Exceptions from the processors are propagated to the caller, and
+  // the remaining processors are not run.
+  void process(Zivid::PointCloud& point_cloud, ThreadPool& thread_pool);
+
+  // The processing time of each processor since the previous call, in the order they run
+  std::vector<Timing> takeTimings();
+
+private:
+  struct Stage
+  {
+    std::string name;
+    std::shared_ptr<PointCloudProcessor> processor;
+    std::unique_ptr<LatencyStatistics> latency;
+  };
+
+  std::vector<Stage> stages_;
+};
+}  // namespace zivid_camera
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "point_transform.h"
+#include "thread_pool.h"
+
+#include <Zivid/PointCloud.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Statistics of a point cloud for monitoring (valid ratio, bounding box, depth histogram), computed in the same pass
+// that transforms the points for the points topic. Each chunk of the pass accumulates into its own partial result,
+// and the partial results are merged afterwards, so the threads never share data while the points are processed.
+
+namespace zivid_camera
+{
+struct PointCloudStatisticsParameters
+{
+  // Range of the z histogram, in meters. Points with z outside [min, max) are not counted in the histogram.
+  float z_histogram_min;
+  float z_histogram_max;
+  std::size_t z_histogram_bins;
+};
+
+struct PointCloudStatistics
+{
+  std::size_t num_points;
+  // Number of points with valid (non-NaN) x, y and z. The remaining statistics only include the valid points.
+  std::size_t num_valid_points;
+  // x, y and z in meters, after the transform. NaN if there are no valid points.
+  std::array<float, 3> min;
+  std::array<float, 3> max;
+  std::array<float, 3> mean;
+  float mean_contrast;
+  std::vector<std::uint32_t> z_histogram;
+};
+
+// Transform the points with `transform` (which includes the conversion from mm to m) and compute their statistics. If
+// dst is not null, the transformed points are also written to dst, with the layout of the PointCloud2 messages on the
+// points topic. Throws std::runtime_error if the histogram parameters are invalid.
+PointCloudStatistics transformPointsWithStatistics(const Zivid::PointCloud& point_cloud,
+                                                   const PointTransform& transform,
+                                                   const PointCloudStatisticsParameters& parameters, std::uint8_t* dst,
+                                                   ThreadPool& thread_pool);
+}  // namespace zivid_camera
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <Zivid/PointCloud.h>
+
+#include <array>
+
+namespace zivid_camera
+{
+// Affine transform applied to each point when converting a Zivid::PointCloud to a message. The unit conversion
+// from mm to m is folded into the linear part, so that a point is converted and transformed with one multiply-add per
+// coordinate.
+struct PointTransform
+{
+  // Row-major 3x4 matrix [R | t]
+  std::array<float, 12> matrix;
+
+  // Convert from mm (in the camera frame) to m (in the camera frame)
+  static PointTransform millimetersToMeters()
+  {
+    return PointTransform{ { 0.001f, 0.0f, 0.0f, 0.0f, 0.0f, 0.001f, 0.0f, 0.0f, 0.0f, 0.0f, 0.001f, 0.0f } };
+  }
+
+  // Convert from mm in the camera frame to m in a target frame, given the rotation (unit quaternion x, y, z, w) and
+  // the translation (in m) of the transform from the camera frame to the target frame
+  static PointTransform millimetersToMeters(const std::array<double, 4>& rotation,
+                                            const std::array<double, 3>& translation)
+  {
+    const double x = rotation[0];
+    const double y = rotation[1];
+    const double z = rotation[2];
+    const double w = rotation[3];
+    // Rotation matrix of the unit quaternion, scaled by the unit conversion
+    const double s = 0.001;
+    return PointTransform{ {
+        static_cast<float>(s * (1 - 2 * (y * y + z * z))),
+        static_cast<float>(s * (2 * (x * y - z * w))),
+        static_cast<float>(s * (2 * (x * z + y * w))),
+        static_cast<float>(translation[0]),
+        static_cast<float>(s * (2 * (x * y + z * w))),
+        static_cast<float>(s * (1 - 2 * (x * x + z * z))),
+        static_cast<float>(s * (2 * (y * z - x * w))),
+        static_cast<float>(translation[1]),
+        static_cast<float>(s * (2 * (x * z - y * w))),
+        static_cast<float>(s * (2 * (y * z + x * w))),
+        static_cast<float>(s * (1 - 2 * (x * x + y * y))),
+        static_cast<float>(translation[2]),
+    } };
+  }
+
+  // Transform x, y and z of point in place. The contrast and color are not touched.
+  void applyToPoint(Zivid::Point& point) const
+  {
+    const float x = point.x;
+    const float y = point.y;
+    const float z = point.z;
+    point.x = matrix[0] * x + matrix[1] * y + matrix[2] * z + matrix[3];
+    point.y = matrix[4] * x + matrix[5] * y + matrix[6] * z + matrix[7];
+    point.z = matrix[8] * x + matrix[9] * y + matrix[10] * z + matrix[11];
+  }
+
+  // Apply only the linear part, e.g. to a normal. The result is scaled by the unit conversion.
+  std::array<float, 3> applyToDirection(const std::array<float, 3>& direction) const
+  {
+    return { matrix[0] * direction[0] + matrix[1] * direction[1] + matrix[2] * direction[2],
+             matrix[4] * direction[0] + matrix[5] * direction[1] + matrix[6] * direction[2],
+             matrix[8] * direction[0] + matrix[9] * direction[1] + matrix[10] * direction[2] };
+  }
+};
+}  // namespace zivid_camera
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+
+// Memory usage of the current process, as reported by Linux in /proc/self/status. Used to report the peak and
+// steady-state memory usage of each capture, so that the memory needed by the driver can be measured.
+
+namespace zivid_camera
+{
+struct ProcessMemoryUsage
+{
+  // VmRSS: the memory currently resident in RAM
+  std::size_t resident_bytes;
+  // VmHWM: the peak resident memory since the process started, or since the peak was last reset
+  std::size_t peak_resident_bytes;
+};
+
+// Throws std::runtime_error if the memory usage can not be read
+ProcessMemoryUsage readProcessMemoryUsage();
+
+// Reset the peak resident memory to the current resident memory, so that the peak of the next operation can be
+// measured. Returns false if the kernel does not support it.
+bool resetPeakResidentMemory();
+}  // namespace zivid_camera
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <pthread.h>
+#include <sched.h>
+#include <string>
+#include <vector>
+
+// Helpers for running the driver with bounded latency on Linux: pinning threads to CPUs, SCHED_FIFO priorities,
+// locking the memory of the process, and measuring latencies. All functions throw std::runtime_error on failure, e.g.
+// if the process lacks the privileges (CAP_SYS_NICE, CAP_IPC_LOCK or the corresponding rlimits).
+
+namespace zivid_camera
+{
+// Parse a set of CPUs, either as a list of CPUs and ranges ("0-3,6") or as a NUMA node ("numa:1"), in which case the
+// CPUs of the node are read from sysfs. An empty string is the empty set.
+std::vector<int> parseCpuSet(const std::string& spec);
+
+struct ThreadScheduling
+{
+  // CPUs that the thread may run on. If empty, the affinity is not changed.
+  std::vector<int> cpus;
+  // SCHED_FIFO priority in the range [1, 99]. If 0, the scheduling policy is not changed.
+  int fifo_priority;
+
+  bool isDefault() const
+  {
+    return cpus.empty() && fifo_priority == 0;
+  }
+};
+
+void applyThreadScheduling(pthread_t thread, const ThreadScheduling& scheduling);
+
+// Applies the scheduling to the current thread for the lifetime of the object, and then restores the previous
+// affinity and policy. Does nothing if the scheduling is the default. Used for threads that are shared with other
+// work, e.g. the ROS callback threads.
+class ScopedThreadScheduling
+{
+public:
+  explicit ScopedThreadScheduling(const ThreadScheduling& scheduling);
+  ~ScopedThreadScheduling();
+
+  ScopedThreadScheduling(const ScopedThreadScheduling&) = delete;
+  ScopedThreadScheduling& operator=(const ScopedThreadScheduling&) = delete;
+
+private:
+  bool active_;
+  cpu_set_t previous_cpus_;
+  int previous_policy_;
+  sched_param previous_param_;
+};
+
+// Lock all current and future memory of the process in RAM, and configure malloc to never return memory to the
+// operating system. Then allocate and touch prefault_bytes of heap and free it again, so that later allocations of up
+// to that size (e.g. the message buffers) do not page fault.
+void lockProcessMemory(std::size_t prefault_bytes);
+
+// Latencies recorded from several threads, summarized over a window (e.g. between two diagnostics updates)
+class LatencyStatistics
+{
+public:
+  struct Summary
+  {
+    std::uint64_t count;
+    std::chrono::nanoseconds mean;
+    std::chrono::nanoseconds max;
+  };
+
+  LatencyStatistics();
+
+  void add(std::chrono::nanoseconds latency);
+
+  // Summary of the latencies since the previous call, and the maximum since the start
+  Summary takeWindow();
+  std::chrono::nanoseconds maxOverall() const;
+
+private:
+  mutable std::mutex mutex_;
+  std::uint64_t count_;
+  std::chrono::nanoseconds sum_;
+  std::chrono::nanoseconds max_;
+  std::chrono::nanoseconds max_overall_;
+};
+}  // namespace zivid_camera
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "camera_backend.h"
+#include "decoded_frame_cache.h"
+
+#include <Zivid/Application.h>
+#include <Zivid/Camera.h>
+
+#include <memory>
+
+namespace zivid_camera
+{
+// Backend that captures using a Zivid camera, or a file camera if file_camera_path is non-empty. In file camera mode
+// the decoded captures can be cached in memory, so that repeated captures skip the SDK capture path.
+class SdkCameraBackend : public CameraBackend
+{
+public:
+  // file_camera_cache_max_bytes is the size of the decoded frame cache in file camera mode, 0 disables the cache. The
+  // cache copies the point clouds on thread_pool.
+  SdkCameraBackend(std::string serial_number, const std::string& file_camera_path, ThreadPool& thread_pool,
+                   std::size_t file_camera_cache_max_bytes = 0);
+
+  std::string modelName() override;
+  std::string serialNumber() override;
+  bool isConnected() override;
+  bool reconnectIfAvailable() override;
+  Zivid::Settings settings() override;
+  Zivid::CameraIntrinsics intrinsics() override;
+  CapturedFrame capture(const std::vector<Zivid::Settings>& settings) override;
+  Zivid::Image<Zivid::RGBA8> capture2D(const Zivid::Settings2D& settings) override;
+  std::vector<Zivid::Settings>
+  suggestSettings(const Zivid::CaptureAssistant::SuggestSettingsParameters& parameters) override;
+
+private:
+  Zivid::Application zivid_;
+  Zivid::Camera camera_;
+  std::string file_camera_path_;
+  std::unique_ptr<DecodedFrameCache> frame_cache_;
+};
+}  // namespace zivid_camera
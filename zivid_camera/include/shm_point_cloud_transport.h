@@ -0,0 +1,165 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include <sys/types.h>
+
+// Shared-memory transport for point clouds to consumers on the same host as the driver.
+//
+// The driver writes every point cloud into a POSIX shared-memory ring buffer with a fixed number of slots. Each frame
+// gets a monotonically increasing sequence number. Readers take a lease on the slot holding the frame they want to
+// read, and the writer never overwrites a slot that has an active lease. The frame data can therefore be used
+// directly from the mapped memory without copying. Leases expire after a reader-specified duration, so that a reader
+// that crashes while holding a lease does not block the slot forever. When the writer reclaims the expired leases of a
+// slot it starts a new lease epoch for the slot, so that the expired leases can no longer affect the new ones.
+//
+// If the frames grow larger than the slots, the writer replaces the segment with a larger one under the same name. The
+// readers map the new segment on their next acquire, and the sequence numbers continue from the old segment.
+//
+// The frame data has the same layout as the data of the PointCloud2 messages on the `points` topic: organized, with
+// fields x, y, z (float32, meters), c (float32, contrast) and rgb (packed in a float32).
+//
+// This header has no ROS dependencies, so that it can be used by any process on the host.
+
+namespace zivid_camera
+{
+namespace shm
+{
+struct RingHeader;
+struct SlotHeader;
+struct Mapping;
+}  // namespace shm
+
+struct ShmPointCloudMetadata
+{
+  static constexpr std::size_t max_frame_id_length = 64;
+
+  std::uint32_t width;
+  std::uint32_t height;
+  std::uint32_t point_step;
+  std::uint32_t row_step;
+  std::uint64_t data_size;
+  std::uint32_t stamp_sec;
+  std::uint32_t stamp_nsec;
+  std::uint32_t header_seq;
+  char frame_id[max_frame_id_length];
+};
+
+class ShmPointCloudWriter
+{
+public:
+  // Creates (or re-creates) the shared-memory segment `name`, e.g. "/zivid_camera_points". By default only processes of
+  // the same user can open the segment.
+  ShmPointCloudWriter(std::string name, std::size_t num_slots, std::size_t slot_capacity, mode_t mode = 0600);
+  ~ShmPointCloudWriter();
+  ShmPointCloudWriter(const ShmPointCloudWriter&) = delete;
+  ShmPointCloudWriter& operator=(const ShmPointCloudWriter&) = delete;
+
+  // Returns a pointer to a free slot with room for data_size bytes, or nullptr if data_size is larger than the slot
+  // capacity or all slots are leased by readers. A returned slot must be completed with commitWrite before the next
+  // call to beginWrite.
+  std::uint8_t* beginWrite(std::size_t data_size);
+  // Publish the frame written to the slot returned by the last beginWrite. Returns the frame's sequence number.
+  std::uint64_t commitWrite(const ShmPointCloudMetadata& metadata);
+  // Replace the segment with one with slots of slot_capacity bytes. The readers switch to the new segment on their
+  // next acquire. The leases on the old segment stay valid until they are released. If this throws, the writer can
+  // only be destroyed.
+  void resize(std::size_t slot_capacity);
+
+  const std::string& name() const
+  {
+    return name_;
+  }
+  std::size_t slotCapacity() const
+  {
+    return slot_capacity_;
+  }
+  std::uint64_t numDroppedFrames() const
+  {
+    return num_dropped_frames_;
+  }
+
+private:
+  void create();
+  void destroy();
+
+  std::string name_;
+  std::size_t num_slots_;
+  std::size_t slot_capacity_;
+  mode_t mode_;
+  std::size_t mapping_size_;
+  std::uint8_t* mapping_;
+  shm::RingHeader* ring_;
+  std::size_t next_slot_;
+  std::size_t write_slot_;
+  std::uint64_t next_sequence_;
+  std::uint64_t num_dropped_frames_;
+};
+
+class ShmPointCloudLease
+{
+public:
+  ShmPointCloudLease();
+  ~ShmPointCloudLease();
+  ShmPointCloudLease(ShmPointCloudLease&& other) noexcept;
+  ShmPointCloudLease& operator=(ShmPointCloudLease&& other) noexcept;
+  ShmPointCloudLease(const ShmPointCloudLease&) = delete;
+  ShmPointCloudLease& operator=(const ShmPointCloudLease&) = delete;
+
+  // False if no frame was leased
+  explicit operator bool() const
+  {
+    return slot_ != nullptr;
+  }
+  std::uint64_t sequence() const
+  {
+    return sequence_;
+  }
+  const ShmPointCloudMetadata& metadata() const;
+  const std::uint8_t* data() const
+  {
+    return data_;
+  }
+  // True if the frame has not been overwritten, and the writer has not reclaimed the lease. This can only happen if
+  // the lease has expired. Check this after reading the data if the processing may take longer than the lease
+  // duration.
+  bool isValid() const;
+  // Give up the lease. Called automatically on destruction.
+  void release();
+
+private:
+  friend class ShmPointCloudReader;
+  ShmPointCloudLease(std::shared_ptr<const shm::Mapping> mapping, shm::SlotHeader* slot, std::uint32_t epoch,
+                     std::uint64_t sequence);
+
+  // Keeps the segment mapped while the lease exists, even if the reader has switched to a new segment
+  std::shared_ptr<const shm::Mapping> mapping_;
+  shm::SlotHeader* slot_;
+  const std::uint8_t* data_;
+  std::uint32_t epoch_;
+  std::uint64_t sequence_;
+};
+
+class ShmPointCloudReader
+{
+public:
+  // Maps the shared-memory segment `name` created by the driver. Throws if it does not exist.
+  explicit ShmPointCloudReader(std::string name,
+                               std::chrono::milliseconds lease_duration = std::chrono::milliseconds{ 5000 });
+  ~ShmPointCloudReader();
+  ShmPointCloudReader(const ShmPointCloudReader&) = delete;
+  ShmPointCloudReader& operator=(const ShmPointCloudReader&) = delete;
+
+  // Lease the latest frame, if its sequence number is larger than `after`. Returns an empty lease otherwise.
+  ShmPointCloudLease acquireLatest(std::uint64_t after = 0);
+
+private:
+  std::string name_;
+  std::chrono::milliseconds lease_duration_;
+  std::shared_ptr<const shm::Mapping> mapping_;
+};
+}  // namespace zivid_camera
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <Zivid/Settings.h>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <vector>
+
+// Cache of the settings suggested by the Capture Assistant. Suggesting settings takes several seconds of camera time,
+// while the suggestion for a scene rarely changes, so the suggestions are reused until they are older than the time
+// to live, or are cleared. The scene tag is given by the client, and separates suggestions for different scenes with
+// the same Capture Assistant parameters.
+
+namespace zivid_camera
+{
+struct SuggestedSettingsKey
+{
+  std::chrono::milliseconds max_capture_time;
+  std::uint8_t ambient_light_frequency;
+  std::string scene_tag;
+
+  bool operator<(const SuggestedSettingsKey& other) const
+  {
+    return std::tie(max_capture_time, ambient_light_frequency, scene_tag) <
+           std::tie(other.max_capture_time, other.ambient_light_frequency, other.scene_tag);
+  }
+};
+
+// Thread safe, so that it can be used from several service calls at the same time
+class SuggestedSettingsCache
+{
+public:
+  explicit SuggestedSettingsCache(std::chrono::nanoseconds time_to_live);
+
+  // The cached suggestion, if it is younger than the time to live
+  std::optional<std::vector<Zivid::Settings>> get(const SuggestedSettingsKey& key,
+                                                  std::chrono::steady_clock::time_point now);
+  // Also removes the suggestions that have expired
+  void put(const SuggestedSettingsKey& key, const std::vector<Zivid::Settings>& settings,
+           std::chrono::steady_clock::time_point now);
+  // Remove the suggestions with the given scene tag, or all suggestions if scene_tag is not set. Returns the number of
+  // removed suggestions.
+  std::size_t clear(const std::optional<std::string>& scene_tag);
+
+  std::size_t numEntries();
+  std::uint64_t numHits();
+  std::uint64_t numMisses();
+
+private:
+  struct Entry
+  {
+    std::vector<Zivid::Settings> settings;
+    std::chrono::steady_clock::time_point time;
+  };
+
+  bool hasExpired(const Entry& entry, std::chrono::steady_clock::time_point now) const;
+
+  std::chrono::nanoseconds time_to_live_;
+  std::mutex mutex_;
+  std::map<SuggestedSettingsKey, Entry> entries_;
+  std::uint64_t num_hits_;
+  std::uint64_t num_misses_;
+};
+}  // namespace zivid_camera
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "camera_backend.h"
+#include "capture_rate_limiter.h"
+#include "thread_pool.h"
+
+#include <cstdint>
+
+namespace zivid_camera
+{
+// Backend that generates organized point clouds without a camera. The clouds show a wavy surface about 1 m in front of
+// the camera, with a configurable resolution, ratio of missing (NaN) points and capture rate. This is intended for
+// load-testing and benchmarking the ROS side of the driver.
+class SyntheticCameraBackend : public CameraBackend
+{
+public:
+  struct Parameters
+  {
+    std::size_t width;
+    std::size_t height;
+    // Ratio of points in each capture that are NaN, in the range [0, 1]
+    double nan_ratio;
+    // Maximum number of captures per second. If 0 the captures are returned as fast as they can be generated.
+    double frame_rate;
+  };
+
+  // The clouds are generated on thread_pool, which must outlive the backend
+  SyntheticCameraBackend(const Parameters& parameters, ThreadPool& thread_pool);
+
+  std::string modelName() override;
+  std::string serialNumber() override;
+  bool isConnected() override;
+  bool reconnectIfAvailable() override;
+  Zivid::Settings settings() override;
+  Zivid::CameraIntrinsics intrinsics() override;
+  CapturedFrame capture(const std::vector<Zivid::Settings>& settings) override;
+  Zivid::Image<Zivid::RGBA8> capture2D(const Zivid::Settings2D& settings) override;
+  std::vector<Zivid::Settings>
+  suggestSettings(const Zivid::CaptureAssistant::SuggestSettingsParameters& parameters) override;
+
+private:
+  Parameters parameters_;
+  ThreadPool& thread_pool_;
+  double fx_;
+  double fy_;
+  double cx_;
+  double cy_;
+  std::uint64_t frame_index_;
+  CaptureRateLimiter rate_limiter_;
+};
+}  // namespace zivid_camera
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Persistent work-stealing thread pool for the data-parallel conversion and processing stages. The threads are started
+// once and reused for every capture, so the number of threads used by the driver is fixed and configurable, instead of
+// depending on how many threads each parallel region starts.
+//
+// parallelFor splits a range in chunks that are distributed over the queues of the worker threads. Each worker takes
+// chunks from the front of its own queue, and steals from the back of the other queues when its own queue is empty, so
+// uneven chunks are balanced between the threads. The calling thread also runs chunks while it waits, so parallelFor
+// may be called from several threads at the same time, and from inside a chunk.
+
+namespace zivid_camera
+{
+class ThreadPool
+{
+public:
+  // num_threads is the total number of threads that run chunks, including the calling thread. If 0, one thread per
+  // hardware thread is used. Each range is split in up to num_threads * chunks_per_thread chunks; more chunks balance
+  // the load better, fewer chunks have less overhead. Throws std::runtime_error if chunks_per_thread is 0.
+  ThreadPool(std::size_t num_threads, std::size_t chunks_per_thread);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  std::size_t numThreads() const
+  {
+    return workers_.size() + 1;
+  }
+  std::size_t chunksPerThread() const
+  {
+    return chunks_per_thread_;
+  }
+
+  // Native handles of the worker threads, e.g. to set their CPU affinity. Does not include the calling threads.
+  std::vector<std::thread::native_handle_type> workerHandles();
+
+  // The longest time from queueing work until an idle worker thread woke up to run it, since the previous call. This
+  // is the scheduling latency of the worker threads.
+  std::chrono::nanoseconds takeMaxWakeupLatency();
+
+  // Call fn(i) for each i in [begin, end), and return when all calls have completed. If a call throws, the first
+  // exception is re-thrown after the remaining chunks have completed.
+  template <typename Fn>
+  void parallelFor(std::size_t begin, std::size_t end, Fn&& fn)
+  {
+    parallelForChunks(begin, end, [&fn](std::size_t, std::size_t chunk_begin, std::size_t chunk_end) {
+      for (std::size_t i = chunk_begin; i < chunk_end; i++)
+      {
+        fn(i);
+      }
+    });
+  }
+
+  // Number of chunks that parallelForChunks splits a range of `size` elements in
+  std::size_t numChunks(std::size_t size) const
+  {
+    return std::min(size, numThreads() * chunks_per_thread_);
+  }
+
+  // Call fn(chunk, chunk_begin, chunk_end) for each of the numChunks(end - begin) chunks of [begin, end). Used for
+  // reductions, where each chunk accumulates into its own element of a vector that is merged afterwards.
+  template <typename Fn>
+  void parallelForChunks(std::size_t begin, std::size_t end, Fn&& fn)
+  {
+    if (end <= begin)
+    {
+      return;
+    }
+    const auto size = end - begin;
+    const auto num_chunks = numChunks(size);
+    run(num_chunks, [&](std::size_t chunk) {
+      // Spread the remainder over the first chunks, so that the chunk sizes differ by at most one
+      const auto chunk_begin = begin + chunk * (size / num_chunks) + std::min(chunk, size % num_chunks);
+      const auto chunk_end = chunk_begin + size / num_chunks + (chunk < size % num_chunks ? 1 : 0);
+      fn(chunk, chunk_begin, chunk_end);
+    });
+  }
+
+private:
+  struct Batch;
+
+  struct Task
+  {
+    Batch* batch;
+    std::size_t chunk;
+  };
+
+  struct TaskQueue
+  {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  void run(std::size_t num_chunks, const std::function<void(std::size_t)>& chunk_fn);
+  bool tryRunTask(std::size_t first_queue, bool take_from_front);
+  void workerThread(std::size_t index);
+
+  std::size_t chunks_per_thread_;
+  std::vector<std::unique_ptr<TaskQueue>> queues_;
+  std::atomic<std::size_t> num_queued_tasks_;
+  std::atomic<std::size_t> next_queue_;
+  std::atomic<std::chrono::steady_clock::rep> last_notify_time_;
+  std::atomic<std::chrono::nanoseconds::rep> max_wakeup_latency_;
+  std::mutex wake_mutex_;
+  std::condition_variable task_available_;
+  bool stop_;
+  std::vector<std::thread> workers_;
+};
+}  // namespace zivid_camera
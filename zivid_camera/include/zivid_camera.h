@@ -1,20 +1,50 @@
 #pragma once
 
 #include "auto_generated_include_wrapper.h"
+#include "camera_backend.h"
+#include "capture_coalescer.h"
+#include "capture_recorder.h"
+#include "capture_scheduler.h"
+#include "image_rectification.h"
+#include "point_cloud_decimation.h"
+#include "point_cloud_processor_chain.h"
+#include "point_cloud_statistics.h"
+#include "point_transform.h"
+#include "realtime.h"
+#include "shm_point_cloud_transport.h"
+#include "suggested_settings_cache.h"
+#include "thread_pool.h"
+#include "zivid_image_message.h"
 
 #include <sensor_msgs/PointCloud2.h>
 #include <sensor_msgs/Image.h>
 
 #include <image_transport/image_transport.h>
 
+#include <actionlib/server/action_server.h>
+
+#include <pluginlib/class_loader.h>
+
 #include <dynamic_reconfigure/server.h>
 
+#include <diagnostic_updater/diagnostic_updater.h>
+
+#include <tf2_ros/buffer.h>
+#include <tf2_ros/transform_listener.h>
+
+#include <ros/callback_queue.h>
 #include <ros/ros.h>
 
-#include <Zivid/Application.h>
-#include <Zivid/Camera.h>
 #include <Zivid/Image.h>
 
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <thread>
+
 namespace Zivid
 {
 class Settings;
@@ -33,8 +63,11 @@ class ZividCamera
 {
 public:
   ZividCamera(ros::NodeHandle& nh, ros::NodeHandle& priv);
+  ~ZividCamera();
 
 private:
+  using CaptureGoalHandle = actionlib::ServerGoalHandle<CaptureAction>;
+
   void onCameraConnectionKeepAliveTimeout(const ros::TimerEvent& event);
   void reconnectToCameraIfNecessary();
   void setCameraStatus(CameraStatus camera_status);
@@ -42,34 +75,134 @@ private:
   bool cameraInfoSerialNumberServiceHandler(CameraInfoSerialNumber::Request& req,
                                             CameraInfoSerialNumber::Response& res);
   bool captureServiceHandler(Capture::Request& req, Capture::Response& res);
-  bool capture2DServiceHandler(Capture::Request& req, Capture::Response& res);
+  bool captureScheduledServiceHandler(CaptureScheduled::Request& req, CaptureScheduled::Response& res);
+  bool captureWithSettingsServiceHandler(CaptureWithSettings::Request& req, CaptureWithSettings::Response& res);
+  // Capture and publish a 3D capture, scheduled by priority and deadline, and coalesced if enabled
+  void capture(const std::vector<Zivid::Settings>& settings, std::int32_t priority, const ros::Duration& deadline);
+  bool capture2DServiceHandler(Capture2D::Request& req, Capture2D::Response& res);
+  bool capture2DScheduledServiceHandler(Capture2DScheduled::Request& req, Capture2DScheduled::Response& res);
+  // Capture and publish a 2D capture, scheduled by priority and deadline
+  void capture2D(std::int32_t priority, const ros::Duration& deadline);
+  bool captureBothServiceHandler(CaptureBoth::Request& req, CaptureBoth::Response& res);
+  void captureBoth(const std::vector<Zivid::Settings>& settings, const Zivid::Settings2D& settings2D);
+  // Accept the goal and queue it on capture_callback_queue_, where it is executed by executeCaptureGoal
+  void onCaptureGoal(CaptureGoalHandle goal);
+  void onCaptureGoalCancel(CaptureGoalHandle goal);
+  void executeCaptureGoal(CaptureGoalHandle goal, const std::atomic<bool>& cancelled);
+  // The settings of the active preset, or the settings of the capture/general and enabled capture/frame_<n> configs
+  std::vector<Zivid::Settings> captureSettings();
+  std::vector<Zivid::Settings> captureSettings(const CaptureGeneralConfig& general_config,
+                                               const std::vector<CaptureFrameConfig>& frame_configs);
+  Zivid::Settings2D capture2DSettings();
+  // Capture on the camera with the capture thread scheduling, and record the capture latency. Must be called from a
+  // job of capture_scheduler_.
+  CapturedFrame captureFrame(const std::vector<Zivid::Settings>& settings);
+  Zivid::Image<Zivid::RGBA8> captureImage2D(const Zivid::Settings2D& settings2D);
   bool captureAssistantSuggestSettingsServiceHandler(CaptureAssistantSuggestSettings::Request& req,
                                                      CaptureAssistantSuggestSettings::Response& res);
+  bool captureAssistantSuggestSettingsCachedServiceHandler(CaptureAssistantSuggestSettingsCached::Request& req,
+                                                           CaptureAssistantSuggestSettingsCached::Response& res);
+  // Configure the settings suggested by the Capture Assistant. Returns true if the settings were taken from the cache.
+  bool suggestSettings(const ros::Duration& max_capture_time_duration, std::uint8_t ambient_light_frequency_value,
+                       const std::string& scene_tag, bool refresh);
+  bool clearSuggestedSettingsCacheServiceHandler(ClearSuggestedSettingsCache::Request& req,
+                                                 ClearSuggestedSettingsCache::Response& res);
   void serviceHandlerHandleCameraConnectionLoss();
   bool isConnectedServiceHandler(IsConnected::Request& req, IsConnected::Response& res);
-  void publishFrame(Zivid::Frame&& frame);
+  bool selectPresetServiceHandler(SelectPreset::Request& req, SelectPreset::Response& res);
+  bool savePresetServiceHandler(SavePreset::Request& req, SavePreset::Response& res);
+  void loadPresets();
+  // Set the capture/general config and enable the given capture/frame_<n> configs, disabling the remaining frames
+  void setCaptureConfigs(const CaptureGeneralConfig& general_config,
+                         const std::vector<CaptureFrameConfig>& frame_configs);
+  // Stop using the active preset, because the capture configs have been changed by other means
+  void deactivatePreset(const std::string& reason);
+  void presetDRUpdateThread();
+  void streamingThread();
+  void streaming2DCaptureThread();
+  void streaming2DPublishThread();
+  void streaming2DDiagnostics(diagnostic_updater::DiagnosticStatusWrapper& status);
+  void advertiseLazyLatchedTopics();
+  // Publish the capture with the given header, or a new header. If publish_color is false the color image is not
+  // published, e.g. because the color image of the capture comes from a 2D capture.
+  void publishFrame(CapturedFrame&& captured_frame, const std::optional<std_msgs::Header>& header = std::nullopt,
+                    bool publish_color = true);
+  void updateCaptureMemoryStatistics();
+  void captureMemoryDiagnostics(diagnostic_updater::DiagnosticStatusWrapper& status);
+  void latencyDiagnostics(diagnostic_updater::DiagnosticStatusWrapper& status);
+  void captureCoalescingDiagnostics(diagnostic_updater::DiagnosticStatusWrapper& status);
+  void captureSchedulerDiagnostics(diagnostic_updater::DiagnosticStatusWrapper& status);
+  void suggestedSettingsCacheDiagnostics(diagnostic_updater::DiagnosticStatusWrapper& status);
+  // Advertise a service that is called on capture_callback_queue_
+  template <typename Service>
+  ros::ServiceServer advertiseCaptureService(const std::string& name,
+                                             bool (ZividCamera::*handler)(typename Service::Request&,
+                                                                          typename Service::Response&));
+  void loadProcessors();
+  void processingDiagnostics(diagnostic_updater::DiagnosticStatusWrapper& status);
+  void publishColorImage2D(const std_msgs::Header& header, const Zivid::Image<Zivid::RGBA8>& image,
+                           const Zivid::CameraIntrinsics& intrinsics);
+  void onPointsSubscriberConnect(const ros::SingleSubscriberPublisher& publisher);
+  void onCompressedPointsSubscriberConnect(const ros::SingleSubscriberPublisher& publisher);
+  void onColorImageSubscriberConnect(const image_transport::SingleSubscriberPublisher& publisher);
+  void onDepthImageSubscriberConnect(const image_transport::SingleSubscriberPublisher& publisher);
+  void onColorCameraInfoSubscriberConnect(const ros::SingleSubscriberPublisher& publisher);
+  void onDepthCameraInfoSubscriberConnect(const ros::SingleSubscriberPublisher& publisher);
+  void publishLatestCameraInfo(sensor_msgs::CameraInfoConstPtr& camera_info,
+                               const ros::SingleSubscriberPublisher& publisher);
+  // The point clouds of the previews are skipped if points_transform is empty
+  void publishPreviews(const std_msgs::Header& header, const std_msgs::Header& points_header,
+                       const std::optional<PointTransform>& points_transform, const Zivid::PointCloud& point_cloud);
+  void recordFrame(const std_msgs::Header& header, std::shared_ptr<const CapturedFrame> frame);
+  void recorderDiagnostics(diagnostic_updater::DiagnosticStatusWrapper& status);
+  void writePointsToSharedMemory(const std_msgs::Header& header, const Zivid::PointCloud& point_cloud,
+                                 const PointTransform& transform);
+  // Returns the transform applied to the point clouds, and sets the frame_id of points_header to target_frame. Returns
+  // an empty optional if the transform to target_frame is not available.
+  std::optional<PointTransform> lookupPointsTransform(std_msgs::Header& points_header);
   bool shouldPublishPoints() const;
+  bool shouldPublishCompressedPoints() const;
+  bool shouldPublishPointsWithNormals() const;
+  bool shouldPublishPointsStatistics() const;
   bool shouldPublishColorImg() const;
   bool shouldPublishDepthImg() const;
-  std_msgs::Header makeHeader();
-  sensor_msgs::PointCloud2ConstPtr makePointCloud2(const std_msgs::Header& header,
-                                                   const Zivid::PointCloud& point_cloud);
+  std_msgs::Header makeHeader(const std::optional<std::chrono::system_clock::time_point>& timestamp = std::nullopt);
+  // If statistics is not null, the statistics of the point cloud are computed while it is converted
+  sensor_msgs::PointCloud2ConstPtr makePointCloud2(const std_msgs::Header& header, const Zivid::PointCloud& point_cloud,
+                                                   const PointTransform& transform,
+                                                   PointCloudStatistics* statistics = nullptr);
+  PointCloudStatsConstPtr makePointCloudStats(const std_msgs::Header& header, const Zivid::PointCloud& point_cloud,
+                                              const PointCloudStatistics& statistics) const;
+  sensor_msgs::PointCloud2ConstPtr makePointCloud2WithNormals(const std_msgs::Header& header,
+                                                              const Zivid::PointCloud& point_cloud,
+                                                              const PointTransform& transform);
+  CompressedPointCloudConstPtr makeCompressedPointCloud(const sensor_msgs::PointCloud2& points) const;
   sensor_msgs::ImageConstPtr makeColorImage(const std_msgs::Header& header, const Zivid::PointCloud& point_cloud);
   sensor_msgs::ImageConstPtr makeColorImage(const std_msgs::Header& header, const Zivid::Image<Zivid::RGBA8>& image);
   sensor_msgs::ImageConstPtr makeDepthImage(const std_msgs::Header& header, const Zivid::PointCloud& point_cloud);
   sensor_msgs::CameraInfoConstPtr makeCameraInfo(const std_msgs::Header& header, std::size_t width, std::size_t height,
-                                                 const Zivid::CameraIntrinsics& intrinsics);
+                                                 const Zivid::CameraIntrinsics& intrinsics,
+                                                 std::size_t decimation_factor = 1);
+  sensor_msgs::ImageConstPtr makeRectifiedImage(const sensor_msgs::Image& image,
+                                                const Zivid::CameraIntrinsics& intrinsics);
 
   template <typename ConfigType_>
   class ConfigDRServer
   {
   public:
     using ConfigType = ConfigType_;
+    // on_reconfigured is called when the config has been changed by a dynamic_reconfigure client
     template <typename ZividSettings>
-    ConfigDRServer(const std::string& name, ros::NodeHandle& nh, const ZividSettings& defaultSettings);
+    ConfigDRServer(const std::string& name, ros::NodeHandle& nh, const ZividSettings& defaultSettings,
+                   std::function<void()> on_reconfigured = nullptr);
     void setConfig(const ConfigType& cfg);
-    const ConfigType& config() const
+    // The current config with the parameters in msg applied. Throws std::runtime_error if msg has parameters that
+    // are not in the config, or values outside the range of the camera.
+    ConfigType configFromMessage(const dynamic_reconfigure::Config& msg) const;
+    // Returns a copy, since the config may be changed by dynamic_reconfigure while it is used by another thread
+    ConfigType config() const
     {
+      boost::recursive_mutex::scoped_lock lock(dr_server_mutex_);
       return config_;
     }
     const std::string& name() const
@@ -79,9 +212,66 @@ private:
 
   private:
     std::string name_;
-    boost::recursive_mutex dr_server_mutex_;
+    mutable boost::recursive_mutex dr_server_mutex_;
     dynamic_reconfigure::Server<ConfigType> dr_server_;
     ConfigType config_;
+    ConfigType config_min_;
+    ConfigType config_max_;
+    std::function<void()> on_reconfigured_;
+  };
+
+  struct PreviewLevel
+  {
+    std::size_t factor;
+    ros::Publisher points_publisher;
+    image_transport::CameraPublisher color_image_publisher;
+    image_transport::CameraPublisher depth_image_publisher;
+    bool hasSubscribers() const;
+  };
+
+  struct CaptureMemoryStatistics
+  {
+    std::uint64_t num_captures;
+    // Resident memory of the process, see ProcessMemoryUsage
+    std::size_t last_peak_bytes;
+    std::size_t last_steady_state_bytes;
+    std::size_t max_peak_bytes;
+  };
+
+  struct Streaming2DStatistics
+  {
+    std::uint64_t num_captured;
+    std::uint64_t num_published;
+    // Images replaced by a newer image before they were published
+    std::uint64_t num_dropped;
+  };
+
+  // The latest capture, and the messages converted from it so far. Used to convert the latched topics lazily.
+  struct LatestCapture
+  {
+    std_msgs::Header header;
+    std::shared_ptr<const CapturedFrame> frame;
+    // The header and transform of the point clouds, which may be published in the target frame. The transform is
+    // empty if it could not be looked up, and then the point clouds of this capture are not published.
+    std_msgs::Header points_header;
+    std::optional<PointTransform> points_transform;
+    sensor_msgs::PointCloud2ConstPtr points;
+    CompressedPointCloudConstPtr compressed_points;
+    sensor_msgs::ImageConstPtr color_image;
+    sensor_msgs::ImageConstPtr depth_image;
+    sensor_msgs::CameraInfoConstPtr color_camera_info;
+    sensor_msgs::CameraInfoConstPtr depth_camera_info;
+    // The intrinsics at the time of the capture, for the camera_info of the lazily converted images
+    std::optional<Zivid::CameraIntrinsics> intrinsics;
+  };
+
+  struct CapturePreset
+  {
+    std::string name;
+    CaptureGeneralConfig general_config;
+    std::vector<CaptureFrameConfig> frame_configs;
+    // Built once when the preset is loaded or saved, so that selecting the preset does not convert any configs
+    std::vector<Zivid::Settings> settings;
   };
 
   using CaptureGeneralConfigDRServer = ConfigDRServer<CaptureGeneralConfig>;
@@ -91,26 +281,120 @@ private:
   ros::NodeHandle nh_;
   ros::NodeHandle priv_;
   ros::Timer camera_connection_keepalive_timer_;
-  CameraStatus camera_status_;
+  diagnostic_updater::Updater diagnostic_updater_;
+  ros::Timer diagnostics_timer_;
+  std::atomic<CameraStatus> camera_status_;
   std::unique_ptr<CaptureGeneralConfigDRServer> capture_general_config_dr_server_;
   bool use_latched_publisher_for_points_;
   bool use_latched_publisher_for_color_image_;
   bool use_latched_publisher_for_depth_image_;
+  bool lazy_latched_conversion_;
+  std::mutex latest_capture_mutex_;
+  LatestCapture latest_capture_;
+  bool shm_transport_enabled_;
+  std::string shm_transport_name_;
+  int shm_transport_num_slots_;
+  mode_t shm_transport_permissions_;
+  std::unique_ptr<ShmPointCloudWriter> shm_writer_;
+  double points_compressed_resolution_;
+  int points_compressed_rows_per_band_;
+  int points_with_normals_neighbor_distance_;
+  PointCloudStatisticsParameters points_stats_parameters_;
   ros::Publisher points_publisher_;
+  ros::Publisher compressed_points_publisher_;
+  ros::Publisher points_with_normals_publisher_;
+  ros::Publisher points_stats_publisher_;
   image_transport::ImageTransport image_transport_;
   image_transport::CameraPublisher color_image_publisher_;
   image_transport::CameraPublisher depth_image_publisher_;
+  image_transport::Publisher color_image_rect_publisher_;
+  image_transport::Publisher depth_image_rect_publisher_;
+  std::unique_ptr<RectificationMap> rectification_map_;
+  DepthReduction preview_depth_reduction_;
+  std::vector<PreviewLevel> preview_levels_;
+  std::unique_ptr<CaptureRecorder> recorder_;
   ros::ServiceServer camera_info_serial_number_service_;
   ros::ServiceServer camera_info_model_name_service_;
   ros::ServiceServer capture_service_;
+  ros::ServiceServer capture_scheduled_service_;
+  ros::ServiceServer capture_with_settings_service_;
   ros::ServiceServer capture_2d_service_;
+  ros::ServiceServer capture_2d_scheduled_service_;
+  ros::ServiceServer capture_both_service_;
   ros::ServiceServer capture_assistant_suggest_settings_service_;
+  ros::ServiceServer capture_assistant_suggest_settings_cached_service_;
+  ros::ServiceServer capture_assistant_clear_cache_service_;
   ros::ServiceServer is_connected_service_;
+  ros::ServiceServer select_preset_service_;
+  ros::ServiceServer save_preset_service_;
   std::vector<std::unique_ptr<CaptureFrameConfigDRServer>> capture_frame_config_dr_servers_;
   std::vector<std::unique_ptr<Capture2DFrameConfigDRServer>> capture_2d_frame_config_dr_servers_;
-  Zivid::Application zivid_;
-  Zivid::Camera camera_;
+  // Selecting a preset only swaps active_preset_. The captures use the active preset until the capture configs are
+  // changed via dynamic_reconfigure or the Capture Assistant. The dynamic_reconfigure servers are updated to the
+  // selected preset in the background by preset_dr_update_thread_.
+  std::mutex presets_mutex_;
+  std::map<std::string, std::shared_ptr<const CapturePreset>> presets_;
+  std::shared_ptr<const CapturePreset> active_preset_;
+  std::shared_ptr<const CapturePreset> pending_preset_dr_update_;
+  bool stop_preset_dr_updates_;
+  std::condition_variable preset_dr_update_requested_;
+  // Serializes the updates of the capture configs by the node
+  std::mutex capture_config_update_mutex_;
+  std::thread preset_dr_update_thread_;
+  // Runs the conversion and processing stages. Declared before backend_, which may use it.
+  std::unique_ptr<ThreadPool> thread_pool_;
+  std::unique_ptr<CameraBackend> backend_;
+  // Declared before processor_chain_, since the plugin libraries must stay loaded while the processors exist
+  std::unique_ptr<pluginlib::ClassLoader<PointCloudProcessor>> processor_loader_;
+  PointCloudProcessorChain processor_chain_;
+  // Runs the captures of the capture services and the streaming threads, and the camera reconnects, one at a time, in
+  // priority order
+  CaptureScheduler capture_scheduler_;
+  int streaming_priority_;
+  int capture_assistant_priority_;
+  std::unique_ptr<CaptureCoalescer> capture_coalescer_;
+  std::unique_ptr<SuggestedSettingsCache> suggested_settings_cache_;
+  // The capture services are called on capture_callback_queue_ by capture_spinner_, so that several requests can wait
+  // for the camera at the same time, and be scheduled by priority
+  ros::CallbackQueue capture_callback_queue_;
+  std::unique_ptr<ros::AsyncSpinner> capture_spinner_;
+  // The goals of the capture action are accepted on capture_action_callback_queue_, and executed on
+  // capture_callback_queue_. The cancel flags of the goals that have not finished are kept by goal id.
+  ros::CallbackQueue capture_action_callback_queue_;
+  std::unique_ptr<ros::AsyncSpinner> capture_action_spinner_;
+  std::unique_ptr<actionlib::ActionServer<CaptureAction>> capture_action_server_;
+  std::mutex capture_goals_mutex_;
+  std::map<std::string, std::shared_ptr<std::atomic<bool>>> capture_goals_cancelled_;
+  bool memory_bounded_publishing_;
+  std::mutex capture_memory_statistics_mutex_;
+  CaptureMemoryStatistics capture_memory_statistics_;
+  ThreadScheduling capture_thread_scheduling_;
+  ThreadScheduling publish_thread_scheduling_;
+  double capture_to_publish_deadline_;
+  // Start of the latest 3D capture. Only used from the jobs of capture_scheduler_.
+  std::chrono::steady_clock::time_point capture_start_time_;
+  LatencyStatistics capture_latency_;
+  LatencyStatistics capture_to_publish_latency_;
+  std::atomic<std::uint64_t> num_missed_deadlines_;
+  std::atomic<bool> stop_streaming_;
+  std::thread streaming_thread_;
+  ros::Publisher streaming_2d_image_publisher_;
+  ros::Publisher streaming_2d_camera_info_publisher_;
+  // Hands the latest 2D image over from the capture thread to the publishing thread
+  std::mutex streaming_2d_mutex_;
+  std::condition_variable streaming_2d_image_available_;
+  boost::shared_ptr<ZividImageMessage> streaming_2d_pending_image_;
+  sensor_msgs::CameraInfoConstPtr streaming_2d_pending_camera_info_;
+  Streaming2DStatistics streaming_2d_statistics_;
+  Streaming2DStatistics streaming_2d_last_diagnostics_statistics_;
+  std::chrono::steady_clock::time_point streaming_2d_last_diagnostics_time_;
+  std::thread streaming_2d_capture_thread_;
+  std::thread streaming_2d_publish_thread_;
   std::string frame_id_;
+  std::string target_frame_;
+  double target_frame_timeout_;
+  std::unique_ptr<tf2_ros::Buffer> tf_buffer_;
+  std::unique_ptr<tf2_ros::TransformListener> tf_listener_;
   unsigned int header_seq_;
 };
 }  // namespace zivid_camera
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <sensor_msgs/Image.h>
+#include <sensor_msgs/image_encodings.h>
+#include <std_msgs/Header.h>
+
+#include <ros/message_traits.h>
+#include <ros/serialization.h>
+
+#include <Zivid/Image.h>
+
+#include <boost/shared_ptr.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+
+namespace zivid_camera
+{
+// A message that is published as a sensor_msgs/Image with rgba8 encoding, where the pixels are the buffer of a
+// Zivid::Image. The message keeps the image alive until it has been sent, so the pixels are never copied into a
+// std::vector. It is serialized directly from the Zivid::Image buffer, to exactly the same bytes as the equivalent
+// sensor_msgs::Image, so subscribers use sensor_msgs::Image as usual.
+struct ZividImageMessage
+{
+  std_msgs::Header header;
+  std::shared_ptr<const Zivid::Image<Zivid::RGBA8>> image;
+};
+
+using ZividImageMessagePtr = boost::shared_ptr<ZividImageMessage>;
+using ZividImageMessageConstPtr = boost::shared_ptr<const ZividImageMessage>;
+}  // namespace zivid_camera
+
+namespace ros
+{
+namespace message_traits
+{
+template <>
+struct IsMessage<zivid_camera::ZividImageMessage> : TrueType
+{
+};
+
+template <>
+struct IsMessage<const zivid_camera::ZividImageMessage> : TrueType
+{
+};
+
+template <>
+struct HasHeader<zivid_camera::ZividImageMessage> : TrueType
+{
+};
+
+template <>
+struct MD5Sum<zivid_camera::ZividImageMessage>
+{
+  static const char* value()
+  {
+    return MD5Sum<sensor_msgs::Image>::value();
+  }
+  static const char* value(const zivid_camera::ZividImageMessage&)
+  {
+    return value();
+  }
+};
+
+template <>
+struct DataType<zivid_camera::ZividImageMessage>
+{
+  static const char* value()
+  {
+    return DataType<sensor_msgs::Image>::value();
+  }
+  static const char* value(const zivid_camera::ZividImageMessage&)
+  {
+    return value();
+  }
+};
+
+template <>
+struct Definition<zivid_camera::ZividImageMessage>
+{
+  static const char* value()
+  {
+    return Definition<sensor_msgs::Image>::value();
+  }
+  static const char* value(const zivid_camera::ZividImageMessage&)
+  {
+    return value();
+  }
+};
+}  // namespace message_traits
+
+namespace serialization
+{
+template <>
+struct Serializer<zivid_camera::ZividImageMessage>
+{
+  static constexpr std::uint32_t bytes_per_pixel = sizeof(Zivid::RGBA8);
+
+  template <typename Stream>
+  inline static void write(Stream& stream, const zivid_camera::ZividImageMessage& msg)
+  {
+    const auto& image = *msg.image;
+    stream.next(msg.header);
+    stream.next(static_cast<std::uint32_t>(image.height()));
+    stream.next(static_cast<std::uint32_t>(image.width()));
+    stream.next(std::string(sensor_msgs::image_encodings::RGBA8));
+    stream.next(static_cast<std::uint8_t>(0));
+    stream.next(static_cast<std::uint32_t>(bytes_per_pixel * image.width()));
+    const auto data_size = static_cast<std::uint32_t>(bytes_per_pixel * image.size());
+    stream.next(data_size);
+    if (data_size > 0)
+    {
+      std::memcpy(stream.advance(data_size), image.dataPtr(), data_size);
+    }
+  }
+
+  inline static std::uint32_t serializedLength(const zivid_camera::ZividImageMessage& msg)
+  {
+    // header, height, width, encoding, is_bigendian, step and data (with its length)
+    return serializationLength(msg.header) + 4 + 4 +
+           serializationLength(std::string(sensor_msgs::image_encodings::RGBA8)) + 1 + 4 + 4 +
+           static_cast<std::uint32_t>(bytes_per_pixel * msg.image->size());
+  }
+};
+}  // namespace serialization
+}  // namespace ros
@@ -0,0 +1,92 @@
+#include "capture_coalescer.h"
+
+#include <sstream>
+
+namespace zivid_camera
+{
+CaptureCoalescer::CaptureCoalescer(std::chrono::nanoseconds freshness_window)
+  : freshness_window_(freshness_window), statistics_{}
+{
+}
+
+bool CaptureCoalescer::canJoin(const Acquisition& acquisition, std::chrono::steady_clock::time_point now) const
+{
+  return !acquisition.started || now - acquisition.start_time <= freshness_window_;
+}
+
+void CaptureCoalescer::request(const std::string& key, const RunExclusive& run_exclusive,
+                               const std::function<void()>& acquire)
+{
+  std::shared_ptr<Acquisition> acquisition;
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    statistics_.num_requests++;
+    const auto it = acquisitions_.find(key);
+    if (it != acquisitions_.end() && canJoin(*it->second, std::chrono::steady_clock::now()))
+    {
+      statistics_.num_coalesced++;
+      const auto joined = it->second;
+      acquisition_done_.wait(lock, [&joined]() { return joined->done; });
+      if (joined->error)
+      {
+        std::rethrow_exception(joined->error);
+      }
+      return;
+    }
+    // Replaces an acquisition that is too old to join, which is still running
+    acquisition = std::make_shared<Acquisition>();
+    acquisitions_[key] = acquisition;
+  }
+
+  std::exception_ptr error;
+  try
+  {
+    run_exclusive([&]() {
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        acquisition->started = true;
+        acquisition->start_time = std::chrono::steady_clock::now();
+      }
+      acquire();
+    });
+  }
+  catch (...)
+  {
+    // Also when run_exclusive fails without running the acquisition
+    error = std::current_exception();
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    statistics_.num_acquisitions++;
+    acquisition->done = true;
+    acquisition->error = error;
+    const auto it = acquisitions_.find(key);
+    if (it != acquisitions_.end() && it->second == acquisition)
+    {
+      acquisitions_.erase(it);
+    }
+  }
+  acquisition_done_.notify_all();
+  if (error)
+  {
+    std::rethrow_exception(error);
+  }
+}
+
+CaptureCoalescer::Statistics CaptureCoalescer::statistics() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return statistics_;
+}
+
+std::string captureCoalescingKey(const std::vector<Zivid::Settings>& settings)
+{
+  std::ostringstream key;
+  for (const auto& s : settings)
+  {
+    key << s << '\n';
+  }
+  return key.str();
+}
+}  // namespace zivid_camera
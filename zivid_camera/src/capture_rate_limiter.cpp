@@ -0,0 +1,35 @@
+#include "capture_rate_limiter.h"
+
+#include <stdexcept>
+#include <thread>
+
+namespace zivid_camera
+{
+CaptureRateLimiter::CaptureRateLimiter(double rate) : rate_(rate), next_capture_time_(std::chrono::steady_clock::now())
+{
+  if (rate_ < 0.0)
+  {
+    throw std::runtime_error("The capture rate can not be negative");
+  }
+}
+
+void CaptureRateLimiter::waitForNextCaptureSlot()
+{
+  if (rate_ <= 0.0)
+  {
+    return;
+  }
+  const auto period =
+      std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>{ 1.0 / rate_ });
+  const auto now = std::chrono::steady_clock::now();
+  if (next_capture_time_ > now)
+  {
+    std::this_thread::sleep_until(next_capture_time_);
+    next_capture_time_ += period;
+  }
+  else
+  {
+    next_capture_time_ = now + period;
+  }
+}
+}  // namespace zivid_camera
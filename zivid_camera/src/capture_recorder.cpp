@@ -0,0 +1,335 @@
+#include "capture_recorder.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iomanip>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+
+namespace
+{
+using FilePtr = std::unique_ptr<std::FILE, int (*)(std::FILE*)>;
+
+std::string systemErrorMessage(const std::string& what, const std::string& path)
+{
+  return what + " '" + path + "': " + std::strerror(errno);
+}
+
+FilePtr openFile(const std::string& path)
+{
+  FilePtr file(std::fopen(path.c_str(), "wb"), &std::fclose);
+  if (!file)
+  {
+    throw std::runtime_error(systemErrorMessage("Failed to open", path));
+  }
+  return file;
+}
+
+void writeBytes(std::FILE* file, const void* data, std::size_t size, const std::string& path)
+{
+  if (size > 0 && std::fwrite(data, 1, size, file) != size)
+  {
+    throw std::runtime_error(systemErrorMessage("Failed to write to", path));
+  }
+}
+
+void seek(std::FILE* file, std::uint64_t offset, const std::string& path)
+{
+  if (std::fseek(file, static_cast<long>(offset), SEEK_SET) != 0)
+  {
+    throw std::runtime_error(systemErrorMessage("Failed to seek in", path));
+  }
+}
+
+// Write the capture to a temporary file first, so that readers never see a partially written file
+template <typename WriteFn>
+void writeAtomically(const std::string& path, WriteFn&& write_fn)
+{
+  const auto tmp_path = path + ".tmp";
+  {
+    auto file = openFile(tmp_path);
+    write_fn(file.get(), tmp_path);
+    if (std::fclose(file.release()) != 0)
+    {
+      throw std::runtime_error(systemErrorMessage("Failed to close", tmp_path));
+    }
+  }
+  if (std::rename(tmp_path.c_str(), path.c_str()) != 0)
+  {
+    throw std::runtime_error(systemErrorMessage("Failed to rename", tmp_path));
+  }
+}
+
+// Convert the given rows to the layout of the PointCloud2 messages on the points topic (x, y and z in meters)
+void convertRows(const Zivid::PointCloud& point_cloud, std::size_t first_row, std::size_t num_rows,
+                 std::vector<std::uint8_t>& buffer)
+{
+  const auto num_points = num_rows * point_cloud.width();
+  buffer.resize(num_points * sizeof(Zivid::Point));
+  const Zivid::Point* src = point_cloud.dataPtr() + first_row * point_cloud.width();
+  for (std::size_t i = 0; i < num_points; i++)
+  {
+    Zivid::Point point = src[i];
+    // Convert from mm to m
+    point.x *= 0.001f;
+    point.y *= 0.001f;
+    point.z *= 0.001f;
+    std::memcpy(buffer.data() + i * sizeof(Zivid::Point), &point, sizeof(Zivid::Point));
+  }
+}
+
+std::size_t alignUp(std::size_t value, std::size_t alignment)
+{
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+void writeChunked(const zivid_camera::RecordingMetadata& metadata, const Zivid::PointCloud& point_cloud,
+                  std::size_t rows_per_chunk, std::FILE* file, const std::string& path)
+{
+  const auto width = point_cloud.width();
+  const auto height = point_cloud.height();
+  const auto num_chunks = (height + rows_per_chunk - 1) / rows_per_chunk;
+
+  zivid_camera::RecordingFileHeader header{};
+  std::memcpy(header.magic, zivid_camera::recording_file_magic, sizeof(header.magic));
+  header.version = zivid_camera::recording_file_version;
+  header.width = static_cast<std::uint32_t>(width);
+  header.height = static_cast<std::uint32_t>(height);
+  header.point_step = sizeof(Zivid::Point);
+  header.rows_per_chunk = static_cast<std::uint32_t>(rows_per_chunk);
+  header.num_chunks = static_cast<std::uint32_t>(num_chunks);
+  header.header_seq = metadata.header_seq;
+  header.stamp_sec = metadata.stamp_sec;
+  header.stamp_nsec = metadata.stamp_nsec;
+  metadata.frame_id.copy(header.frame_id, sizeof(header.frame_id) - 1);
+
+  std::vector<zivid_camera::RecordingChunkIndexEntry> index(num_chunks);
+  auto offset = alignUp(sizeof(header) + num_chunks * sizeof(zivid_camera::RecordingChunkIndexEntry),
+                        zivid_camera::recording_chunk_alignment);
+  for (std::size_t c = 0; c < num_chunks; c++)
+  {
+    auto& entry = index[c];
+    entry.first_row = static_cast<std::uint32_t>(c * rows_per_chunk);
+    entry.num_rows = static_cast<std::uint32_t>(std::min(rows_per_chunk, height - c * rows_per_chunk));
+    entry.offset = offset;
+    entry.size = entry.num_rows * width * sizeof(Zivid::Point);
+    offset = alignUp(offset + entry.size, zivid_camera::recording_chunk_alignment);
+  }
+
+  writeBytes(file, &header, sizeof(header), path);
+  writeBytes(file, index.data(), index.size() * sizeof(index[0]), path);
+  std::vector<std::uint8_t> buffer;
+  for (const auto& entry : index)
+  {
+    convertRows(point_cloud, entry.first_row, entry.num_rows, buffer);
+    seek(file, entry.offset, path);
+    writeBytes(file, buffer.data(), buffer.size(), path);
+  }
+}
+
+void writePcd(const Zivid::PointCloud& point_cloud, std::size_t rows_per_chunk, std::FILE* file,
+              const std::string& path)
+{
+  std::ostringstream header;
+  header << "# .PCD v0.7 - Point Cloud Data file format\n"
+         << "VERSION 0.7\n"
+         << "FIELDS x y z c rgb\n"
+         << "SIZE 4 4 4 4 4\n"
+         << "TYPE F F F F F\n"
+         << "COUNT 1 1 1 1 1\n"
+         << "WIDTH " << point_cloud.width() << "\n"
+         << "HEIGHT " << point_cloud.height() << "\n"
+         << "VIEWPOINT 0 0 0 1 0 0 0\n"
+         << "POINTS " << point_cloud.size() << "\n"
+         << "DATA binary\n";
+  const auto header_str = header.str();
+  writeBytes(file, header_str.data(), header_str.size(), path);
+
+  std::vector<std::uint8_t> buffer;
+  for (std::size_t row = 0; row < point_cloud.height(); row += rows_per_chunk)
+  {
+    convertRows(point_cloud, row, std::min(rows_per_chunk, point_cloud.height() - row), buffer);
+    writeBytes(file, buffer.data(), buffer.size(), path);
+  }
+}
+
+std::string fileExtension(zivid_camera::RecordingFormat format)
+{
+  switch (format)
+  {
+    case zivid_camera::RecordingFormat::Zdf:
+      return ".zdf";
+    case zivid_camera::RecordingFormat::Chunked:
+      return ".zpc";
+    case zivid_camera::RecordingFormat::Pcd:
+      return ".pcd";
+  }
+  return "";
+}
+}  // namespace
+
+namespace zivid_camera
+{
+RecordingFormat recordingFormatFromString(const std::string& name)
+{
+  if (name == "zdf")
+  {
+    return RecordingFormat::Zdf;
+  }
+  if (name == "chunked")
+  {
+    return RecordingFormat::Chunked;
+  }
+  if (name == "pcd")
+  {
+    return RecordingFormat::Pcd;
+  }
+  throw std::runtime_error("Unknown recording format '" + name + "'. Supported values are 'zdf', 'chunked' and 'pcd'.");
+}
+
+CaptureRecorder::CaptureRecorder(const Parameters& parameters)
+  : parameters_(parameters), queue_bytes_(0), stop_(false), statistics_{}
+{
+  if (parameters_.num_threads == 0)
+  {
+    throw std::runtime_error("The recorder needs at least 1 writer thread");
+  }
+  if (parameters_.rows_per_chunk == 0)
+  {
+    throw std::runtime_error("The recorder needs at least 1 row per chunk");
+  }
+  if (access(parameters_.directory.c_str(), W_OK) != 0)
+  {
+    throw std::runtime_error(systemErrorMessage("Can not write to recording directory", parameters_.directory));
+  }
+
+  for (std::size_t i = 0; i < parameters_.num_threads; i++)
+  {
+    threads_.emplace_back(&CaptureRecorder::writerThread, this);
+  }
+}
+
+CaptureRecorder::~CaptureRecorder()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  queue_not_empty_.notify_all();
+  for (auto& thread : threads_)
+  {
+    thread.join();
+  }
+}
+
+bool CaptureRecorder::record(const RecordingMetadata& metadata, std::shared_ptr<const CapturedFrame> frame)
+{
+  const auto size = frame->point_cloud.size() * sizeof(Zivid::Point);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (queue_bytes_ + size > parameters_.max_queue_bytes)
+    {
+      statistics_.num_dropped++;
+      return false;
+    }
+    queue_bytes_ += size;
+    queue_.push_back(Job{ metadata, std::move(frame), size });
+  }
+  queue_not_empty_.notify_one();
+  return true;
+}
+
+CaptureRecorder::Statistics CaptureRecorder::statistics() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto statistics = statistics_;
+  statistics.queue_length = queue_.size();
+  statistics.queue_bytes = queue_bytes_;
+  return statistics;
+}
+
+void CaptureRecorder::writerThread()
+{
+  while (true)
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    queue_not_empty_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+    if (queue_.empty())
+    {
+      return;
+    }
+    auto job = std::move(queue_.front());
+    queue_.pop_front();
+    lock.unlock();
+
+    std::string error;
+    try
+    {
+      write(job);
+    }
+    catch (const std::exception& e)
+    {
+      error = e.what();
+    }
+
+    // The memory is only released from the queue budget once the capture has been written (and released)
+    const auto size = job.size;
+    job.frame.reset();
+    lock.lock();
+    queue_bytes_ -= size;
+    if (error.empty())
+    {
+      statistics_.num_recorded++;
+    }
+    else
+    {
+      statistics_.num_failed++;
+      statistics_.last_error = error;
+    }
+  }
+}
+
+void CaptureRecorder::write(const Job& job) const
+{
+  const auto& metadata = job.metadata;
+  auto format = parameters_.format;
+  if (format == RecordingFormat::Zdf && !job.frame->frame)
+  {
+    format = RecordingFormat::Chunked;
+  }
+
+  std::ostringstream file_name;
+  file_name << parameters_.directory << "/" << metadata.stamp_sec << "_" << std::setw(9) << std::setfill('0')
+            << metadata.stamp_nsec << "_" << metadata.header_seq << fileExtension(format);
+  const auto path = file_name.str();
+
+  switch (format)
+  {
+    case RecordingFormat::Zdf:
+    {
+      const auto tmp_path = path + ".tmp.zdf";
+      job.frame->frame->save(tmp_path);
+      if (std::rename(tmp_path.c_str(), path.c_str()) != 0)
+      {
+        throw std::runtime_error(systemErrorMessage("Failed to rename", tmp_path));
+      }
+      break;
+    }
+    case RecordingFormat::Chunked:
+      writeAtomically(path, [&](std::FILE* file, const std::string& file_path) {
+        writeChunked(metadata, job.frame->point_cloud, parameters_.rows_per_chunk, file, file_path);
+      });
+      break;
+    case RecordingFormat::Pcd:
+      writeAtomically(path, [&](std::FILE* file, const std::string& file_path) {
+        writePcd(job.frame->point_cloud, parameters_.rows_per_chunk, file, file_path);
+      });
+      break;
+  }
+}
+}  // namespace zivid_camera
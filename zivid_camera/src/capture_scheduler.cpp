@@ -0,0 +1,138 @@
+#include "capture_scheduler.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+namespace zivid_camera
+{
+CaptureScheduler::CaptureScheduler()
+  : busy_(false), next_sequence_(0)
+{
+}
+
+bool CaptureScheduler::runsBefore(const Ticket& a, const Ticket& b)
+{
+  if (a.request.priority != b.request.priority)
+  {
+    return a.request.priority > b.request.priority;
+  }
+  if (a.request.deadline.has_value() != b.request.deadline.has_value())
+  {
+    return a.request.deadline.has_value();
+  }
+  if (a.request.deadline && *a.request.deadline != *b.request.deadline)
+  {
+    return *a.request.deadline < *b.request.deadline;
+  }
+  return a.sequence < b.sequence;
+}
+
+bool CaptureScheduler::isNext(const Ticket& ticket) const
+{
+  return !busy_ && std::none_of(waiting_.begin(), waiting_.end(),
+                                [&ticket](const Ticket* other) { return runsBefore(*other, ticket); });
+}
+
+CaptureScheduler::PriorityStatistics& CaptureScheduler::statistics(int priority)
+{
+  // Value-initialized the first time a priority is requested
+  return statistics_.try_emplace(priority).first->second;
+}
+
+void CaptureScheduler::run(const Request& request, const std::function<void()>& job)
+{
+  schedule(request, job, nullptr);
+}
+
+void CaptureScheduler::run(const Request& request, const std::function<void()>& job,
+                           const std::atomic<bool>& cancelled)
+{
+  schedule(request, job, &cancelled);
+}
+
+void CaptureScheduler::notifyCancelled()
+{
+  // Locked, so that a request can not miss the notification between checking its flag and starting to wait
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+  }
+  turn_changed_.notify_all();
+}
+
+void CaptureScheduler::schedule(const Request& request, const std::function<void()>& job,
+                                const std::atomic<bool>* cancelled)
+{
+  const auto request_time = std::chrono::steady_clock::now();
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    const Ticket ticket{ request, next_sequence_++ };
+    waiting_.push_back(&ticket);
+    const auto is_cancelled = [cancelled]() { return cancelled && *cancelled; };
+    const auto is_next_or_cancelled = [this, &ticket, &is_cancelled]() { return is_cancelled() || isNext(ticket); };
+    bool before_deadline = true;
+    if (request.deadline)
+    {
+      before_deadline = turn_changed_.wait_until(lock, *request.deadline, is_next_or_cancelled);
+    }
+    else
+    {
+      turn_changed_.wait(lock, is_next_or_cancelled);
+    }
+    waiting_.erase(std::find(waiting_.begin(), waiting_.end(), &ticket));
+    if (!before_deadline || is_cancelled())
+    {
+      if (!before_deadline)
+      {
+        statistics(request.priority).num_expired++;
+      }
+      // The jobs behind this one may be next now
+      lock.unlock();
+      turn_changed_.notify_all();
+      throw std::runtime_error(before_deadline ? "The capture was cancelled before it started" :
+                                         "The capture did not start before its deadline (priority " +
+                                             std::to_string(request.priority) + ")");
+    }
+    busy_ = true;
+    statistics(request.priority).wait.add(std::chrono::steady_clock::now() - request_time);
+  }
+
+  const auto finish = [this]() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      busy_ = false;
+    }
+    turn_changed_.notify_all();
+  };
+  try
+  {
+    job();
+  }
+  catch (...)
+  {
+    finish();
+    throw;
+  }
+  finish();
+}
+
+std::size_t CaptureScheduler::numWaiting()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return waiting_.size();
+}
+
+std::vector<CaptureScheduler::WaitStatistics> CaptureScheduler::takeWaitStatistics()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<WaitStatistics> result;
+  result.reserve(statistics_.size());
+  for (auto& [priority, priority_statistics] : statistics_)
+  {
+    result.push_back(
+        WaitStatistics{ priority, priority_statistics.wait.takeWindow(), priority_statistics.num_expired });
+    priority_statistics.num_expired = 0;
+  }
+  return result;
+}
+}  // namespace zivid_camera
@@ -0,0 +1,61 @@
+#include "point_cloud_processor.h"
+
+#include <ros/ros.h>
+#include <pluginlib/class_list_macros.h>
+
+#include <limits>
+#include <stdexcept>
+
+// Example PointCloudProcessor, which removes the points with a contrast below min_contrast. Low contrast points are
+// typically noise from dark or specular surfaces, or from multiple reflections.
+
+namespace zivid_camera
+{
+class ContrastFilter : public PointCloudProcessor
+{
+public:
+  ContrastFilter()
+    : min_contrast_(0.0f)
+  {
+  }
+
+  void initialize(const std::string& name, ros::NodeHandle& nh) override
+  {
+    double min_contrast;
+    nh.param<double>("min_contrast", min_contrast, 0.0);
+    if (min_contrast < 0.0)
+    {
+      throw std::runtime_error("min_contrast of processor '" + name + "' can not be negative");
+    }
+    min_contrast_ = static_cast<float>(min_contrast);
+  }
+
+  void process(Zivid::PointCloud& point_cloud, ThreadPool& thread_pool) override
+  {
+    Zivid::Point* points = point_cloud.dataPtr();
+    const float min_contrast = min_contrast_;
+    thread_pool.parallelFor(0, point_cloud.size(), [points, min_contrast](std::size_t i) {
+      auto& point = points[i];
+      // Written as !(>=) so that points with NaN contrast are removed too
+      if (!(point.contrast >= min_contrast))
+      {
+        point.x = point.y = point.z = std::numeric_limits<float>::quiet_NaN();
+      }
+    });
+  }
+
+private:
+  float min_contrast_;
+};
+}  // namespace zivid_camera
+
+#ifdef __clang__
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wglobal-constructors"
+#endif
+
+PLUGINLIB_EXPORT_CLASS(zivid_camera::ContrastFilter, zivid_camera::PointCloudProcessor)
+
+#ifdef __clang__
+#pragma clang diagnostic pop
+#endif
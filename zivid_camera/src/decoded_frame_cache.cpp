@@ -0,0 +1,65 @@
+#include "decoded_frame_cache.h"
+
+#include <algorithm>
+#include <sstream>
+
+namespace zivid_camera
+{
+DecodedFrameCache::DecodedFrameCache(std::size_t max_bytes, ThreadPool& thread_pool)
+  : max_bytes_(max_bytes), thread_pool_(thread_pool), size_bytes_(0), num_hits_(0), num_misses_(0)
+{
+}
+
+Zivid::PointCloud DecodedFrameCache::copyPointCloud(const Zivid::PointCloud& point_cloud)
+{
+  Zivid::PointCloud copy(point_cloud.width(), point_cloud.height());
+  const auto* src = point_cloud.dataPtr();
+  auto* dst = copy.dataPtr();
+  thread_pool_.parallelForChunks(0, point_cloud.size(), [&](std::size_t, std::size_t begin, std::size_t end) {
+    std::copy(src + begin, src + end, dst + begin);
+  });
+  return copy;
+}
+
+std::optional<CapturedFrame> DecodedFrameCache::get(const std::string& key)
+{
+  const auto it = index_.find(key);
+  if (it == index_.end())
+  {
+    num_misses_++;
+    return std::nullopt;
+  }
+  num_hits_++;
+  entries_.splice(entries_.begin(), entries_, it->second);
+  return CapturedFrame{ copyPointCloud(it->second->point_cloud), std::nullopt, it->second->timestamp };
+}
+
+void DecodedFrameCache::put(const std::string& key, const CapturedFrame& frame)
+{
+  const auto size = frame.point_cloud.size() * sizeof(Zivid::Point);
+  if (size > max_bytes_ || index_.count(key) > 0)
+  {
+    return;
+  }
+  while (size_bytes_ + size > max_bytes_)
+  {
+    size_bytes_ -= entries_.back().size;
+    index_.erase(entries_.back().key);
+    entries_.pop_back();
+  }
+  entries_.push_front(Entry{ key, copyPointCloud(frame.point_cloud), frame.timestamp, size });
+  index_.emplace(key, entries_.begin());
+  size_bytes_ += size;
+}
+
+std::string decodedFrameCacheKey(const std::string& file_path, const std::vector<Zivid::Settings>& settings)
+{
+  std::ostringstream key;
+  key << file_path;
+  for (const auto& s : settings)
+  {
+    key << '\n' << s;
+  }
+  return key.str();
+}
+}  // namespace zivid_camera
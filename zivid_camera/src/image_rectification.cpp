@@ -0,0 +1,122 @@
+#include "image_rectification.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace
+{
+constexpr std::size_t tile_size = 32;
+}  // namespace
+
+namespace zivid_camera
+{
+bool operator==(const PinholeCameraModel& lhs, const PinholeCameraModel& rhs)
+{
+  return lhs.fx == rhs.fx && lhs.fy == rhs.fy && lhs.cx == rhs.cx && lhs.cy == rhs.cy && lhs.k1 == rhs.k1 &&
+         lhs.k2 == rhs.k2 && lhs.p1 == rhs.p1 && lhs.p2 == rhs.p2 && lhs.k3 == rhs.k3;
+}
+
+RectificationMap::RectificationMap(const PinholeCameraModel& model, std::size_t width, std::size_t height)
+  : model_(model), width_(width), height_(height), entries_(width * height)
+{
+  if (model.fx <= 0.0 || model.fy <= 0.0)
+  {
+    throw std::runtime_error("The focal lengths of the camera must be positive");
+  }
+
+  const auto max_x = static_cast<double>(width) - 1.0;
+  const auto max_y = static_cast<double>(height) - 1.0;
+  for (std::size_t v = 0; v < height; v++)
+  {
+    for (std::size_t u = 0; u < width; u++)
+    {
+      // Project the rectified pixel to the normalized image plane, and distort it with the plumb_bob model
+      const double x = (static_cast<double>(u) - model.cx) / model.fx;
+      const double y = (static_cast<double>(v) - model.cy) / model.fy;
+      const double r2 = x * x + y * y;
+      const double radial = 1.0 + model.k1 * r2 + model.k2 * r2 * r2 + model.k3 * r2 * r2 * r2;
+      const double xd = x * radial + 2.0 * model.p1 * x * y + model.p2 * (r2 + 2.0 * x * x);
+      const double yd = y * radial + model.p1 * (r2 + 2.0 * y * y) + 2.0 * model.p2 * x * y;
+      const double src_x = model.fx * xd + model.cx;
+      const double src_y = model.fy * yd + model.cy;
+
+      auto& entry = entries_[v * width + u];
+      if (!(src_x >= 0.0 && src_x <= max_x && src_y >= 0.0 && src_y <= max_y))
+      {
+        entry = Entry{ -1, -1, 0.0f, 0.0f };
+        continue;
+      }
+      const double x0 = std::floor(src_x);
+      const double y0 = std::floor(src_y);
+      entry = Entry{ static_cast<std::int32_t>(x0), static_cast<std::int32_t>(y0), static_cast<float>(src_x - x0),
+                     static_cast<float>(src_y - y0) };
+    }
+  }
+}
+
+template <typename Fn>
+void RectificationMap::forEachTile(ThreadPool& thread_pool, Fn&& fn) const
+{
+  const auto tiles_x = (width_ + tile_size - 1) / tile_size;
+  const auto tiles_y = (height_ + tile_size - 1) / tile_size;
+
+  thread_pool.parallelFor(0, tiles_x * tiles_y, [&](std::size_t tile) {
+    const auto x_begin = (tile % tiles_x) * tile_size;
+    const auto y_begin = (tile / tiles_x) * tile_size;
+    const auto x_end = std::min(x_begin + tile_size, width_);
+    const auto y_end = std::min(y_begin + tile_size, height_);
+    for (std::size_t y = y_begin; y < y_end; y++)
+    {
+      for (std::size_t x = x_begin; x < x_end; x++)
+      {
+        fn(y * width_ + x);
+      }
+    }
+  });
+}
+
+void RectificationMap::remapBilinear(const std::uint8_t* src, std::size_t channels, std::uint8_t* dst,
+                                     ThreadPool& thread_pool) const
+{
+  forEachTile(thread_pool, [&](std::size_t i) {
+    const auto& entry = entries_[i];
+    std::uint8_t* out = dst + i * channels;
+    if (entry.x0 < 0)
+    {
+      std::fill(out, out + channels, std::uint8_t{ 0 });
+      return;
+    }
+    const auto x0 = static_cast<std::size_t>(entry.x0);
+    const auto y0 = static_cast<std::size_t>(entry.y0);
+    const auto x1 = std::min(x0 + 1, width_ - 1);
+    const auto y1 = std::min(y0 + 1, height_ - 1);
+    const std::uint8_t* p00 = src + (y0 * width_ + x0) * channels;
+    const std::uint8_t* p01 = src + (y0 * width_ + x1) * channels;
+    const std::uint8_t* p10 = src + (y1 * width_ + x0) * channels;
+    const std::uint8_t* p11 = src + (y1 * width_ + x1) * channels;
+    for (std::size_t c = 0; c < channels; c++)
+    {
+      const float top = static_cast<float>(p00[c]) + entry.wx * static_cast<float>(p01[c] - p00[c]);
+      const float bottom = static_cast<float>(p10[c]) + entry.wx * static_cast<float>(p11[c] - p10[c]);
+      out[c] = static_cast<std::uint8_t>(top + entry.wy * (bottom - top) + 0.5f);
+    }
+  });
+}
+
+void RectificationMap::remapNearest(const float* src, float* dst, ThreadPool& thread_pool) const
+{
+  forEachTile(thread_pool, [&](std::size_t i) {
+    const auto& entry = entries_[i];
+    if (entry.x0 < 0)
+    {
+      dst[i] = std::numeric_limits<float>::quiet_NaN();
+      return;
+    }
+    const auto x = static_cast<std::size_t>(entry.x0) + (entry.wx >= 0.5f ? 1U : 0U);
+    const auto y = static_cast<std::size_t>(entry.y0) + (entry.wy >= 0.5f ? 1U : 0U);
+    dst[i] = src[y * width_ + x];
+  });
+}
+}  // namespace zivid_camera
@@ -0,0 +1,171 @@
+#include "playback_camera_backend.h"
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include <ros/console.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <optional>
+#include <stdexcept>
+
+namespace
+{
+bool isDirectory(const std::string& path)
+{
+  struct stat st
+  {
+  };
+  return stat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+bool hasZdfExtension(const std::string& name)
+{
+  const std::string extension = ".zdf";
+  return name.size() > extension.size() &&
+         name.compare(name.size() - extension.size(), extension.size(), extension) == 0;
+}
+}  // namespace
+
+namespace zivid_camera
+{
+std::vector<std::string> playbackFilesFromPath(const std::string& path)
+{
+  if (!isDirectory(path))
+  {
+    return { path };
+  }
+
+  DIR* dir = opendir(path.c_str());
+  if (dir == nullptr)
+  {
+    throw std::runtime_error("Failed to open playback directory '" + path + "': " + std::strerror(errno));
+  }
+  std::vector<std::string> files;
+  while (const auto* entry = readdir(dir))
+  {
+    if (hasZdfExtension(entry->d_name))
+    {
+      files.push_back(path + "/" + entry->d_name);
+    }
+  }
+  closedir(dir);
+  std::sort(files.begin(), files.end());
+  if (files.empty())
+  {
+    throw std::runtime_error("No .zdf files found in playback directory '" + path + "'");
+  }
+  return files;
+}
+
+PlaybackCameraBackend::PlaybackCameraBackend(const Parameters& parameters)
+  : parameters_(parameters), rate_limiter_(parameters.rate), next_index_(0)
+{
+  if (parameters_.files.empty())
+  {
+    throw std::runtime_error("The playback camera needs at least 1 file");
+  }
+  ROS_INFO("Creating playback camera with %zu files", parameters_.files.size());
+  camera_ = zivid_.createFileCamera(parameters_.files.front());
+  startLoading(0);
+}
+
+PlaybackCameraBackend::~PlaybackCameraBackend()
+{
+  if (next_frame_.valid())
+  {
+    next_frame_.wait();
+  }
+}
+
+std::string PlaybackCameraBackend::modelName()
+{
+  return "PlaybackCamera";
+}
+
+std::string PlaybackCameraBackend::serialNumber()
+{
+  return "playback";
+}
+
+bool PlaybackCameraBackend::isConnected()
+{
+  return true;
+}
+
+bool PlaybackCameraBackend::reconnectIfAvailable()
+{
+  return true;
+}
+
+Zivid::Settings PlaybackCameraBackend::settings()
+{
+  return camera_.settings();
+}
+
+Zivid::CameraIntrinsics PlaybackCameraBackend::intrinsics()
+{
+  return camera_.intrinsics();
+}
+
+CapturedFrame PlaybackCameraBackend::capture(const std::vector<Zivid::Settings>&)
+{
+  if (!next_frame_.valid())
+  {
+    throw std::runtime_error("Playback finished, all " + std::to_string(parameters_.files.size()) +
+                             " files have been played back");
+  }
+  rate_limiter_.waitForNextCaptureSlot();
+
+  const auto& path = parameters_.files[next_index_];
+  ROS_DEBUG("Playing back '%s'", path.c_str());
+  // The next file is loaded even if this one fails, so that a broken file is skipped instead of ending the playback
+  std::optional<Zivid::Frame> frame;
+  try
+  {
+    frame = next_frame_.get();
+  }
+  catch (const std::exception& e)
+  {
+    startLoadingAfter(next_index_);
+    throw std::runtime_error("Failed to load playback file '" + path + "': " + e.what());
+  }
+  startLoadingAfter(next_index_);
+
+  auto point_cloud = frame->getPointCloud();
+  std::optional<std::chrono::system_clock::time_point> timestamp;
+  if (parameters_.use_recorded_timestamps)
+  {
+    timestamp = frame->info().timeStamp().value();
+  }
+  return CapturedFrame{ std::move(point_cloud), std::move(*frame), timestamp };
+}
+
+Zivid::Image<Zivid::RGBA8> PlaybackCameraBackend::capture2D(const Zivid::Settings2D&)
+{
+  throw std::runtime_error("2D capture is not supported by the playback camera backend");
+}
+
+std::vector<Zivid::Settings>
+PlaybackCameraBackend::suggestSettings(const Zivid::CaptureAssistant::SuggestSettingsParameters&)
+{
+  return { camera_.settings() };
+}
+
+void PlaybackCameraBackend::startLoadingAfter(std::size_t index)
+{
+  const auto next = index + 1;
+  if (next < parameters_.files.size() || parameters_.loop)
+  {
+    startLoading(next % parameters_.files.size());
+  }
+}
+
+void PlaybackCameraBackend::startLoading(std::size_t index)
+{
+  next_index_ = index;
+  next_frame_ = std::async(std::launch::async, [path = parameters_.files[index]] { return Zivid::Frame(path); });
+}
+}  // namespace zivid_camera
@@ -0,0 +1,434 @@
+#include "point_cloud_codec.h"
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+constexpr std::size_t num_coordinates = 3;
+constexpr std::size_t contrast_offset = 12;
+constexpr std::size_t rgba_offset = 16;
+constexpr std::size_t num_color_channels = 4;
+
+// Order of the residual streams in a band
+enum Stream : std::size_t
+{
+  mask_stream = 0,
+  x_stream,
+  y_stream,
+  z_stream,
+  contrast_stream,
+  color_stream,
+  num_streams = color_stream + num_color_channels
+};
+
+std::uint32_t loadBits(const std::uint8_t* ptr)
+{
+  std::uint32_t bits;
+  std::memcpy(&bits, ptr, sizeof(bits));
+  return bits;
+}
+
+void storeBits(std::uint8_t* ptr, std::uint32_t bits)
+{
+  std::memcpy(ptr, &bits, sizeof(bits));
+}
+
+float loadFloat(const std::uint8_t* ptr)
+{
+  float value;
+  std::memcpy(&value, ptr, sizeof(value));
+  return value;
+}
+
+void storeFloat(std::uint8_t* ptr, float value)
+{
+  std::memcpy(ptr, &value, sizeof(value));
+}
+
+std::uint64_t zigZagEncode(std::int64_t value)
+{
+  return (static_cast<std::uint64_t>(value) << 1U) ^ static_cast<std::uint64_t>(value >> 63);
+}
+
+std::int64_t zigZagDecode(std::uint64_t value)
+{
+  return static_cast<std::int64_t>(value >> 1U) ^ -static_cast<std::int64_t>(value & 1U);
+}
+
+void writeVarint(std::vector<std::uint8_t>& stream, std::uint64_t value)
+{
+  while (value >= 0x80U)
+  {
+    stream.push_back(static_cast<std::uint8_t>(value | 0x80U));
+    value >>= 7U;
+  }
+  stream.push_back(static_cast<std::uint8_t>(value));
+}
+
+void writeUint32(std::vector<std::uint8_t>& buffer, std::uint32_t value)
+{
+  const auto offset = buffer.size();
+  buffer.resize(offset + sizeof(value));
+  std::memcpy(&buffer[offset], &value, sizeof(value));
+}
+
+class StreamReader
+{
+public:
+  StreamReader(const std::uint8_t* begin, const std::uint8_t* end) : ptr_(begin), end_(end)
+  {
+  }
+
+  std::uint64_t readVarint()
+  {
+    std::uint64_t value = 0;
+    for (unsigned int shift = 0; shift < 64; shift += 7)
+    {
+      const auto byte = readByte();
+      value |= static_cast<std::uint64_t>(byte & 0x7FU) << shift;
+      if ((byte & 0x80U) == 0)
+      {
+        return value;
+      }
+    }
+    throw std::runtime_error("Corrupt point cloud data: varint too long");
+  }
+
+  std::uint8_t readByte()
+  {
+    if (ptr_ == end_)
+    {
+      throw std::runtime_error("Corrupt point cloud data: stream ended unexpectedly");
+    }
+    return *ptr_++;
+  }
+
+  std::uint32_t readUint32()
+  {
+    if (end_ - ptr_ < static_cast<std::ptrdiff_t>(sizeof(std::uint32_t)))
+    {
+      throw std::runtime_error("Corrupt point cloud data: stream ended unexpectedly");
+    }
+    std::uint32_t value;
+    std::memcpy(&value, ptr_, sizeof(value));
+    ptr_ += sizeof(value);
+    return value;
+  }
+
+  StreamReader subStream(std::size_t size)
+  {
+    if (static_cast<std::size_t>(end_ - ptr_) < size)
+    {
+      throw std::runtime_error("Corrupt point cloud data: stream ended unexpectedly");
+    }
+    StreamReader sub(ptr_, ptr_ + size);
+    ptr_ += size;
+    return sub;
+  }
+
+private:
+  const std::uint8_t* ptr_;
+  const std::uint8_t* end_;
+};
+
+// Index of the pixel that is used to predict the pixel at (row, col) within a band, or -1 if there is none
+std::ptrdiff_t predictorIndex(std::size_t band_row, std::size_t col, std::size_t index, std::size_t width)
+{
+  if (band_row > 0)
+  {
+    return static_cast<std::ptrdiff_t>(index - width);
+  }
+  if (col > 0)
+  {
+    return static_cast<std::ptrdiff_t>(index - 1);
+  }
+  return -1;
+}
+
+// Index of the pixel that is used to predict the quantized coordinates of the pixel at (row, col) within a band. This
+// is the pixel above, or the pixel to the left if the one above is missing. Returns -1 if there is none.
+std::ptrdiff_t quantizedPredictorIndex(const std::vector<std::uint8_t>& valid, std::size_t band_row, std::size_t col,
+                                       std::size_t index, std::size_t width)
+{
+  if (band_row > 0 && valid[index - width])
+  {
+    return static_cast<std::ptrdiff_t>(index - width);
+  }
+  if (col > 0 && valid[index - 1])
+  {
+    return static_cast<std::ptrdiff_t>(index - 1);
+  }
+  return -1;
+}
+
+std::vector<std::uint8_t> encodeBand(const std::uint8_t* points, std::size_t width, std::size_t first_row,
+                                     std::size_t num_rows, float resolution)
+{
+  const bool quantize = resolution > 0.0f;
+  const auto num_points = width * num_rows;
+  const std::uint8_t* band = points + first_row * width * zivid_camera::point_cloud_codec_point_step;
+
+  std::array<std::vector<std::uint8_t>, num_streams> streams;
+  for (std::size_t c = 0; c < num_color_channels; c++)
+  {
+    streams[color_stream + c].resize(num_points);
+  }
+
+  std::vector<std::int64_t> quantized;
+  std::vector<std::uint8_t> valid;
+  if (quantize)
+  {
+    streams[mask_stream].resize((num_points + 7) / 8, 0);
+    quantized.resize(num_coordinates * num_points);
+    valid.resize(num_points);
+  }
+
+  for (std::size_t band_row = 0; band_row < num_rows; band_row++)
+  {
+    for (std::size_t col = 0; col < width; col++)
+    {
+      const auto i = band_row * width + col;
+      const std::uint8_t* point = band + i * zivid_camera::point_cloud_codec_point_step;
+      const auto predictor = predictorIndex(band_row, col, i, width);
+      const std::uint8_t* predictor_point =
+          predictor < 0 ? nullptr :
+                          band + static_cast<std::size_t>(predictor) * zivid_camera::point_cloud_codec_point_step;
+
+      if (quantize)
+      {
+        const bool is_valid = !std::isnan(loadFloat(point)) && !std::isnan(loadFloat(point + 4)) &&
+                              !std::isnan(loadFloat(point + 8));
+        valid[i] = is_valid;
+        if (is_valid)
+        {
+          streams[mask_stream][i / 8] |= static_cast<std::uint8_t>(1U << (i % 8));
+          const auto q_predictor = quantizedPredictorIndex(valid, band_row, col, i, width);
+          for (std::size_t k = 0; k < num_coordinates; k++)
+          {
+            auto* plane = &quantized[k * num_points];
+            plane[i] = std::llround(static_cast<double>(loadFloat(point + 4 * k)) / resolution);
+            const auto prediction = q_predictor < 0 ? 0 : plane[q_predictor];
+            writeVarint(streams[x_stream + k], zigZagEncode(plane[i] - prediction));
+          }
+        }
+      }
+      else
+      {
+        for (std::size_t k = 0; k < num_coordinates; k++)
+        {
+          const auto bits = loadBits(point + 4 * k);
+          const auto prediction = predictor_point == nullptr ? 0U : loadBits(predictor_point + 4 * k);
+          writeVarint(streams[x_stream + k], bits ^ prediction);
+        }
+      }
+
+      const auto contrast_bits = loadBits(point + contrast_offset);
+      const auto contrast_prediction = predictor_point == nullptr ? 0U : loadBits(predictor_point + contrast_offset);
+      writeVarint(streams[contrast_stream], contrast_bits ^ contrast_prediction);
+
+      for (std::size_t c = 0; c < num_color_channels; c++)
+      {
+        const auto prediction = predictor_point == nullptr ? 0U : predictor_point[rgba_offset + c];
+        streams[color_stream + c][i] = static_cast<std::uint8_t>(point[rgba_offset + c] - prediction);
+      }
+    }
+  }
+
+  std::vector<std::uint8_t> raw;
+  for (const auto& stream : streams)
+  {
+    writeUint32(raw, static_cast<std::uint32_t>(stream.size()));
+    raw.insert(raw.end(), stream.begin(), stream.end());
+  }
+
+  std::vector<std::uint8_t> compressed;
+  writeUint32(compressed, static_cast<std::uint32_t>(raw.size()));
+  auto compressed_size = compressBound(static_cast<uLong>(raw.size()));
+  compressed.resize(sizeof(std::uint32_t) + compressed_size);
+  if (compress2(&compressed[sizeof(std::uint32_t)], &compressed_size, raw.data(), static_cast<uLong>(raw.size()),
+                Z_BEST_SPEED) != Z_OK)
+  {
+    throw std::runtime_error("Failed to compress point cloud band");
+  }
+  compressed.resize(sizeof(std::uint32_t) + compressed_size);
+  return compressed;
+}
+
+std::vector<std::uint8_t> inflateBand(const std::uint8_t* begin, const std::uint8_t* end)
+{
+  StreamReader reader(begin, end);
+  const auto raw_size = reader.readUint32();
+  std::vector<std::uint8_t> raw(raw_size);
+  const auto header_size = static_cast<std::ptrdiff_t>(sizeof(std::uint32_t));
+  auto decompressed_size = static_cast<uLongf>(raw_size);
+  if (uncompress(raw.data(), &decompressed_size, begin + header_size, static_cast<uLong>(end - begin - header_size)) !=
+          Z_OK ||
+      decompressed_size != raw_size)
+  {
+    throw std::runtime_error("Corrupt point cloud data: failed to decompress band");
+  }
+  return raw;
+}
+
+void decodeBand(const std::uint8_t* begin, const std::uint8_t* end, std::uint8_t* points, std::size_t width,
+                std::size_t first_row, std::size_t num_rows, float resolution)
+{
+  const bool quantize = resolution > 0.0f;
+  const auto num_points = width * num_rows;
+  std::uint8_t* band = points + first_row * width * zivid_camera::point_cloud_codec_point_step;
+
+  const auto raw = inflateBand(begin, end);
+  StreamReader reader(raw.data(), raw.data() + raw.size());
+  std::vector<StreamReader> streams;
+  streams.reserve(num_streams);
+  for (std::size_t s = 0; s < num_streams; s++)
+  {
+    const auto size = reader.readUint32();
+    streams.push_back(reader.subStream(size));
+  }
+
+  std::vector<std::uint8_t> mask;
+  std::vector<std::int64_t> quantized;
+  std::vector<std::uint8_t> valid;
+  if (quantize)
+  {
+    mask.resize((num_points + 7) / 8);
+    for (auto& byte : mask)
+    {
+      byte = streams[mask_stream].readByte();
+    }
+    quantized.resize(num_coordinates * num_points);
+    valid.resize(num_points);
+  }
+
+  for (std::size_t band_row = 0; band_row < num_rows; band_row++)
+  {
+    for (std::size_t col = 0; col < width; col++)
+    {
+      const auto i = band_row * width + col;
+      std::uint8_t* point = band + i * zivid_camera::point_cloud_codec_point_step;
+      const auto predictor = predictorIndex(band_row, col, i, width);
+      const std::uint8_t* predictor_point =
+          predictor < 0 ? nullptr :
+                          band + static_cast<std::size_t>(predictor) * zivid_camera::point_cloud_codec_point_step;
+
+      if (quantize)
+      {
+        const bool is_valid = (mask[i / 8] >> (i % 8)) & 1U;
+        valid[i] = is_valid;
+        if (is_valid)
+        {
+          const auto q_predictor = quantizedPredictorIndex(valid, band_row, col, i, width);
+          for (std::size_t k = 0; k < num_coordinates; k++)
+          {
+            auto* plane = &quantized[k * num_points];
+            const auto prediction = q_predictor < 0 ? 0 : plane[q_predictor];
+            plane[i] = prediction + zigZagDecode(streams[x_stream + k].readVarint());
+            storeFloat(point + 4 * k, static_cast<float>(static_cast<double>(plane[i]) * resolution));
+          }
+        }
+        else
+        {
+          for (std::size_t k = 0; k < num_coordinates; k++)
+          {
+            storeFloat(point + 4 * k, std::numeric_limits<float>::quiet_NaN());
+          }
+        }
+      }
+      else
+      {
+        for (std::size_t k = 0; k < num_coordinates; k++)
+        {
+          const auto prediction = predictor_point == nullptr ? 0U : loadBits(predictor_point + 4 * k);
+          storeBits(point + 4 * k, static_cast<std::uint32_t>(streams[x_stream + k].readVarint()) ^ prediction);
+        }
+      }
+
+      const auto contrast_prediction = predictor_point == nullptr ? 0U : loadBits(predictor_point + contrast_offset);
+      storeBits(point + contrast_offset,
+                static_cast<std::uint32_t>(streams[contrast_stream].readVarint()) ^ contrast_prediction);
+
+      for (std::size_t c = 0; c < num_color_channels; c++)
+      {
+        const auto prediction = predictor_point == nullptr ? 0U : predictor_point[rgba_offset + c];
+        point[rgba_offset + c] = static_cast<std::uint8_t>(streams[color_stream + c].readByte() + prediction);
+      }
+    }
+  }
+}
+
+std::size_t numBands(std::size_t height, std::size_t rows_per_band)
+{
+  if (rows_per_band == 0)
+  {
+    throw std::runtime_error("rows_per_band must be larger than 0");
+  }
+  return (height + rows_per_band - 1) / rows_per_band;
+}
+}  // namespace
+
+namespace zivid_camera
+{
+EncodedPointCloud encodePointCloud(const std::uint8_t* points, std::size_t width, std::size_t height,
+                                   float resolution, std::size_t rows_per_band, ThreadPool& thread_pool)
+{
+  const auto num_bands = numBands(height, rows_per_band);
+  std::vector<std::vector<std::uint8_t>> bands(num_bands);
+
+  thread_pool.parallelFor(0, num_bands, [&](std::size_t b) {
+    const auto first_row = b * rows_per_band;
+    const auto num_rows = std::min(rows_per_band, height - first_row);
+    bands[b] = encodeBand(points, width, first_row, num_rows, resolution);
+  });
+
+  EncodedPointCloud encoded;
+  encoded.band_offsets.reserve(num_bands);
+  std::size_t total_size = 0;
+  for (const auto& band : bands)
+  {
+    encoded.band_offsets.push_back(static_cast<std::uint32_t>(total_size));
+    total_size += band.size();
+  }
+  encoded.data.reserve(total_size);
+  for (const auto& band : bands)
+  {
+    encoded.data.insert(encoded.data.end(), band.begin(), band.end());
+  }
+  return encoded;
+}
+
+void decodePointCloud(const EncodedPointCloud& encoded, std::size_t width, std::size_t height, float resolution,
+                      std::size_t rows_per_band, std::uint8_t* points, ThreadPool& thread_pool)
+{
+  const auto num_bands = numBands(height, rows_per_band);
+  if (encoded.band_offsets.size() != num_bands)
+  {
+    throw std::runtime_error("Corrupt point cloud data: expected " + std::to_string(num_bands) + " bands, got " +
+                             std::to_string(encoded.band_offsets.size()));
+  }
+  for (std::size_t b = 0; b < num_bands; b++)
+  {
+    const std::size_t band_end = b + 1 < num_bands ? encoded.band_offsets[b + 1] : encoded.data.size();
+    if (encoded.band_offsets[b] > band_end || band_end > encoded.data.size())
+    {
+      throw std::runtime_error("Corrupt point cloud data: invalid band offsets");
+    }
+  }
+
+  thread_pool.parallelFor(0, num_bands, [&](std::size_t b) {
+    const auto first_row = b * rows_per_band;
+    const auto num_rows = std::min(rows_per_band, height - first_row);
+    const std::size_t band_end = b + 1 < num_bands ? encoded.band_offsets[b + 1] : encoded.data.size();
+    decodeBand(encoded.data.data() + encoded.band_offsets[b], encoded.data.data() + band_end, points, width, first_row,
+               num_rows, resolution);
+  });
+}
+}  // namespace zivid_camera
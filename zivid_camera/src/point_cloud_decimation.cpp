@@ -0,0 +1,106 @@
+#include "point_cloud_decimation.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace zivid_camera
+{
+DepthReduction depthReductionFromString(const std::string& name)
+{
+  if (name == "min")
+  {
+    return DepthReduction::Min;
+  }
+  if (name == "median")
+  {
+    return DepthReduction::Median;
+  }
+  throw std::runtime_error("Unknown depth reduction '" + name + "'. Supported values are 'min' and 'median'.");
+}
+
+Zivid::PointCloud decimatePointCloud(const Zivid::PointCloud& point_cloud, std::size_t factor,
+                                     DepthReduction reduction, ThreadPool& thread_pool)
+{
+  if (factor == 0)
+  {
+    throw std::runtime_error("The decimation factor must be larger than 0");
+  }
+  const auto src_width = point_cloud.width();
+  const auto width = src_width / factor;
+  const auto height = point_cloud.height() / factor;
+  const Zivid::Point* src = point_cloud.dataPtr();
+
+  Zivid::PointCloud decimated(width, height);
+  Zivid::Point* dst = decimated.dataPtr();
+
+  thread_pool.parallelFor(0, height, [&](std::size_t row) {
+    // (z, index) of the valid points in the current block
+    std::vector<std::pair<float, std::size_t>> valid_points;
+    valid_points.reserve(factor * factor);
+
+    for (std::size_t col = 0; col < width; col++)
+    {
+      valid_points.clear();
+      std::array<std::uint32_t, 4> color_sum{};
+      for (std::size_t block_row = 0; block_row < factor; block_row++)
+      {
+        const auto row_begin = (row * factor + block_row) * src_width + col * factor;
+        for (std::size_t i = row_begin; i < row_begin + factor; i++)
+        {
+          if (!std::isnan(src[i].z))
+          {
+            valid_points.emplace_back(src[i].z, i);
+          }
+          // Average each byte of the packed color independently, which works for any channel order
+          for (std::size_t c = 0; c < color_sum.size(); c++)
+          {
+            color_sum[c] += (src[i].rgba >> (8U * c)) & 0xFFU;
+          }
+        }
+      }
+
+      auto& point = dst[row * width + col];
+      if (valid_points.empty())
+      {
+        point.x = std::numeric_limits<float>::quiet_NaN();
+        point.y = std::numeric_limits<float>::quiet_NaN();
+        point.z = std::numeric_limits<float>::quiet_NaN();
+        point.contrast = 0.0f;
+      }
+      else
+      {
+        auto selected = valid_points.begin();
+        if (reduction == DepthReduction::Median)
+        {
+          selected += static_cast<std::ptrdiff_t>((valid_points.size() - 1) / 2);
+          std::nth_element(valid_points.begin(), selected, valid_points.end());
+        }
+        else
+        {
+          selected = std::min_element(valid_points.begin(), valid_points.end());
+        }
+        const auto& selected_point = src[selected->second];
+        point.x = selected_point.x;
+        point.y = selected_point.y;
+        point.z = selected_point.z;
+        point.contrast = selected_point.contrast;
+      }
+
+      const auto num_points = static_cast<std::uint32_t>(factor * factor);
+      std::uint32_t rgba = 0;
+      for (std::size_t c = 0; c < color_sum.size(); c++)
+      {
+        rgba |= ((color_sum[c] + num_points / 2) / num_points) << (8U * c);
+      }
+      point.rgba = rgba;
+    }
+  });
+  return decimated;
+}
+}  // namespace zivid_camera
@@ -0,0 +1,112 @@
+#include "point_cloud_normals.h"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace
+{
+struct Vector3
+{
+  float x;
+  float y;
+  float z;
+};
+
+bool isValid(const Zivid::Point& point)
+{
+  return !std::isnan(point.z);
+}
+
+Vector3 difference(const Zivid::Point& a, const Zivid::Point& b)
+{
+  return Vector3{ a.x - b.x, a.y - b.y, a.z - b.z };
+}
+
+// Tangent through src[i] along a line of `length` points with the given stride, using central differences if
+// possible. Returns false if both neighbors are missing.
+bool tangent(const Zivid::Point* src, std::size_t i, std::size_t position, std::size_t length, std::size_t distance,
+             std::size_t stride, Vector3& result)
+{
+  const bool has_previous = position >= distance && isValid(src[i - distance * stride]);
+  const bool has_next = position + distance < length && isValid(src[i + distance * stride]);
+  if (has_previous && has_next)
+  {
+    result = difference(src[i + distance * stride], src[i - distance * stride]);
+  }
+  else if (has_next)
+  {
+    result = difference(src[i + distance * stride], src[i]);
+  }
+  else if (has_previous)
+  {
+    result = difference(src[i], src[i - distance * stride]);
+  }
+  else
+  {
+    return false;
+  }
+  return true;
+}
+
+Vector3 normal(const Zivid::Point* src, std::size_t i, std::size_t row, std::size_t col, std::size_t width,
+               std::size_t height, std::size_t distance)
+{
+  constexpr float nan = std::numeric_limits<float>::quiet_NaN();
+  Vector3 horizontal;
+  Vector3 vertical;
+  if (!isValid(src[i]) || !tangent(src, i, col, width, distance, 1, horizontal) ||
+      !tangent(src, i, row, height, distance, width, vertical))
+  {
+    return Vector3{ nan, nan, nan };
+  }
+
+  const Vector3 n{ horizontal.y * vertical.z - horizontal.z * vertical.y,
+                   horizontal.z * vertical.x - horizontal.x * vertical.z,
+                   horizontal.x * vertical.y - horizontal.y * vertical.x };
+  const float length = std::sqrt(n.x * n.x + n.y * n.y + n.z * n.z);
+  if (length == 0.0f)
+  {
+    return Vector3{ nan, nan, nan };
+  }
+  // The camera is at the origin, so the normal points towards the camera when it points away from the point
+  const auto& point = src[i];
+  const float sign = (n.x * point.x + n.y * point.y + n.z * point.z) > 0.0f ? -1.0f : 1.0f;
+  const float scale = sign / length;
+  return Vector3{ n.x * scale, n.y * scale, n.z * scale };
+}
+}  // namespace
+
+namespace zivid_camera
+{
+void copyPointsWithNormalsInMeters(const Zivid::PointCloud& point_cloud, std::size_t neighbor_distance,
+                                   const PointTransform& transform, std::uint8_t* dst, ThreadPool& thread_pool)
+{
+  if (neighbor_distance == 0)
+  {
+    throw std::runtime_error("The normal neighbor distance must be larger than 0");
+  }
+  static_assert(sizeof(Zivid::Point) + sizeof(Vector3) == point_with_normal_step, "Unexpected point layout");
+
+  const auto width = point_cloud.width();
+  const auto height = point_cloud.height();
+  const Zivid::Point* src = point_cloud.dataPtr();
+
+  // The normals are computed from the points in mm in the camera frame, and then rotated
+  thread_pool.parallelFor(0, height, [&](std::size_t row) {
+    for (std::size_t col = 0; col < width; col++)
+    {
+      const auto i = row * width + col;
+      Zivid::Point point = src[i];
+      transform.applyToPoint(point);
+      auto n = normal(src, i, row, col, width, height, neighbor_distance);
+      const auto rotated = transform.applyToDirection({ n.x, n.y, n.z });
+      const float scale = 1.0f / std::sqrt(rotated[0] * rotated[0] + rotated[1] * rotated[1] + rotated[2] * rotated[2]);
+      n = Vector3{ rotated[0] * scale, rotated[1] * scale, rotated[2] * scale };
+      std::memcpy(dst + i * point_with_normal_step, &point, sizeof(Zivid::Point));
+      std::memcpy(dst + i * point_with_normal_step + sizeof(Zivid::Point), &n, sizeof(n));
+    }
+  });
+}
+}  // namespace zivid_camera
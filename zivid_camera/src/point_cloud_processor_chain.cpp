@@ -0,0 +1,41 @@
+#include "point_cloud_processor_chain.h"
+
+#include <stdexcept>
+
+namespace zivid_camera
+{
+void PointCloudProcessorChain::add(const std::string& name, std::shared_ptr<PointCloudProcessor> processor)
+{
+  if (!processor)
+  {
+    throw std::runtime_error("Point cloud processor '" + name + "' is null");
+  }
+  stages_.push_back(Stage{ name, std::move(processor), std::make_unique<LatencyStatistics>() });
+}
+
+bool PointCloudProcessorChain::empty() const
+{
+  return stages_.empty();
+}
+
+void PointCloudProcessorChain::process(Zivid::PointCloud& point_cloud, ThreadPool& thread_pool)
+{
+  for (auto& stage : stages_)
+  {
+    const auto start = std::chrono::steady_clock::now();
+    stage.processor->process(point_cloud, thread_pool);
+    stage.latency->add(std::chrono::steady_clock::now() - start);
+  }
+}
+
+std::vector<PointCloudProcessorChain::Timing> PointCloudProcessorChain::takeTimings()
+{
+  std::vector<Timing> timings;
+  timings.reserve(stages_.size());
+  for (auto& stage : stages_)
+  {
+    timings.push_back(Timing{ stage.name, stage.latency->takeWindow(), stage.latency->maxOverall() });
+  }
+  return timings;
+}
+}  // namespace zivid_camera
@@ -0,0 +1,120 @@
+#include "point_cloud_statistics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace
+{
+// Partial statistics of one chunk of the points
+struct Accumulator
+{
+  explicit Accumulator(std::size_t z_histogram_bins)
+    : num_valid_points(0)
+    , min{ std::numeric_limits<float>::infinity(), std::numeric_limits<float>::infinity(),
+           std::numeric_limits<float>::infinity() }
+    , max{ -std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity(),
+           -std::numeric_limits<float>::infinity() }
+    , sum{}
+    , contrast_sum(0.0)
+    , z_histogram(z_histogram_bins, 0)
+  {
+  }
+
+  std::size_t num_valid_points;
+  std::array<float, 3> min;
+  std::array<float, 3> max;
+  // Summed in double, so that the mean of millions of points does not lose precision
+  std::array<double, 3> sum;
+  double contrast_sum;
+  std::vector<std::uint32_t> z_histogram;
+};
+}  // namespace
+
+namespace zivid_camera
+{
+PointCloudStatistics transformPointsWithStatistics(const Zivid::PointCloud& point_cloud,
+                                                   const PointTransform& transform,
+                                                   const PointCloudStatisticsParameters& parameters, std::uint8_t* dst,
+                                                   ThreadPool& thread_pool)
+{
+  if (parameters.z_histogram_bins == 0 || !(parameters.z_histogram_max > parameters.z_histogram_min))
+  {
+    throw std::runtime_error("The z histogram must have at least one bin and a maximum larger than the minimum");
+  }
+
+  const Zivid::Point* src = point_cloud.dataPtr();
+  const auto num_bins = parameters.z_histogram_bins;
+  const auto histogram_min = parameters.z_histogram_min;
+  const auto bins_per_meter = static_cast<float>(num_bins) / (parameters.z_histogram_max - histogram_min);
+
+  std::vector<Accumulator> accumulators(thread_pool.numChunks(point_cloud.size()), Accumulator(num_bins));
+  thread_pool.parallelForChunks(0, point_cloud.size(), [&](std::size_t chunk, std::size_t begin, std::size_t end) {
+    auto& accumulator = accumulators[chunk];
+    for (std::size_t i = begin; i < end; i++)
+    {
+      Zivid::Point point = src[i];
+      transform.applyToPoint(point);
+      if (dst)
+      {
+        std::memcpy(dst + i * sizeof(Zivid::Point), &point, sizeof(Zivid::Point));
+      }
+      if (std::isnan(point.x) || std::isnan(point.y) || std::isnan(point.z))
+      {
+        continue;
+      }
+
+      accumulator.num_valid_points++;
+      const std::array<float, 3> xyz{ point.x, point.y, point.z };
+      for (std::size_t k = 0; k < 3; k++)
+      {
+        accumulator.min[k] = std::min(accumulator.min[k], xyz[k]);
+        accumulator.max[k] = std::max(accumulator.max[k], xyz[k]);
+        accumulator.sum[k] += xyz[k];
+      }
+      accumulator.contrast_sum += point.contrast;
+      const float bin = (point.z - histogram_min) * bins_per_meter;
+      if (bin >= 0.0f && bin < static_cast<float>(num_bins))
+      {
+        accumulator.z_histogram[static_cast<std::size_t>(bin)]++;
+      }
+    }
+  });
+
+  // Merged in chunk order, so that the result does not depend on which thread processed which chunk
+  Accumulator total(num_bins);
+  for (const auto& accumulator : accumulators)
+  {
+    total.num_valid_points += accumulator.num_valid_points;
+    for (std::size_t k = 0; k < 3; k++)
+    {
+      total.min[k] = std::min(total.min[k], accumulator.min[k]);
+      total.max[k] = std::max(total.max[k], accumulator.max[k]);
+      total.sum[k] += accumulator.sum[k];
+    }
+    total.contrast_sum += accumulator.contrast_sum;
+    for (std::size_t b = 0; b < num_bins; b++)
+    {
+      total.z_histogram[b] += accumulator.z_histogram[b];
+    }
+  }
+
+  PointCloudStatistics statistics{};
+  statistics.num_points = point_cloud.size();
+  statistics.num_valid_points = total.num_valid_points;
+  const float nan = std::numeric_limits<float>::quiet_NaN();
+  const bool has_valid_points = total.num_valid_points > 0;
+  const auto count = static_cast<double>(total.num_valid_points);
+  for (std::size_t k = 0; k < 3; k++)
+  {
+    statistics.min[k] = has_valid_points ? total.min[k] : nan;
+    statistics.max[k] = has_valid_points ? total.max[k] : nan;
+    statistics.mean[k] = has_valid_points ? static_cast<float>(total.sum[k] / count) : nan;
+  }
+  statistics.mean_contrast = has_valid_points ? static_cast<float>(total.contrast_sum / count) : nan;
+  statistics.z_histogram = std::move(total.z_histogram);
+  return statistics;
+}
+}  // namespace zivid_camera
@@ -0,0 +1,59 @@
+#include "process_memory.h"
+
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+namespace zivid_camera
+{
+ProcessMemoryUsage readProcessMemoryUsage()
+{
+  std::ifstream status("/proc/self/status");
+  if (!status)
+  {
+    throw std::runtime_error("Failed to open /proc/self/status");
+  }
+
+  ProcessMemoryUsage usage{};
+  bool has_resident = false;
+  bool has_peak = false;
+  std::string line;
+  while (std::getline(status, line) && !(has_resident && has_peak))
+  {
+    // The lines look like "VmRSS:	  123456 kB"
+    std::istringstream fields(line);
+    std::string name;
+    std::size_t kilobytes = 0;
+    if (!(fields >> name >> kilobytes))
+    {
+      continue;
+    }
+    if (name == "VmRSS:")
+    {
+      usage.resident_bytes = kilobytes * 1024;
+      has_resident = true;
+    }
+    else if (name == "VmHWM:")
+    {
+      usage.peak_resident_bytes = kilobytes * 1024;
+      has_peak = true;
+    }
+  }
+
+  if (!has_resident || !has_peak)
+  {
+    throw std::runtime_error("Failed to find VmRSS and VmHWM in /proc/self/status");
+  }
+  return usage;
+}
+
+bool resetPeakResidentMemory()
+{
+  // Writing 5 to clear_refs resets VmHWM (Linux 4.0 and newer)
+  std::ofstream clear_refs("/proc/self/clear_refs");
+  clear_refs << "5";
+  clear_refs.flush();
+  return static_cast<bool>(clear_refs);
+}
+}  // namespace zivid_camera
@@ -0,0 +1,227 @@
+#include "realtime.h"
+
+#include <malloc.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+
+namespace
+{
+int parseCpu(const std::string& value, const std::string& spec)
+{
+  std::size_t end = 0;
+  int cpu = -1;
+  try
+  {
+    cpu = std::stoi(value, &end);
+  }
+  catch (const std::exception&)
+  {
+    end = 0;
+  }
+  if (end == 0 || end != value.size() || cpu < 0 || cpu >= CPU_SETSIZE)
+  {
+    throw std::runtime_error("Invalid CPU '" + value + "' in CPU set '" + spec + "'");
+  }
+  return cpu;
+}
+
+std::vector<int> parseCpuList(const std::string& list, const std::string& spec)
+{
+  std::vector<int> cpus;
+  std::stringstream stream(list);
+  std::string item;
+  while (std::getline(stream, item, ','))
+  {
+    const auto is_space = [](unsigned char c) { return std::isspace(c) != 0; };
+    item.erase(std::remove_if(item.begin(), item.end(), is_space), item.end());
+    if (item.empty())
+    {
+      continue;
+    }
+    const auto dash = item.find('-');
+    const int first = parseCpu(item.substr(0, dash), spec);
+    const int last = dash == std::string::npos ? first : parseCpu(item.substr(dash + 1), spec);
+    if (last < first)
+    {
+      throw std::runtime_error("Invalid CPU range '" + item + "' in CPU set '" + spec + "'");
+    }
+    for (int cpu = first; cpu <= last; cpu++)
+    {
+      cpus.push_back(cpu);
+    }
+  }
+  std::sort(cpus.begin(), cpus.end());
+  cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+  return cpus;
+}
+
+std::string errorString(int error)
+{
+  return std::strerror(error);
+}
+}  // namespace
+
+namespace zivid_camera
+{
+std::vector<int> parseCpuSet(const std::string& spec)
+{
+  const std::string numa_prefix = "numa:";
+  if (spec.compare(0, numa_prefix.size(), numa_prefix) != 0)
+  {
+    return parseCpuList(spec, spec);
+  }
+
+  const auto node = spec.substr(numa_prefix.size());
+  if (node.empty() || !std::all_of(node.begin(), node.end(), [](unsigned char c) { return std::isdigit(c); }))
+  {
+    throw std::runtime_error("Invalid NUMA node in CPU set '" + spec + "'");
+  }
+  const auto path = "/sys/devices/system/node/node" + node + "/cpulist";
+  std::ifstream file(path);
+  std::string list;
+  if (!file || !std::getline(file, list))
+  {
+    throw std::runtime_error("Failed to read the CPUs of NUMA node " + node + " from " + path);
+  }
+  const auto cpus = parseCpuList(list, spec);
+  if (cpus.empty())
+  {
+    throw std::runtime_error("NUMA node " + node + " has no CPUs");
+  }
+  return cpus;
+}
+
+void applyThreadScheduling(pthread_t thread, const ThreadScheduling& scheduling)
+{
+  if (!scheduling.cpus.empty())
+  {
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    for (const auto cpu : scheduling.cpus)
+    {
+      CPU_SET(cpu, &cpus);
+    }
+    if (const int error = pthread_setaffinity_np(thread, sizeof(cpus), &cpus))
+    {
+      throw std::runtime_error("Failed to set the CPU affinity of a thread: " + errorString(error));
+    }
+  }
+
+  if (scheduling.fifo_priority != 0)
+  {
+    if (scheduling.fifo_priority < sched_get_priority_min(SCHED_FIFO) ||
+        scheduling.fifo_priority > sched_get_priority_max(SCHED_FIFO))
+    {
+      throw std::runtime_error("Invalid SCHED_FIFO priority " + std::to_string(scheduling.fifo_priority));
+    }
+    sched_param param{};
+    param.sched_priority = scheduling.fifo_priority;
+    if (const int error = pthread_setschedparam(thread, SCHED_FIFO, &param))
+    {
+      throw std::runtime_error("Failed to set SCHED_FIFO priority " + std::to_string(scheduling.fifo_priority) +
+                               ": " + errorString(error) + ". The process needs CAP_SYS_NICE or an rtprio limit.");
+    }
+  }
+}
+
+ScopedThreadScheduling::ScopedThreadScheduling(const ThreadScheduling& scheduling)
+  : active_(!scheduling.isDefault()), previous_cpus_{}, previous_policy_(SCHED_OTHER), previous_param_{}
+{
+  if (!active_)
+  {
+    return;
+  }
+  const auto thread = pthread_self();
+  if (const int error = pthread_getaffinity_np(thread, sizeof(previous_cpus_), &previous_cpus_))
+  {
+    throw std::runtime_error("Failed to get the CPU affinity of a thread: " + errorString(error));
+  }
+  if (const int error = pthread_getschedparam(thread, &previous_policy_, &previous_param_))
+  {
+    throw std::runtime_error("Failed to get the scheduling policy of a thread: " + errorString(error));
+  }
+  applyThreadScheduling(thread, scheduling);
+}
+
+ScopedThreadScheduling::~ScopedThreadScheduling()
+{
+  if (!active_)
+  {
+    return;
+  }
+  // Restoring can only fail if the previous settings are not valid any more, in which case there is nothing to do
+  const auto thread = pthread_self();
+  pthread_setschedparam(thread, previous_policy_, &previous_param_);
+  pthread_setaffinity_np(thread, sizeof(previous_cpus_), &previous_cpus_);
+}
+
+void lockProcessMemory(std::size_t prefault_bytes)
+{
+  // Serve all allocations from the main heap, and never give it back to the operating system. Otherwise the memory
+  // of freed message buffers would be unmapped and page fault again when the next capture is published.
+  mallopt(M_MMAP_MAX, 0);
+  mallopt(M_TRIM_THRESHOLD, -1);
+  mallopt(M_ARENA_MAX, 1);
+
+  if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0)
+  {
+    throw std::runtime_error("Failed to lock the memory of the process: " + errorString(errno) +
+                             ". The process needs CAP_IPC_LOCK or a sufficient memlock limit.");
+  }
+
+  if (prefault_bytes > 0)
+  {
+    const auto page_size = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+    std::unique_ptr<char[]> buffer(new char[prefault_bytes]);
+    for (std::size_t i = 0; i < prefault_bytes; i += page_size)
+    {
+      // Volatile, so that the writes are not optimized away
+      static_cast<volatile char*>(buffer.get())[i] = 0;
+    }
+  }
+}
+
+LatencyStatistics::LatencyStatistics()
+  : count_(0)
+  , sum_(std::chrono::nanoseconds::zero())
+  , max_(std::chrono::nanoseconds::zero())
+  , max_overall_(std::chrono::nanoseconds::zero())
+{
+}
+
+void LatencyStatistics::add(std::chrono::nanoseconds latency)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  count_++;
+  sum_ += latency;
+  max_ = std::max(max_, latency);
+  max_overall_ = std::max(max_overall_, latency);
+}
+
+LatencyStatistics::Summary LatencyStatistics::takeWindow()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  const auto mean = count_ > 0 ? sum_ / static_cast<std::int64_t>(count_) : std::chrono::nanoseconds::zero();
+  const Summary summary{ count_, mean, max_ };
+  count_ = 0;
+  sum_ = std::chrono::nanoseconds::zero();
+  max_ = std::chrono::nanoseconds::zero();
+  return summary;
+}
+
+std::chrono::nanoseconds LatencyStatistics::maxOverall() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return max_overall_;
+}
+}  // namespace zivid_camera
@@ -0,0 +1,168 @@
+#include "sdk_camera_backend.h"
+
+#include <Zivid/Firmware.h>
+#include <Zivid/HDR.h>
+#include <Zivid/Frame2D.h>
+
+#include <ros/console.h>
+
+namespace zivid_camera
+{
+SdkCameraBackend::SdkCameraBackend(std::string serial_number, const std::string& file_camera_path,
+                                   ThreadPool& thread_pool, std::size_t file_camera_cache_max_bytes)
+  : file_camera_path_(file_camera_path)
+{
+  const bool file_camera_mode = !file_camera_path.empty();
+
+  if (file_camera_mode)
+  {
+    ROS_INFO("Creating file camera from file '%s'", file_camera_path.c_str());
+    camera_ = zivid_.createFileCamera(file_camera_path);
+    if (file_camera_cache_max_bytes > 0)
+    {
+      ROS_INFO("Caching decoded file camera captures, using up to %zu MB", file_camera_cache_max_bytes / 1024 / 1024);
+      frame_cache_ = std::make_unique<DecodedFrameCache>(file_camera_cache_max_bytes, thread_pool);
+    }
+  }
+  else
+  {
+    auto cameras = zivid_.cameras();
+    ROS_INFO_STREAM(cameras.size() << " cameras found");
+    if (cameras.empty())
+    {
+      throw std::runtime_error("No cameras found. Ensure that the camera is connected to the USB3 port on your PC.");
+    }
+    else if (serial_number.empty())
+    {
+      camera_ = [&]() {
+        ROS_INFO("Selecting first available camera");
+        for (auto& c : cameras)
+        {
+          if (c.state().isAvailable())
+            return c;
+        }
+        throw std::runtime_error("No available cameras found. Is the camera in use by another process?");
+      }();
+    }
+    else
+    {
+      if (serial_number.find(":") == 0)
+      {
+        serial_number = serial_number.substr(1);
+      }
+      camera_ = [&]() {
+        ROS_INFO("Searching for camera with serial number '%s' ...", serial_number.c_str());
+        for (auto& c : cameras)
+        {
+          if (c.serialNumber() == Zivid::SerialNumber(serial_number))
+            return c;
+        }
+        throw std::runtime_error("No camera found with serial number '" + serial_number + "'");
+      }();
+    }
+
+    if (!Zivid::Firmware::isUpToDate(camera_))
+    {
+      ROS_INFO("The camera firmware is not up-to-date, starting update");
+      Zivid::Firmware::update(camera_, [](double progress, const std::string& state) {
+        ROS_INFO("  [%.0f%%] %s", progress, state.c_str());
+      });
+      ROS_INFO("Firmware update completed");
+    }
+  }
+
+  ROS_INFO_STREAM(camera_);
+  if (!file_camera_mode)
+  {
+    ROS_INFO_STREAM("Connecting to camera '" << camera_.serialNumber() << "'");
+    camera_.connect();
+  }
+}
+
+std::string SdkCameraBackend::modelName()
+{
+  return camera_.modelName();
+}
+
+std::string SdkCameraBackend::serialNumber()
+{
+  return camera_.serialNumber().toString();
+}
+
+bool SdkCameraBackend::isConnected()
+{
+  return camera_.state().isConnected().value();
+}
+
+bool SdkCameraBackend::reconnectIfAvailable()
+{
+  const auto state = camera_.state();
+
+  // The camera handle needs to be refreshed to ensure we get the correct
+  // "available" status. This is a bug in the API.
+  auto cameras = zivid_.cameras();
+  for (auto& c : cameras)
+  {
+    if (camera_.serialNumber() == c.serialNumber())
+    {
+      camera_ = c;
+    }
+  }
+
+  if (state.isAvailable().value())
+  {
+    ROS_INFO_STREAM("The camera '" << camera_.serialNumber()
+                                   << "' is not connected but is available. Re-connecting ...");
+    camera_.connect();
+    ROS_INFO("Successfully reconnected to camera!");
+    return true;
+  }
+  ROS_INFO_STREAM("The camera '" << camera_.serialNumber() << "' is not connected nor available.");
+  return false;
+}
+
+Zivid::Settings SdkCameraBackend::settings()
+{
+  return camera_.settings();
+}
+
+Zivid::CameraIntrinsics SdkCameraBackend::intrinsics()
+{
+  return camera_.intrinsics();
+}
+
+CapturedFrame SdkCameraBackend::capture(const std::vector<Zivid::Settings>& settings)
+{
+  std::string cache_key;
+  if (frame_cache_)
+  {
+    cache_key = decodedFrameCacheKey(file_camera_path_, settings);
+    if (auto cached = frame_cache_->get(cache_key))
+    {
+      ROS_DEBUG("Using cached capture (%lu hits, %lu misses)", static_cast<unsigned long>(frame_cache_->numHits()),
+                static_cast<unsigned long>(frame_cache_->numMisses()));
+      return std::move(*cached);
+    }
+  }
+
+  auto frame = Zivid::HDR::capture(camera_, settings);
+  auto point_cloud = frame.getPointCloud();
+  CapturedFrame captured{ std::move(point_cloud), std::move(frame), std::nullopt };
+  if (frame_cache_)
+  {
+    frame_cache_->put(cache_key, captured);
+  }
+  return captured;
+}
+
+Zivid::Image<Zivid::RGBA8> SdkCameraBackend::capture2D(const Zivid::Settings2D& settings)
+{
+  return camera_.capture2D(settings).image<Zivid::RGBA8>();
+}
+
+std::vector<Zivid::Settings>
+SdkCameraBackend::suggestSettings(const Zivid::CaptureAssistant::SuggestSettingsParameters& parameters)
+{
+  return Zivid::CaptureAssistant::suggestSettings(camera_, parameters);
+}
+}  // namespace zivid_camera
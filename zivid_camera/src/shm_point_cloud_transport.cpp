@@ -0,0 +1,443 @@
+#include "shm_point_cloud_transport.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+
+namespace zivid_camera
+{
+namespace shm
+{
+constexpr std::uint32_t magic = 0x5A50434CU;  // "ZPCL"
+constexpr std::uint32_t version = 1;
+constexpr std::size_t data_alignment = 4096;
+// Values of RingHeader::state
+constexpr std::uint32_t ring_ready = 1;
+// The writer has replaced or removed the segment
+constexpr std::uint32_t ring_closed = 2;
+
+struct SlotHeader
+{
+  // Sequence number of the frame in this slot, or 0 if the slot is empty or being written
+  std::atomic<std::uint64_t> sequence;
+  // The lease epoch in the upper 32 bits, and the number of readers with a lease in this epoch in the lower 32 bits
+  std::atomic<std::uint64_t> lease;
+  // Time (steady clock, nanoseconds) at which the current leases on this slot expire
+  std::atomic<std::int64_t> lease_expiry_ns;
+  ShmPointCloudMetadata metadata;
+  std::uint64_t data_offset;
+};
+
+struct RingHeader
+{
+  std::uint32_t magic;
+  std::uint32_t version;
+  std::uint64_t num_slots;
+  std::uint64_t slot_capacity;
+  std::atomic<std::uint64_t> latest_slot;
+  std::atomic<std::uint32_t> state;
+};
+
+struct Mapping
+{
+  Mapping(std::uint8_t* data_, std::size_t size_) : data(data_), size(size_)
+  {
+  }
+  ~Mapping()
+  {
+    munmap(data, size);
+  }
+  Mapping(const Mapping&) = delete;
+  Mapping& operator=(const Mapping&) = delete;
+
+  std::uint8_t* data;
+  std::size_t size;
+};
+
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "Shared-memory atomics must be lock-free");
+static_assert(std::atomic<std::uint32_t>::is_always_lock_free, "Shared-memory atomics must be lock-free");
+static_assert(std::atomic<std::int64_t>::is_always_lock_free, "Shared-memory atomics must be lock-free");
+}  // namespace shm
+
+namespace
+{
+std::size_t alignUp(std::size_t value, std::size_t alignment)
+{
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+std::size_t slotHeadersEnd(std::size_t num_slots)
+{
+  return sizeof(shm::RingHeader) + num_slots * sizeof(shm::SlotHeader);
+}
+
+shm::RingHeader* ringHeader(const shm::Mapping& mapping)
+{
+  return reinterpret_cast<shm::RingHeader*>(mapping.data);
+}
+
+shm::SlotHeader* slotHeader(std::uint8_t* mapping, std::size_t index)
+{
+  return reinterpret_cast<shm::SlotHeader*>(mapping + sizeof(shm::RingHeader)) + index;
+}
+
+std::uint32_t leaseEpoch(std::uint64_t lease)
+{
+  return static_cast<std::uint32_t>(lease >> 32);
+}
+
+std::uint32_t leaseCount(std::uint64_t lease)
+{
+  return static_cast<std::uint32_t>(lease);
+}
+
+std::int64_t steadyNowNs()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+std::runtime_error systemError(const std::string& what, const std::string& name)
+{
+  return std::runtime_error(what + " '" + name + "': " + std::strerror(errno));
+}
+
+void releaseLease(shm::SlotHeader& slot, std::uint32_t epoch)
+{
+  auto lease = slot.lease.load();
+  // Nothing to release if the writer has reclaimed the lease after it expired. The count then belongs to a later epoch.
+  while (leaseEpoch(lease) == epoch && leaseCount(lease) > 0 && !slot.lease.compare_exchange_weak(lease, lease - 1))
+  {
+  }
+}
+
+std::shared_ptr<const shm::Mapping> openMapping(const std::string& name)
+{
+  const int fd = shm_open(name.c_str(), O_RDWR, 0);
+  if (fd < 0)
+  {
+    throw systemError("Failed to open shared-memory segment", name);
+  }
+  struct stat st
+  {
+  };
+  if (fstat(fd, &st) != 0)
+  {
+    const auto error = systemError("Failed to stat shared-memory segment", name);
+    close(fd);
+    throw error;
+  }
+  const auto mapping_size = static_cast<std::size_t>(st.st_size);
+  if (mapping_size < sizeof(shm::RingHeader))
+  {
+    close(fd);
+    throw std::runtime_error("Shared-memory segment '" + name + "' is too small");
+  }
+  void* data = mmap(nullptr, mapping_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED)
+  {
+    throw systemError("Failed to map shared-memory segment", name);
+  }
+  auto mapping = std::make_shared<const shm::Mapping>(static_cast<std::uint8_t*>(data), mapping_size);
+
+  const auto* ring = ringHeader(*mapping);
+  if (ring->state.load() != shm::ring_ready || ring->magic != shm::magic || ring->version != shm::version ||
+      mapping_size < slotHeadersEnd(ring->num_slots))
+  {
+    throw std::runtime_error("Shared-memory segment '" + name + "' is not a compatible point cloud ring buffer");
+  }
+  return mapping;
+}
+}  // namespace
+
+ShmPointCloudWriter::ShmPointCloudWriter(std::string name, std::size_t num_slots, std::size_t slot_capacity,
+                                         mode_t mode)
+  : name_(std::move(name))
+  , num_slots_(num_slots)
+  , slot_capacity_(alignUp(slot_capacity, shm::data_alignment))
+  , mode_(mode)
+  , mapping_size_(0)
+  , mapping_(nullptr)
+  , ring_(nullptr)
+  , next_slot_(0)
+  , write_slot_(0)
+  , next_sequence_(1)
+  , num_dropped_frames_(0)
+{
+  if (num_slots_ < 2)
+  {
+    throw std::runtime_error("The shared-memory ring buffer needs at least 2 slots");
+  }
+  create();
+}
+
+ShmPointCloudWriter::~ShmPointCloudWriter()
+{
+  destroy();
+}
+
+void ShmPointCloudWriter::create()
+{
+  const auto data_begin = alignUp(slotHeadersEnd(num_slots_), shm::data_alignment);
+  mapping_size_ = data_begin + num_slots_ * slot_capacity_;
+
+  // Remove any segment left behind by a previous run of the driver. Readers still mapping it keep their mapping.
+  shm_unlink(name_.c_str());
+  const int fd = shm_open(name_.c_str(), O_CREAT | O_EXCL | O_RDWR, mode_);
+  if (fd < 0)
+  {
+    throw systemError("Failed to create shared-memory segment", name_);
+  }
+  // shm_open applies the umask, which would otherwise make it impossible to grant access to the group or others
+  if (fchmod(fd, mode_) != 0 || ftruncate(fd, static_cast<off_t>(mapping_size_)) != 0)
+  {
+    const auto error = systemError("Failed to set up shared-memory segment", name_);
+    close(fd);
+    shm_unlink(name_.c_str());
+    throw error;
+  }
+  void* mapping = mmap(nullptr, mapping_size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED)
+  {
+    const auto error = systemError("Failed to map shared-memory segment", name_);
+    shm_unlink(name_.c_str());
+    throw error;
+  }
+  mapping_ = static_cast<std::uint8_t*>(mapping);
+
+  ring_ = new (mapping_) shm::RingHeader{};
+  ring_->magic = shm::magic;
+  ring_->version = shm::version;
+  ring_->num_slots = num_slots_;
+  ring_->slot_capacity = slot_capacity_;
+  ring_->latest_slot.store(0);
+  for (std::size_t i = 0; i < num_slots_; i++)
+  {
+    auto* slot = new (slotHeader(mapping_, i)) shm::SlotHeader{};
+    slot->sequence.store(0);
+    slot->lease.store(0);
+    slot->lease_expiry_ns.store(0);
+    slot->data_offset = data_begin + i * slot_capacity_;
+  }
+  next_slot_ = 0;
+  ring_->state.store(shm::ring_ready);
+}
+
+void ShmPointCloudWriter::destroy()
+{
+  if (mapping_ == nullptr)
+  {
+    // A previous resize failed to create the new segment
+    return;
+  }
+  // Tell the readers to map the segment again on their next acquire
+  ring_->state.store(shm::ring_closed);
+  munmap(mapping_, mapping_size_);
+  shm_unlink(name_.c_str());
+  mapping_ = nullptr;
+  ring_ = nullptr;
+}
+
+void ShmPointCloudWriter::resize(std::size_t slot_capacity)
+{
+  destroy();
+  slot_capacity_ = alignUp(slot_capacity, shm::data_alignment);
+  create();
+}
+
+std::uint8_t* ShmPointCloudWriter::beginWrite(std::size_t data_size)
+{
+  if (data_size > slot_capacity_)
+  {
+    num_dropped_frames_++;
+    return nullptr;
+  }
+
+  for (std::size_t i = 0; i < num_slots_; i++)
+  {
+    const auto index = (next_slot_ + i) % num_slots_;
+    auto& slot = *slotHeader(mapping_, index);
+
+    auto lease = slot.lease.load();
+    if (leaseCount(lease) != 0)
+    {
+      if (slot.lease_expiry_ns.load() > steadyNowNs())
+      {
+        continue;
+      }
+      // All leases on this slot have expired. Reclaim them by starting a new epoch, so that the late releases of the
+      // expired leases do not release any newer lease. Fails if a new reader arrived in the meantime.
+      const auto next_epoch = static_cast<std::uint64_t>(leaseEpoch(lease) + 1U) << 32;
+      if (!slot.lease.compare_exchange_strong(lease, next_epoch))
+      {
+        continue;
+      }
+    }
+
+    // Invalidate the slot, then check that no reader took a lease before it observed the invalidation
+    slot.sequence.store(0);
+    if (leaseCount(slot.lease.load()) != 0)
+    {
+      continue;
+    }
+
+    write_slot_ = index;
+    next_slot_ = (index + 1) % num_slots_;
+    return mapping_ + slot.data_offset;
+  }
+
+  num_dropped_frames_++;
+  return nullptr;
+}
+
+std::uint64_t ShmPointCloudWriter::commitWrite(const ShmPointCloudMetadata& metadata)
+{
+  auto& slot = *slotHeader(mapping_, write_slot_);
+  slot.metadata = metadata;
+  const auto sequence = next_sequence_++;
+  slot.sequence.store(sequence);
+  ring_->latest_slot.store(write_slot_);
+  return sequence;
+}
+
+ShmPointCloudLease::ShmPointCloudLease() : slot_(nullptr), data_(nullptr), epoch_(0), sequence_(0)
+{
+}
+
+ShmPointCloudLease::ShmPointCloudLease(std::shared_ptr<const shm::Mapping> mapping, shm::SlotHeader* slot,
+                                       std::uint32_t epoch, std::uint64_t sequence)
+  : mapping_(std::move(mapping))
+  , slot_(slot)
+  , data_(mapping_->data + slot->data_offset)
+  , epoch_(epoch)
+  , sequence_(sequence)
+{
+}
+
+ShmPointCloudLease::~ShmPointCloudLease()
+{
+  release();
+}
+
+ShmPointCloudLease::ShmPointCloudLease(ShmPointCloudLease&& other) noexcept
+  : mapping_(std::move(other.mapping_))
+  , slot_(other.slot_)
+  , data_(other.data_)
+  , epoch_(other.epoch_)
+  , sequence_(other.sequence_)
+{
+  other.slot_ = nullptr;
+  other.data_ = nullptr;
+}
+
+ShmPointCloudLease& ShmPointCloudLease::operator=(ShmPointCloudLease&& other) noexcept
+{
+  if (this != &other)
+  {
+    release();
+    mapping_ = std::move(other.mapping_);
+    slot_ = other.slot_;
+    data_ = other.data_;
+    epoch_ = other.epoch_;
+    sequence_ = other.sequence_;
+    other.slot_ = nullptr;
+    other.data_ = nullptr;
+  }
+  return *this;
+}
+
+const ShmPointCloudMetadata& ShmPointCloudLease::metadata() const
+{
+  return slot_->metadata;
+}
+
+bool ShmPointCloudLease::isValid() const
+{
+  if (slot_ == nullptr)
+  {
+    return false;
+  }
+  // Order the reads of the frame before the checks, so that a frame that is overwritten while it is read is detected
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return slot_->sequence.load() == sequence_ && leaseEpoch(slot_->lease.load()) == epoch_;
+}
+
+void ShmPointCloudLease::release()
+{
+  if (slot_ != nullptr)
+  {
+    releaseLease(*slot_, epoch_);
+    mapping_.reset();
+    slot_ = nullptr;
+    data_ = nullptr;
+  }
+}
+
+ShmPointCloudReader::ShmPointCloudReader(std::string name, std::chrono::milliseconds lease_duration)
+  : name_(std::move(name)), lease_duration_(lease_duration), mapping_(openMapping(name_))
+{
+}
+
+ShmPointCloudReader::~ShmPointCloudReader() = default;
+
+ShmPointCloudLease ShmPointCloudReader::acquireLatest(std::uint64_t after)
+{
+  if (ringHeader(*mapping_)->state.load() == shm::ring_closed)
+  {
+    try
+    {
+      mapping_ = openMapping(name_);
+    }
+    catch (const std::runtime_error&)
+    {
+      // The writer has not created the new segment yet
+      return ShmPointCloudLease{};
+    }
+  }
+  auto* ring = ringHeader(*mapping_);
+
+  const auto lease_duration_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(lease_duration_).count();
+
+  // Retry a bounded number of times in case the writer re-uses the latest slot while we are acquiring it
+  for (std::size_t attempt = 0; attempt < 2 * ring->num_slots; attempt++)
+  {
+    auto& slot = *slotHeader(mapping_->data, ring->latest_slot.load());
+
+    // Extend the expiry before taking the lease, so that the writer never sees the lease with an expiry in the past
+    const auto expiry = steadyNowNs() + lease_duration_ns;
+    auto current_expiry = slot.lease_expiry_ns.load();
+    while (current_expiry < expiry && !slot.lease_expiry_ns.compare_exchange_weak(current_expiry, expiry))
+    {
+    }
+    const auto epoch = leaseEpoch(slot.lease.fetch_add(1));
+
+    const auto sequence = slot.sequence.load();
+    if (leaseEpoch(slot.lease.load()) != epoch)
+    {
+      // The writer reclaimed the lease because it already expired. It is no longer counted, so there is no release.
+      continue;
+    }
+    if (sequence == 0)
+    {
+      releaseLease(slot, epoch);
+      continue;
+    }
+    if (sequence <= after)
+    {
+      releaseLease(slot, epoch);
+      return ShmPointCloudLease{};
+    }
+    return ShmPointCloudLease{ mapping_, &slot, epoch, sequence };
+  }
+  return ShmPointCloudLease{};
+}
+}  // namespace zivid_camera
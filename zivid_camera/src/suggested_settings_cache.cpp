@@ -0,0 +1,73 @@
+#include "suggested_settings_cache.h"
+
+namespace zivid_camera
+{
+SuggestedSettingsCache::SuggestedSettingsCache(std::chrono::nanoseconds time_to_live)
+  : time_to_live_(time_to_live), num_hits_(0), num_misses_(0)
+{
+}
+
+bool SuggestedSettingsCache::hasExpired(const Entry& entry, std::chrono::steady_clock::time_point now) const
+{
+  return now - entry.time >= time_to_live_;
+}
+
+std::optional<std::vector<Zivid::Settings>> SuggestedSettingsCache::get(const SuggestedSettingsKey& key,
+                                                                        std::chrono::steady_clock::time_point now)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  const auto it = entries_.find(key);
+  if (it == entries_.end() || hasExpired(it->second, now))
+  {
+    num_misses_++;
+    return std::nullopt;
+  }
+  num_hits_++;
+  return it->second.settings;
+}
+
+void SuggestedSettingsCache::put(const SuggestedSettingsKey& key, const std::vector<Zivid::Settings>& settings,
+                                 std::chrono::steady_clock::time_point now)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto it = entries_.begin(); it != entries_.end();)
+  {
+    it = hasExpired(it->second, now) ? entries_.erase(it) : std::next(it);
+  }
+  entries_.insert_or_assign(key, Entry{ settings, now });
+}
+
+std::size_t SuggestedSettingsCache::clear(const std::optional<std::string>& scene_tag)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  const auto num_entries = entries_.size();
+  if (!scene_tag)
+  {
+    entries_.clear();
+    return num_entries;
+  }
+  for (auto it = entries_.begin(); it != entries_.end();)
+  {
+    it = it->first.scene_tag == *scene_tag ? entries_.erase(it) : std::next(it);
+  }
+  return num_entries - entries_.size();
+}
+
+std::size_t SuggestedSettingsCache::numEntries()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return entries_.size();
+}
+
+std::uint64_t SuggestedSettingsCache::numHits()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return num_hits_;
+}
+
+std::uint64_t SuggestedSettingsCache::numMisses()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return num_misses_;
+}
+}  // namespace zivid_camera
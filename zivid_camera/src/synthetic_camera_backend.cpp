@@ -0,0 +1,144 @@
+#include "synthetic_camera_backend.h"
+
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace
+{
+// Cheap stateless hash (splitmix64) used to decide which points are NaN, so that the pattern changes between captures
+// and the generation can be done in parallel without shared random state.
+std::uint64_t hash(std::uint64_t x)
+{
+  x += 0x9E3779B97F4A7C15ULL;
+  x = (x ^ (x >> 30U)) * 0xBF58476D1CE4E5B9ULL;
+  x = (x ^ (x >> 27U)) * 0x94D049BB133111EBULL;
+  return x ^ (x >> 31U);
+}
+
+std::uint32_t packRGBA(std::uint8_t r, std::uint8_t g, std::uint8_t b)
+{
+  return (0xFFU << 24U) | (static_cast<std::uint32_t>(r) << 16U) | (static_cast<std::uint32_t>(g) << 8U) | b;
+}
+}  // namespace
+
+namespace zivid_camera
+{
+SyntheticCameraBackend::SyntheticCameraBackend(const Parameters& parameters, ThreadPool& thread_pool)
+  : parameters_(parameters), thread_pool_(thread_pool), frame_index_(0), rate_limiter_(parameters.frame_rate)
+{
+  if (parameters_.width == 0 || parameters_.height == 0)
+  {
+    throw std::runtime_error("The synthetic camera resolution must be larger than 0x0");
+  }
+  if (parameters_.nan_ratio < 0.0 || parameters_.nan_ratio > 1.0)
+  {
+    throw std::runtime_error("The synthetic camera NaN ratio must be in the range [0, 1], got " +
+                             std::to_string(parameters_.nan_ratio));
+  }
+
+  // Same field of view as the Zivid One+ M, independent of the resolution
+  fx_ = 2760.0 * static_cast<double>(parameters_.width) / 1920.0;
+  fy_ = fx_;
+  cx_ = 0.5 * static_cast<double>(parameters_.width);
+  cy_ = 0.5 * static_cast<double>(parameters_.height);
+}
+
+std::string SyntheticCameraBackend::modelName()
+{
+  return "SyntheticCamera";
+}
+
+std::string SyntheticCameraBackend::serialNumber()
+{
+  return "synthetic";
+}
+
+bool SyntheticCameraBackend::isConnected()
+{
+  return true;
+}
+
+bool SyntheticCameraBackend::reconnectIfAvailable()
+{
+  return true;
+}
+
+Zivid::Settings SyntheticCameraBackend::settings()
+{
+  return Zivid::Settings{};
+}
+
+Zivid::CameraIntrinsics SyntheticCameraBackend::intrinsics()
+{
+  Zivid::CameraIntrinsics intrinsics;
+  intrinsics.set(Zivid::CameraIntrinsics::CameraMatrix::FX{ fx_ });
+  intrinsics.set(Zivid::CameraIntrinsics::CameraMatrix::FY{ fy_ });
+  intrinsics.set(Zivid::CameraIntrinsics::CameraMatrix::CX{ cx_ });
+  intrinsics.set(Zivid::CameraIntrinsics::CameraMatrix::CY{ cy_ });
+  intrinsics.set(Zivid::CameraIntrinsics::Distortion::K1{ 0.0 });
+  intrinsics.set(Zivid::CameraIntrinsics::Distortion::K2{ 0.0 });
+  intrinsics.set(Zivid::CameraIntrinsics::Distortion::K3{ 0.0 });
+  intrinsics.set(Zivid::CameraIntrinsics::Distortion::P1{ 0.0 });
+  intrinsics.set(Zivid::CameraIntrinsics::Distortion::P2{ 0.0 });
+  return intrinsics;
+}
+
+CapturedFrame SyntheticCameraBackend::capture(const std::vector<Zivid::Settings>&)
+{
+  rate_limiter_.waitForNextCaptureSlot();
+
+  const auto width = parameters_.width;
+  const auto height = parameters_.height;
+  const auto frame_index = frame_index_++;
+  const auto nan_threshold =
+      static_cast<std::uint64_t>(parameters_.nan_ratio * static_cast<double>(std::numeric_limits<std::uint64_t>::max()));
+  const bool all_nan = parameters_.nan_ratio >= 1.0;
+  // Let the surface drift a little between captures, so that consecutive clouds are not identical
+  const double phase = 0.1 * static_cast<double>(frame_index);
+
+  Zivid::PointCloud point_cloud(width, height);
+  Zivid::Point* points = point_cloud.dataPtr();
+
+  thread_pool_.parallelFor(0, height, [&](std::size_t row) {
+    for (std::size_t col = 0; col < width; col++)
+    {
+      const auto i = row * width + col;
+      auto& point = points[i];
+      const auto u = (static_cast<double>(col) - cx_) / fx_;
+      const auto v = (static_cast<double>(row) - cy_) / fy_;
+      const auto z = 1000.0 + 50.0 * std::sin(8.0 * u + phase) * std::cos(8.0 * v);
+      const auto shade = static_cast<std::uint8_t>(127.5 + 127.5 * std::sin(12.0 * u + phase));
+
+      if (all_nan || hash((frame_index << 32U) ^ i) < nan_threshold)
+      {
+        point.x = std::numeric_limits<float>::quiet_NaN();
+        point.y = std::numeric_limits<float>::quiet_NaN();
+        point.z = std::numeric_limits<float>::quiet_NaN();
+        point.contrast = 0.0f;
+      }
+      else
+      {
+        point.x = static_cast<float>(u * z);
+        point.y = static_cast<float>(v * z);
+        point.z = static_cast<float>(z);
+        point.contrast = 10.0f;
+      }
+      point.rgba = packRGBA(shade, static_cast<std::uint8_t>(255 * row / height),
+                            static_cast<std::uint8_t>(255 * col / width));
+    }
+  });
+  return CapturedFrame{ std::move(point_cloud), std::nullopt };
+}
+
+Zivid::Image<Zivid::RGBA8> SyntheticCameraBackend::capture2D(const Zivid::Settings2D&)
+{
+  throw std::runtime_error("2D capture is not supported by the synthetic camera backend");
+}
+
+std::vector<Zivid::Settings>
+SyntheticCameraBackend::suggestSettings(const Zivid::CaptureAssistant::SuggestSettingsParameters&)
+{
+  return { Zivid::Settings{} };
+}
+}  // namespace zivid_camera
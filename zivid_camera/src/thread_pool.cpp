@@ -0,0 +1,196 @@
+#include "thread_pool.h"
+
+#include <stdexcept>
+
+namespace zivid_camera
+{
+struct ThreadPool::Batch
+{
+  const std::function<void(std::size_t)>* chunk_fn;
+  // Decremented with the mutex locked, so that the batch is not destroyed while it is being notified
+  std::atomic<std::size_t> remaining;
+  std::mutex mutex;
+  std::condition_variable done;
+  std::exception_ptr error;
+};
+
+ThreadPool::ThreadPool(std::size_t num_threads, std::size_t chunks_per_thread)
+  : chunks_per_thread_(chunks_per_thread)
+  , num_queued_tasks_(0)
+  , next_queue_(0)
+  , last_notify_time_(0)
+  , max_wakeup_latency_(0)
+  , stop_(false)
+{
+  if (chunks_per_thread == 0)
+  {
+    throw std::runtime_error("The number of chunks per thread must be larger than 0");
+  }
+  if (num_threads == 0)
+  {
+    num_threads = std::max(1U, std::thread::hardware_concurrency());
+  }
+
+  const auto num_workers = num_threads - 1;
+  for (std::size_t i = 0; i < num_workers; i++)
+  {
+    queues_.push_back(std::make_unique<TaskQueue>());
+  }
+  workers_.reserve(num_workers);
+  for (std::size_t i = 0; i < num_workers; i++)
+  {
+    workers_.emplace_back([this, i]() { workerThread(i); });
+  }
+}
+
+ThreadPool::~ThreadPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(wake_mutex_);
+    stop_ = true;
+  }
+  task_available_.notify_all();
+  for (auto& worker : workers_)
+  {
+    worker.join();
+  }
+}
+
+void ThreadPool::run(std::size_t num_chunks, const std::function<void(std::size_t)>& chunk_fn)
+{
+  if (workers_.empty() || num_chunks == 1)
+  {
+    for (std::size_t chunk = 0; chunk < num_chunks; chunk++)
+    {
+      chunk_fn(chunk);
+    }
+    return;
+  }
+
+  Batch batch;
+  batch.chunk_fn = &chunk_fn;
+  batch.remaining = num_chunks;
+
+  // Start at a different queue for each batch, so that concurrent batches are spread over the workers
+  const auto first_queue = next_queue_.fetch_add(1) % queues_.size();
+  for (std::size_t chunk = 0; chunk < num_chunks; chunk++)
+  {
+    auto& queue = *queues_[(first_queue + chunk) % queues_.size()];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    queue.tasks.push_back(Task{ &batch, chunk });
+  }
+  {
+    std::lock_guard<std::mutex> lock(wake_mutex_);
+    num_queued_tasks_ += num_chunks;
+    last_notify_time_ = std::chrono::steady_clock::now().time_since_epoch().count();
+  }
+  task_available_.notify_all();
+
+  // Help with the queued tasks instead of blocking. The tasks of this batch that are not queued any more are running on
+  // other threads, so the remaining time is spent waiting for them.
+  while (batch.remaining > 0 && tryRunTask(first_queue, false))
+  {
+  }
+  std::unique_lock<std::mutex> lock(batch.mutex);
+  batch.done.wait(lock, [&batch]() { return batch.remaining == 0; });
+  if (batch.error)
+  {
+    std::rethrow_exception(batch.error);
+  }
+}
+
+bool ThreadPool::tryRunTask(std::size_t first_queue, bool take_from_front)
+{
+  Task task{ nullptr, 0 };
+  for (std::size_t i = 0; i < queues_.size() && !task.batch; i++)
+  {
+    auto& queue = *queues_[(first_queue + i) % queues_.size()];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty())
+    {
+      continue;
+    }
+    // Only the owner of a queue takes from the front, everybody else steals from the back
+    if (i == 0 && take_from_front)
+    {
+      task = queue.tasks.front();
+      queue.tasks.pop_front();
+    }
+    else
+    {
+      task = queue.tasks.back();
+      queue.tasks.pop_back();
+    }
+  }
+  if (!task.batch)
+  {
+    return false;
+  }
+  num_queued_tasks_--;
+
+  auto& batch = *task.batch;
+  try
+  {
+    (*batch.chunk_fn)(task.chunk);
+  }
+  catch (...)
+  {
+    std::lock_guard<std::mutex> lock(batch.mutex);
+    if (!batch.error)
+    {
+      batch.error = std::current_exception();
+    }
+  }
+  std::lock_guard<std::mutex> lock(batch.mutex);
+  if (--batch.remaining == 0)
+  {
+    batch.done.notify_all();
+  }
+  return true;
+}
+
+void ThreadPool::workerThread(std::size_t index)
+{
+  while (true)
+  {
+    if (tryRunTask(index, true))
+    {
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(wake_mutex_);
+    if (num_queued_tasks_ == 0 && !stop_)
+    {
+      task_available_.wait(lock, [this]() { return stop_ || num_queued_tasks_ > 0; });
+      // last_notify_time_ is written together with num_queued_tasks_, so it is the time of the notification that
+      // woke this thread up
+      const auto latency = std::chrono::steady_clock::now().time_since_epoch().count() - last_notify_time_;
+      const auto latency_ns =
+          std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::duration(latency)).count();
+      auto max_latency = max_wakeup_latency_.load();
+      while (latency_ns > max_latency && !max_wakeup_latency_.compare_exchange_weak(max_latency, latency_ns))
+      {
+      }
+    }
+    if (stop_)
+    {
+      return;
+    }
+  }
+}
+
+std::vector<std::thread::native_handle_type> ThreadPool::workerHandles()
+{
+  std::vector<std::thread::native_handle_type> handles;
+  handles.reserve(workers_.size());
+  for (auto& worker : workers_)
+  {
+    handles.push_back(worker.native_handle());
+  }
+  return handles;
+}
+
+std::chrono::nanoseconds ThreadPool::takeMaxWakeupLatency()
+{
+  return std::chrono::nanoseconds(max_wakeup_latency_.exchange(0));
+}
+}  // namespace zivid_camera
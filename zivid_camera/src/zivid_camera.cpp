@@ -2,15 +2,19 @@
 #include "CaptureGeneralConfigUtils.h"
 #include "CaptureFrameConfigUtils.h"
 #include "Capture2DFrameConfigUtils.h"
+#include "sdk_camera_backend.h"
+#include "synthetic_camera_backend.h"
+#include "playback_camera_backend.h"
+#include "image_rectification.h"
+#include "point_cloud_codec.h"
+#include "point_cloud_normals.h"
+#include "process_memory.h"
 
 #include <sensor_msgs/point_cloud2_iterator.h>
 #include <sensor_msgs/image_encodings.h>
 #include <sensor_msgs/distortion_models.h>
 #include <dynamic_reconfigure/config_tools.h>
 
-#include <Zivid/HDR.h>
-#include <Zivid/Firmware.h>
-#include <Zivid/Frame2D.h>
 #include <Zivid/Settings2D.h>
 #include <Zivid/Version.h>
 #include <Zivid/CaptureAssistant.h>
@@ -18,12 +22,22 @@
 #include <boost/algorithm/string.hpp>
 #include <boost/predef.h>
 
+#include <malloc.h>
+
+#include <algorithm>
+#include <future>
+#include <limits>
 #include <sstream>
 #include <thread>
 #include <cstdint>
+#include <cstring>
 
 namespace
 {
+// The reconnect uses the camera, so it waits for its turn in the capture scheduler like the captures. It goes before
+// all waiting captures, since they fail anyway while the camera is disconnected.
+constexpr int camera_reconnect_priority = std::numeric_limits<int>::max();
+
 sensor_msgs::PointField createPointField(std::string name, uint32_t offset, uint8_t datatype, uint32_t count)
 {
   sensor_msgs::PointField point_field;
@@ -48,6 +62,45 @@ void fillCommonMsgFields(T& msg, const std_msgs::Header& header, std::size_t wid
   msg.is_bigendian = big_endian();
 }
 
+// Write the points to dst using the layout of the PointCloud2 messages on the points topic, transforming x, y and z
+// with `transform` (which includes the conversion from mm to m)
+void copyPointsInMeters(const Zivid::PointCloud& point_cloud, const zivid_camera::PointTransform& transform,
+                        uint8_t* dst, zivid_camera::ThreadPool& thread_pool)
+{
+  const Zivid::Point* src = point_cloud.dataPtr();
+
+  thread_pool.parallelFor(0, point_cloud.size(), [&](std::size_t i) {
+    Zivid::Point point = src[i];
+    transform.applyToPoint(point);
+    std::memcpy(dst + i * sizeof(Zivid::Point), &point, sizeof(Zivid::Point));
+  });
+}
+
+zivid_camera::PinholeCameraModel toPinholeCameraModel(const Zivid::CameraIntrinsics& intrinsics)
+{
+  const auto camera_matrix = intrinsics.cameraMatrix();
+  const auto distortion = intrinsics.distortion();
+  zivid_camera::PinholeCameraModel model{};
+  model.fx = camera_matrix.fx().value();
+  model.fy = camera_matrix.fy().value();
+  model.cx = camera_matrix.cx().value();
+  model.cy = camera_matrix.cy().value();
+  model.k1 = distortion.k1().value();
+  model.k2 = distortion.k2().value();
+  model.p1 = distortion.p1().value();
+  model.p2 = distortion.p2().value();
+  model.k3 = distortion.k3().value();
+  return model;
+}
+
+// The transform from mm in the camera frame to m in the target frame
+zivid_camera::PointTransform toPointTransform(const geometry_msgs::Transform& transform)
+{
+  const auto& q = transform.rotation;
+  const auto& t = transform.translation;
+  return zivid_camera::PointTransform::millimetersToMeters({ q.x, q.y, q.z, q.w }, { t.x, t.y, t.z });
+}
+
 std::string toString(zivid_camera::CameraStatus camera_status)
 {
   switch (camera_status)
@@ -62,6 +115,94 @@ std::string toString(zivid_camera::CameraStatus camera_status)
   return "N/A";
 }
 
+zivid_camera::CaptureScheduler::Request toSchedulerRequest(std::int32_t priority, const ros::Duration& deadline)
+{
+  std::optional<std::chrono::steady_clock::time_point> deadline_time;
+  if (!deadline.isZero())
+  {
+    deadline_time = std::chrono::steady_clock::now() + std::chrono::nanoseconds(deadline.toNSec());
+  }
+  return zivid_camera::CaptureScheduler::Request{ priority, deadline_time };
+}
+
+// Convert a map of parameter names and values, e.g. from a YAML file, to a config message. The values are converted
+// to the type of the parameter in ConfigType, so that for example a double parameter can be given as an integer.
+template <typename ConfigType>
+dynamic_reconfigure::Config toConfigMessage(XmlRpc::XmlRpcValue& parameters, const std::string& context)
+{
+  if (parameters.getType() != XmlRpc::XmlRpcValue::TypeStruct)
+  {
+    throw std::runtime_error(context + " must be a map from parameter names to values");
+  }
+
+  const auto& descriptions = ConfigType::__getParamDescriptions__();
+  dynamic_reconfigure::Config msg;
+  for (auto& [name, value] : parameters)
+  {
+    const auto description = std::find_if(descriptions.begin(), descriptions.end(),
+                                          [&name = name](const auto& d) { return d->name == name; });
+    if (description == descriptions.end())
+    {
+      throw std::runtime_error("Unknown parameter " + context + "/" + name);
+    }
+    const auto& type = (*description)->type;
+    const auto value_type = value.getType();
+    if (type == "bool" && value_type == XmlRpc::XmlRpcValue::TypeBoolean)
+    {
+      dynamic_reconfigure::BoolParameter parameter;
+      parameter.name = name;
+      parameter.value = static_cast<bool>(value);
+      msg.bools.push_back(parameter);
+    }
+    else if (type == "int" && value_type == XmlRpc::XmlRpcValue::TypeInt)
+    {
+      dynamic_reconfigure::IntParameter parameter;
+      parameter.name = name;
+      parameter.value = static_cast<int>(value);
+      msg.ints.push_back(parameter);
+    }
+    else if (type == "double" &&
+             (value_type == XmlRpc::XmlRpcValue::TypeDouble || value_type == XmlRpc::XmlRpcValue::TypeInt))
+    {
+      dynamic_reconfigure::DoubleParameter parameter;
+      parameter.name = name;
+      parameter.value =
+          value_type == XmlRpc::XmlRpcValue::TypeInt ? static_cast<int>(value) : static_cast<double>(value);
+      msg.doubles.push_back(parameter);
+    }
+    else if (type == "str" && value_type == XmlRpc::XmlRpcValue::TypeString)
+    {
+      dynamic_reconfigure::StrParameter parameter;
+      parameter.name = name;
+      parameter.value = static_cast<std::string>(value);
+      msg.strs.push_back(parameter);
+    }
+    else
+    {
+      throw std::runtime_error(context + "/" + name + " must be of type " + type);
+    }
+  }
+  return msg;
+}
+
+// Calls a function from a ros::CallbackQueue
+class FunctionCallback : public ros::CallbackInterface
+{
+public:
+  explicit FunctionCallback(std::function<void()> function) : function_(std::move(function))
+  {
+  }
+
+  CallResult call() override
+  {
+    function_();
+    return Success;
+  }
+
+private:
+  std::function<void()> function_;
+};
+
 }  // namespace
 
 namespace zivid_camera
@@ -69,11 +210,33 @@ namespace zivid_camera
 ZividCamera::ZividCamera(ros::NodeHandle& nh, ros::NodeHandle& priv)
   : nh_(nh)
   , priv_(priv)
+  , diagnostic_updater_(nh_, priv_)
   , camera_status_(CameraStatus::Idle)
   , use_latched_publisher_for_points_(false)
   , use_latched_publisher_for_color_image_(false)
   , use_latched_publisher_for_depth_image_(false)
+  , lazy_latched_conversion_(false)
+  , shm_transport_enabled_(false)
+  , shm_transport_num_slots_(4)
+  , shm_transport_permissions_(0600)
+  , points_compressed_resolution_(0.0001)
+  , points_compressed_rows_per_band_(64)
+  , points_with_normals_neighbor_distance_(2)
+  , points_stats_parameters_{ 0.0f, 3.0f, 30 }
   , image_transport_(nh_)
+  , preview_depth_reduction_(DepthReduction::Median)
+  , stop_preset_dr_updates_(false)
+  , streaming_priority_(-1)
+  , capture_assistant_priority_(0)
+  , capture_memory_statistics_{}
+  , capture_thread_scheduling_{}
+  , publish_thread_scheduling_{}
+  , capture_to_publish_deadline_(0.0)
+  , num_missed_deadlines_(0)
+  , stop_streaming_(false)
+  , streaming_2d_statistics_{}
+  , streaming_2d_last_diagnostics_statistics_{}
+  , target_frame_timeout_(0.1)
   , header_seq_(0)
 {
   ROS_INFO("Zivid ROS driver version %s", ZIVID_ROS_DRIVER_VERSION);
@@ -104,89 +267,345 @@ ZividCamera::ZividCamera(ros::NodeHandle& nh, ros::NodeHandle& priv)
 
   priv_.param<decltype(frame_id_)>("frame_id", frame_id_, "zivid_optical_frame");
 
+  priv_.param<decltype(target_frame_)>("target_frame", target_frame_, "");
+  priv_.param<double>("target_frame_timeout", target_frame_timeout_, 0.1);
+  if (!target_frame_.empty())
+  {
+    ROS_INFO("Publishing point clouds in frame '%s'", target_frame_.c_str());
+    tf_buffer_ = std::make_unique<tf2_ros::Buffer>();
+    tf_listener_ = std::make_unique<tf2_ros::TransformListener>(*tf_buffer_, nh_);
+  }
+
   std::string file_camera_path;
   priv_.param<decltype(file_camera_path)>("file_camera_path", file_camera_path, "");
-  const bool file_camera_mode = !file_camera_path.empty();
 
   priv_.param<bool>("use_latched_publisher_for_points", use_latched_publisher_for_points_, false);
   priv_.param<bool>("use_latched_publisher_for_color_image", use_latched_publisher_for_color_image_, false);
   priv_.param<bool>("use_latched_publisher_for_depth_image", use_latched_publisher_for_depth_image_, false);
+  priv_.param<bool>("lazy_latched_conversion", lazy_latched_conversion_, false);
+  // The last capture is only kept for the latched topics, so without one it would be kept with nobody to convert it
+  if (lazy_latched_conversion_ && !use_latched_publisher_for_points_ && !use_latched_publisher_for_color_image_ &&
+      !use_latched_publisher_for_depth_image_)
+  {
+    throw std::runtime_error("lazy_latched_conversion requires at least one of use_latched_publisher_for_points, "
+                             "use_latched_publisher_for_color_image and use_latched_publisher_for_depth_image");
+  }
 
-  if (file_camera_mode)
+  priv_.param<bool>("shm_transport_enabled", shm_transport_enabled_, false);
+  // Default to a segment name based on the namespace, e.g. "/zivid_camera_points"
+  priv_.param<decltype(shm_transport_name_)>(
+      "shm_transport_name", shm_transport_name_,
+      "/" + boost::replace_all_copy(nh_.getNamespace().substr(1), "/", "_") + "_points");
+  priv_.param<int>("shm_transport_num_slots", shm_transport_num_slots_, 4);
+  if (shm_transport_enabled_ && shm_transport_num_slots_ < 2)
   {
-    ROS_INFO("Creating file camera from file '%s'", file_camera_path.c_str());
-    camera_ = zivid_.createFileCamera(file_camera_path);
+    throw std::runtime_error("shm_transport_num_slots must be at least 2");
   }
-  else
+  std::string shm_transport_permissions;
+  priv_.param<decltype(shm_transport_permissions)>("shm_transport_permissions", shm_transport_permissions, "0600");
   {
-    auto cameras = zivid_.cameras();
-    ROS_INFO_STREAM(cameras.size() << " cameras found");
-    if (cameras.empty())
+    std::size_t end = 0;
+    unsigned long permissions = 0;
+    try
     {
-      throw std::runtime_error("No cameras found. Ensure that the camera is connected to the USB3 port on your PC.");
+      permissions = std::stoul(shm_transport_permissions, &end, 8);
     }
-    else if (serial_number.empty())
+    catch (const std::logic_error&)
     {
-      camera_ = [&]() {
-        ROS_INFO("Selecting first available camera");
-        for (auto& c : cameras)
-        {
-          if (c.state().isAvailable())
-            return c;
-        }
-        throw std::runtime_error("No available cameras found. Is the camera in use by another process?");
-      }();
+      // Not a number, reported below
     }
-    else
+    if (end == 0 || end != shm_transport_permissions.size() || permissions > 0777)
     {
-      if (serial_number.find(":") == 0)
-      {
-        serial_number = serial_number.substr(1);
-      }
-      camera_ = [&]() {
-        ROS_INFO("Searching for camera with serial number '%s' ...", serial_number.c_str());
-        for (auto& c : cameras)
-        {
-          if (c.serialNumber() == Zivid::SerialNumber(serial_number))
-            return c;
-        }
-        throw std::runtime_error("No camera found with serial number '" + serial_number + "'");
-      }();
+      throw std::runtime_error("shm_transport_permissions must be octal file permissions, for example \"0660\"");
+    }
+    shm_transport_permissions_ = static_cast<mode_t>(permissions);
+  }
+
+  priv_.param<double>("points_compressed_resolution", points_compressed_resolution_, 0.0001);
+  priv_.param<int>("points_compressed_rows_per_band", points_compressed_rows_per_band_, 64);
+  if (points_compressed_resolution_ < 0.0 || points_compressed_rows_per_band_ <= 0)
+  {
+    throw std::runtime_error("points_compressed_resolution must be non-negative and points_compressed_rows_per_band "
+                             "must be positive");
+  }
+
+  priv_.param<int>("points_with_normals_neighbor_distance", points_with_normals_neighbor_distance_, 2);
+  if (points_with_normals_neighbor_distance_ <= 0)
+  {
+    throw std::runtime_error("points_with_normals_neighbor_distance must be positive");
+  }
+
+  double points_stats_z_min;
+  double points_stats_z_max;
+  int points_stats_z_bins;
+  priv_.param<double>("points_stats_z_min", points_stats_z_min, 0.0);
+  priv_.param<double>("points_stats_z_max", points_stats_z_max, 3.0);
+  priv_.param<int>("points_stats_z_bins", points_stats_z_bins, 30);
+  if (points_stats_z_bins <= 0 || points_stats_z_max <= points_stats_z_min)
+  {
+    throw std::runtime_error("points_stats_z_bins must be positive and points_stats_z_max must be larger than "
+                             "points_stats_z_min");
+  }
+  points_stats_parameters_ = { static_cast<float>(points_stats_z_min), static_cast<float>(points_stats_z_max),
+                               static_cast<std::size_t>(points_stats_z_bins) };
+
+  std::vector<int> preview_decimation_factors;
+  priv_.param<std::vector<int>>("preview_decimation_factors", preview_decimation_factors, {});
+  std::string preview_depth_reduction;
+  priv_.param<decltype(preview_depth_reduction)>("preview_depth_reduction", preview_depth_reduction, "median");
+  preview_depth_reduction_ = depthReductionFromString(preview_depth_reduction);
+
+  priv_.param<bool>("memory_bounded_publishing", memory_bounded_publishing_, false);
+
+  bool lock_memory;
+  int prefault_memory_mb;
+  priv_.param<bool>("lock_memory", lock_memory, false);
+  priv_.param<int>("prefault_memory_mb", prefault_memory_mb, 0);
+  if (prefault_memory_mb < 0)
+  {
+    throw std::runtime_error("prefault_memory_mb can not be negative");
+  }
+  if (lock_memory)
+  {
+    if (memory_bounded_publishing_)
+    {
+      throw std::runtime_error("lock_memory keeps freed memory for the next capture, and can not be combined with "
+                               "memory_bounded_publishing");
     }
+    ROS_INFO("Locking the memory of the process, and prefaulting %d MB", prefault_memory_mb);
+    lockProcessMemory(static_cast<std::size_t>(prefault_memory_mb) * 1024 * 1024);
+  }
+
+  std::string capture_thread_cpus;
+  std::string conversion_thread_cpus;
+  std::string publish_thread_cpus;
+  priv_.param<decltype(capture_thread_cpus)>("capture_thread_cpus", capture_thread_cpus, "");
+  priv_.param<decltype(conversion_thread_cpus)>("conversion_thread_cpus", conversion_thread_cpus, "");
+  priv_.param<decltype(publish_thread_cpus)>("publish_thread_cpus", publish_thread_cpus, "");
+  priv_.param<int>("capture_thread_priority", capture_thread_scheduling_.fifo_priority, 0);
+  priv_.param<double>("capture_to_publish_deadline", capture_to_publish_deadline_, 0.0);
+  capture_thread_scheduling_.cpus = parseCpuSet(capture_thread_cpus);
+  publish_thread_scheduling_.cpus = parseCpuSet(publish_thread_cpus);
+  {
+    // Fail at startup, and not at the first capture, if the process is not allowed to use the scheduling
+    const ScopedThreadScheduling check(capture_thread_scheduling_);
+  }
+
+  int conversion_threads;
+  int conversion_chunks_per_thread;
+  priv_.param<int>("conversion_threads", conversion_threads, 0);
+  priv_.param<int>("conversion_chunks_per_thread", conversion_chunks_per_thread, 4);
+  if (conversion_threads < 0 || conversion_chunks_per_thread <= 0)
+  {
+    throw std::runtime_error("conversion_threads can not be negative and conversion_chunks_per_thread must be "
+                             "positive");
+  }
+  thread_pool_ = std::make_unique<ThreadPool>(static_cast<std::size_t>(conversion_threads),
+                                              static_cast<std::size_t>(conversion_chunks_per_thread));
+  ROS_INFO("Using %zu threads for conversion", thread_pool_->numThreads());
+  const ThreadScheduling conversion_thread_scheduling{ parseCpuSet(conversion_thread_cpus), 0 };
+  for (const auto worker : thread_pool_->workerHandles())
+  {
+    applyThreadScheduling(worker, conversion_thread_scheduling);
+  }
+
+  loadProcessors();
 
-    if (!Zivid::Firmware::isUpToDate(camera_))
+  int capture_service_threads;
+  priv_.param<int>("capture_service_threads", capture_service_threads, 4);
+  priv_.param<int>("streaming_priority", streaming_priority_, -1);
+  priv_.param<int>("capture_assistant_priority", capture_assistant_priority_, 0);
+  if (capture_service_threads <= 0)
+  {
+    throw std::runtime_error("capture_service_threads must be positive");
+  }
+  capture_spinner_ = std::make_unique<ros::AsyncSpinner>(static_cast<std::uint32_t>(capture_service_threads),
+                                                         &capture_callback_queue_);
+
+  bool capture_coalescing_enabled;
+  double capture_coalescing_window;
+  priv_.param<bool>("capture_coalescing_enabled", capture_coalescing_enabled, false);
+  priv_.param<double>("capture_coalescing_window", capture_coalescing_window, 0.05);
+  if (capture_coalescing_enabled)
+  {
+    if (capture_coalescing_window < 0.0)
     {
-      ROS_INFO("The camera firmware is not up-to-date, starting update");
-      Zivid::Firmware::update(camera_, [](double progress, const std::string& state) {
-        ROS_INFO("  [%.0f%%] %s", progress, state.c_str());
-      });
-      ROS_INFO("Firmware update completed");
+      throw std::runtime_error("capture_coalescing_window can not be negative");
+    }
+    ROS_INFO("Coalescing capture requests that arrive within %.3f s of an acquisition with the same settings",
+             capture_coalescing_window);
+    capture_coalescer_ = std::make_unique<CaptureCoalescer>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::duration<double>(capture_coalescing_window)));
+  }
+
+  double capture_assistant_cache_ttl;
+  priv_.param<double>("capture_assistant_cache_ttl", capture_assistant_cache_ttl, 0.0);
+  if (capture_assistant_cache_ttl < 0.0)
+  {
+    throw std::runtime_error("capture_assistant_cache_ttl can not be negative");
+  }
+  if (capture_assistant_cache_ttl > 0.0)
+  {
+    ROS_INFO("Caching the settings suggested by the Capture Assistant for %.1f s", capture_assistant_cache_ttl);
+    const auto time_to_live = std::chrono::duration<double>(capture_assistant_cache_ttl);
+    suggested_settings_cache_ =
+        std::make_unique<SuggestedSettingsCache>(std::chrono::duration_cast<std::chrono::nanoseconds>(time_to_live));
+  }
+
+  bool streaming_2d_enabled;
+  priv_.param<bool>("streaming_2d_enabled", streaming_2d_enabled, false);
+
+  bool recording_enabled;
+  priv_.param<bool>("recording_enabled", recording_enabled, false);
+  if (recording_enabled)
+  {
+    std::string recording_format;
+    int recording_threads;
+    int recording_max_queue_mb;
+    int recording_rows_per_chunk;
+    CaptureRecorder::Parameters recorder_parameters{};
+    priv_.param<decltype(recorder_parameters.directory)>("recording_directory", recorder_parameters.directory, "");
+    priv_.param<decltype(recording_format)>("recording_format", recording_format, "chunked");
+    priv_.param<int>("recording_threads", recording_threads, 2);
+    priv_.param<int>("recording_max_queue_mb", recording_max_queue_mb, 1024);
+    priv_.param<int>("recording_rows_per_chunk", recording_rows_per_chunk, 64);
+    if (recorder_parameters.directory.empty())
+    {
+      throw std::runtime_error("recording_directory must be set when recording_enabled is true");
+    }
+    if (recording_threads <= 0 || recording_max_queue_mb <= 0 || recording_rows_per_chunk <= 0)
+    {
+      throw std::runtime_error("recording_threads, recording_max_queue_mb and recording_rows_per_chunk must be "
+                               "positive");
     }
+    recorder_parameters.format = recordingFormatFromString(recording_format);
+    recorder_parameters.num_threads = static_cast<std::size_t>(recording_threads);
+    recorder_parameters.max_queue_bytes = static_cast<std::size_t>(recording_max_queue_mb) * 1024 * 1024;
+    recorder_parameters.rows_per_chunk = static_cast<std::size_t>(recording_rows_per_chunk);
+    ROS_INFO("Recording captures in '%s' format to '%s'", recording_format.c_str(),
+             recorder_parameters.directory.c_str());
+    recorder_ = std::make_unique<CaptureRecorder>(recorder_parameters);
   }
 
-  ROS_INFO_STREAM(camera_);
-  if (!file_camera_mode)
+  bool stream_captures = false;
+  std::string camera_backend;
+  priv_.param<decltype(camera_backend)>("camera_backend", camera_backend, "zivid");
+
+  if (camera_backend == "zivid")
+  {
+    int file_camera_cache_max_mb;
+    priv_.param<int>("file_camera_cache_max_mb", file_camera_cache_max_mb, 0);
+    if (file_camera_cache_max_mb < 0)
+    {
+      throw std::runtime_error("file_camera_cache_max_mb can not be negative");
+    }
+    backend_ = std::make_unique<SdkCameraBackend>(serial_number, file_camera_path, *thread_pool_,
+                                                  static_cast<std::size_t>(file_camera_cache_max_mb) * 1024 * 1024);
+  }
+  else if (camera_backend == "synthetic")
+  {
+    int synthetic_width;
+    int synthetic_height;
+    SyntheticCameraBackend::Parameters synthetic_parameters{};
+    priv_.param<int>("synthetic_width", synthetic_width, 1920);
+    priv_.param<int>("synthetic_height", synthetic_height, 1200);
+    priv_.param<double>("synthetic_nan_ratio", synthetic_parameters.nan_ratio, 0.1);
+    priv_.param<double>("synthetic_frame_rate", synthetic_parameters.frame_rate, 0.0);
+    if (synthetic_width <= 0 || synthetic_height <= 0)
+    {
+      throw std::runtime_error("Invalid synthetic camera resolution " + std::to_string(synthetic_width) + "x" +
+                               std::to_string(synthetic_height));
+    }
+    synthetic_parameters.width = static_cast<std::size_t>(synthetic_width);
+    synthetic_parameters.height = static_cast<std::size_t>(synthetic_height);
+    ROS_INFO("Creating synthetic camera with resolution %dx%d", synthetic_width, synthetic_height);
+    backend_ = std::make_unique<SyntheticCameraBackend>(synthetic_parameters, *thread_pool_);
+  }
+  else if (camera_backend == "playback")
+  {
+    std::string playback_path;
+    std::string playback_mode;
+    PlaybackCameraBackend::Parameters playback_parameters{};
+    priv_.param<decltype(playback_path)>("playback_path", playback_path, "");
+    priv_.param<decltype(playback_parameters.files)>("playback_files", playback_parameters.files, {});
+    priv_.param<double>("playback_rate", playback_parameters.rate, 0.0);
+    priv_.param<bool>("playback_use_recorded_timestamps", playback_parameters.use_recorded_timestamps, false);
+    priv_.param<bool>("playback_loop", playback_parameters.loop, true);
+    priv_.param<decltype(playback_mode)>("playback_mode", playback_mode, "capture");
+    if (!playback_path.empty())
+    {
+      const auto files = playbackFilesFromPath(playback_path);
+      playback_parameters.files.insert(playback_parameters.files.end(), files.begin(), files.end());
+    }
+    if (playback_parameters.files.empty())
+    {
+      throw std::runtime_error("playback_path or playback_files must be set when camera_backend is 'playback'");
+    }
+    if (playback_mode == "streaming")
+    {
+      stream_captures = true;
+    }
+    else if (playback_mode != "capture")
+    {
+      throw std::runtime_error("Unknown playback_mode '" + playback_mode +
+                               "'. Supported values are 'capture' and 'streaming'.");
+    }
+    backend_ = std::make_unique<PlaybackCameraBackend>(playback_parameters);
+  }
+  else
   {
-    ROS_INFO_STREAM("Connecting to camera '" << camera_.serialNumber() << "'");
-    camera_.connect();
+    throw std::runtime_error("Unknown camera_backend '" + camera_backend +
+                             "'. Supported values are 'zivid', 'synthetic' and 'playback'.");
   }
-  ROS_INFO_STREAM("Connected to camera '" << camera_.serialNumber() << "'");
+
+  ROS_INFO_STREAM("Connected to camera '" << backend_->serialNumber() << "'");
   setCameraStatus(CameraStatus::Connected);
 
+  diagnostic_updater_.setHardwareID(backend_->serialNumber());
+  diagnostic_updater_.add("Capture memory", this, &ZividCamera::captureMemoryDiagnostics);
+  diagnostic_updater_.add("Latency", this, &ZividCamera::latencyDiagnostics);
+  diagnostic_updater_.add("Capture scheduler", this, &ZividCamera::captureSchedulerDiagnostics);
+  if (capture_coalescer_)
+  {
+    diagnostic_updater_.add("Capture coalescing", this, &ZividCamera::captureCoalescingDiagnostics);
+  }
+  if (suggested_settings_cache_)
+  {
+    diagnostic_updater_.add("Capture Assistant cache", this, &ZividCamera::suggestedSettingsCacheDiagnostics);
+  }
+  if (!processor_chain_.empty())
+  {
+    diagnostic_updater_.add("Point cloud processors", this, &ZividCamera::processingDiagnostics);
+  }
+  resetPeakResidentMemory();
+  if (recorder_)
+  {
+    diagnostic_updater_.add("Recorder", this, &ZividCamera::recorderDiagnostics);
+  }
+  if (streaming_2d_enabled)
+  {
+    diagnostic_updater_.add("2D streaming", this, &ZividCamera::streaming2DDiagnostics);
+  }
+  diagnostics_timer_ =
+      nh_.createTimer(ros::Duration(1), [this](const ros::TimerEvent&) { diagnostic_updater_.update(); });
+
   camera_connection_keepalive_timer_ =
       nh_.createTimer(ros::Duration(10), &ZividCamera::onCameraConnectionKeepAliveTimeout, this);
 
-  const auto defaultSettings = camera_.settings();
-  capture_general_config_dr_server_ =
-      std::make_unique<CaptureGeneralConfigDRServer>("capture/general", nh_, defaultSettings);
+  const auto defaultSettings = backend_->settings();
+  const auto on_capture_config_reconfigured = [this]() { deactivatePreset("the capture configs have changed"); };
+  capture_general_config_dr_server_ = std::make_unique<CaptureGeneralConfigDRServer>(
+      "capture/general", nh_, defaultSettings, on_capture_config_reconfigured);
 
   ROS_INFO("Setting up %d capture/frame_<n> dynamic_reconfigure servers", num_capture_frames);
   for (int i = 0; i < num_capture_frames; i++)
   {
-    capture_frame_config_dr_servers_.push_back(
-        std::make_unique<CaptureFrameConfigDRServer>("capture/frame_" + std::to_string(i), nh_, defaultSettings));
+    capture_frame_config_dr_servers_.push_back(std::make_unique<CaptureFrameConfigDRServer>(
+        "capture/frame_" + std::to_string(i), nh_, defaultSettings, on_capture_config_reconfigured));
   }
 
+  loadPresets();
+
   // HDR is not supported in 2D mode, but for future-proofing the 2D configuration API is analogous
   // to 3D except there is only 1 frame.
   ROS_INFO("Setting up 1 capture_2d/frame_<n> dynamic_reconfigure server");
@@ -194,11 +613,48 @@ ZividCamera::ZividCamera(ros::NodeHandle& nh, ros::NodeHandle& priv)
       std::make_unique<Capture2DFrameConfigDRServer>("capture_2d/frame_0", nh_, Zivid::Settings2D{}));
 
   ROS_INFO("Advertising topics");
-  points_publisher_ = nh_.advertise<sensor_msgs::PointCloud2>("points", 1, use_latched_publisher_for_points_);
-  color_image_publisher_ =
-      image_transport_.advertiseCamera("color/image_color", 1, use_latched_publisher_for_color_image_);
-  depth_image_publisher_ =
-      image_transport_.advertiseCamera("depth/image_raw", 1, use_latched_publisher_for_depth_image_);
+  if (lazy_latched_conversion_)
+  {
+    advertiseLazyLatchedTopics();
+  }
+  else
+  {
+    points_publisher_ = nh_.advertise<sensor_msgs::PointCloud2>("points", 1, use_latched_publisher_for_points_);
+    compressed_points_publisher_ =
+        nh_.advertise<CompressedPointCloud>("points/compressed", 1, use_latched_publisher_for_points_);
+    color_image_publisher_ =
+        image_transport_.advertiseCamera("color/image_color", 1, use_latched_publisher_for_color_image_);
+    depth_image_publisher_ =
+        image_transport_.advertiseCamera("depth/image_raw", 1, use_latched_publisher_for_depth_image_);
+  }
+  points_with_normals_publisher_ = nh_.advertise<sensor_msgs::PointCloud2>("points_with_normals", 1);
+  points_stats_publisher_ = nh_.advertise<PointCloudStats>("points/stats", 1);
+  // The rectified images share camera_info with the raw images, following the image_proc convention
+  color_image_rect_publisher_ = image_transport_.advertise("color/image_rect", 1);
+  depth_image_rect_publisher_ = image_transport_.advertise("depth/image_rect", 1);
+  if (streaming_2d_enabled)
+  {
+    streaming_2d_image_publisher_ = nh_.advertise<ZividImageMessage>("stream_2d/image_color", 1);
+    streaming_2d_camera_info_publisher_ = nh_.advertise<sensor_msgs::CameraInfo>("stream_2d/camera_info", 1);
+  }
+
+  // Sorted by factor, so that coarser levels can be computed from finer levels
+  std::sort(preview_decimation_factors.begin(), preview_decimation_factors.end());
+  preview_decimation_factors.erase(std::unique(preview_decimation_factors.begin(), preview_decimation_factors.end()),
+                                   preview_decimation_factors.end());
+  for (const auto factor : preview_decimation_factors)
+  {
+    if (factor < 2)
+    {
+      throw std::runtime_error("Invalid preview decimation factor " + std::to_string(factor) +
+                               ". The factors must be at least 2.");
+    }
+    const auto prefix = "preview/" + std::to_string(factor) + "/";
+    preview_levels_.push_back(
+        PreviewLevel{ static_cast<std::size_t>(factor), nh_.advertise<sensor_msgs::PointCloud2>(prefix + "points", 1),
+                      image_transport_.advertiseCamera(prefix + "color/image_color", 1),
+                      image_transport_.advertiseCamera(prefix + "depth/image_raw", 1) });
+  }
 
   ROS_INFO("Advertising services");
   camera_info_model_name_service_ =
@@ -206,12 +662,262 @@ ZividCamera::ZividCamera(ros::NodeHandle& nh, ros::NodeHandle& priv)
   camera_info_serial_number_service_ =
       nh_.advertiseService("camera_info/serial_number", &ZividCamera::cameraInfoSerialNumberServiceHandler, this);
   is_connected_service_ = nh_.advertiseService("is_connected", &ZividCamera::isConnectedServiceHandler, this);
-  capture_service_ = nh_.advertiseService("capture", &ZividCamera::captureServiceHandler, this);
-  capture_2d_service_ = nh_.advertiseService("capture_2d", &ZividCamera::capture2DServiceHandler, this);
-  capture_assistant_suggest_settings_service_ = nh_.advertiseService(
-      "capture_assistant/suggest_settings", &ZividCamera::captureAssistantSuggestSettingsServiceHandler, this);
+  select_preset_service_ = nh_.advertiseService("select_preset", &ZividCamera::selectPresetServiceHandler, this);
+  save_preset_service_ = nh_.advertiseService("save_preset", &ZividCamera::savePresetServiceHandler, this);
+  capture_service_ = advertiseCaptureService<Capture>("capture", &ZividCamera::captureServiceHandler);
+  capture_scheduled_service_ = advertiseCaptureService<CaptureScheduled>(
+      "capture_scheduled", &ZividCamera::captureScheduledServiceHandler);
+  capture_with_settings_service_ = advertiseCaptureService<CaptureWithSettings>(
+      "capture_with_settings", &ZividCamera::captureWithSettingsServiceHandler);
+  capture_2d_service_ = advertiseCaptureService<Capture2D>("capture_2d", &ZividCamera::capture2DServiceHandler);
+  capture_2d_scheduled_service_ = advertiseCaptureService<Capture2DScheduled>(
+      "capture_2d_scheduled", &ZividCamera::capture2DScheduledServiceHandler);
+  capture_both_service_ =
+      advertiseCaptureService<CaptureBoth>("capture_both", &ZividCamera::captureBothServiceHandler);
+  capture_assistant_suggest_settings_service_ = advertiseCaptureService<CaptureAssistantSuggestSettings>(
+      "capture_assistant/suggest_settings", &ZividCamera::captureAssistantSuggestSettingsServiceHandler);
+  capture_assistant_suggest_settings_cached_service_ = advertiseCaptureService<CaptureAssistantSuggestSettingsCached>(
+      "capture_assistant/suggest_settings_cached", &ZividCamera::captureAssistantSuggestSettingsCachedServiceHandler);
+  if (suggested_settings_cache_)
+  {
+    capture_assistant_clear_cache_service_ = nh_.advertiseService(
+        "capture_assistant/clear_cache", &ZividCamera::clearSuggestedSettingsCacheServiceHandler, this);
+  }
+
+  ros::NodeHandle capture_action_nh(nh_);
+  capture_action_nh.setCallbackQueue(&capture_action_callback_queue_);
+  capture_action_server_ = std::make_unique<actionlib::ActionServer<CaptureAction>>(
+      capture_action_nh, "capture_action", [this](CaptureGoalHandle goal) { onCaptureGoal(goal); },
+      [this](CaptureGoalHandle goal) { onCaptureGoalCancel(goal); }, false);
+  capture_action_server_->start();
+  capture_action_spinner_ = std::make_unique<ros::AsyncSpinner>(1, &capture_action_callback_queue_);
+
+  preset_dr_update_thread_ = std::thread(&ZividCamera::presetDRUpdateThread, this);
+  capture_spinner_->start();
+  capture_action_spinner_->start();
 
   ROS_INFO("Zivid camera driver is now ready!");
+
+  if (stream_captures)
+  {
+    ROS_INFO("Starting to stream captures");
+    streaming_thread_ = std::thread(&ZividCamera::streamingThread, this);
+  }
+
+  if (streaming_2d_enabled)
+  {
+    ROS_INFO("Starting to stream 2D captures when stream_2d/image_color has subscribers");
+    streaming_2d_last_diagnostics_time_ = std::chrono::steady_clock::now();
+    streaming_2d_capture_thread_ = std::thread(&ZividCamera::streaming2DCaptureThread, this);
+    streaming_2d_publish_thread_ = std::thread(&ZividCamera::streaming2DPublishThread, this);
+  }
+}
+
+void ZividCamera::advertiseLazyLatchedTopics()
+{
+  // The latched topics are emulated by publishing the latest capture to each subscriber when it connects. The
+  // messages are only converted when the first subscriber connects.
+  if (use_latched_publisher_for_points_)
+  {
+    points_publisher_ = nh_.advertise<sensor_msgs::PointCloud2>(
+        "points", 1, [this](const ros::SingleSubscriberPublisher& publisher) { onPointsSubscriberConnect(publisher); });
+    compressed_points_publisher_ =
+        nh_.advertise<CompressedPointCloud>("points/compressed", 1, [this](const ros::SingleSubscriberPublisher& pub) {
+          onCompressedPointsSubscriberConnect(pub);
+        });
+  }
+  else
+  {
+    points_publisher_ = nh_.advertise<sensor_msgs::PointCloud2>("points", 1);
+    compressed_points_publisher_ = nh_.advertise<CompressedPointCloud>("points/compressed", 1);
+  }
+
+  if (use_latched_publisher_for_color_image_)
+  {
+    color_image_publisher_ = image_transport_.advertiseCamera(
+        "color/image_color", 1,
+        [this](const image_transport::SingleSubscriberPublisher& pub) { onColorImageSubscriberConnect(pub); },
+        image_transport::SubscriberStatusCallback(),
+        [this](const ros::SingleSubscriberPublisher& publisher) { onColorCameraInfoSubscriberConnect(publisher); });
+  }
+  else
+  {
+    color_image_publisher_ = image_transport_.advertiseCamera("color/image_color", 1);
+  }
+
+  if (use_latched_publisher_for_depth_image_)
+  {
+    depth_image_publisher_ = image_transport_.advertiseCamera(
+        "depth/image_raw", 1,
+        [this](const image_transport::SingleSubscriberPublisher& pub) { onDepthImageSubscriberConnect(pub); },
+        image_transport::SubscriberStatusCallback(),
+        [this](const ros::SingleSubscriberPublisher& publisher) { onDepthCameraInfoSubscriberConnect(publisher); });
+  }
+  else
+  {
+    depth_image_publisher_ = image_transport_.advertiseCamera("depth/image_raw", 1);
+  }
+}
+
+ZividCamera::~ZividCamera()
+{
+  if (capture_action_spinner_)
+  {
+    capture_action_spinner_->stop();
+  }
+  if (capture_spinner_)
+  {
+    capture_spinner_->stop();
+  }
+  {
+    std::lock_guard<std::mutex> lock(streaming_2d_mutex_);
+    stop_streaming_ = true;
+  }
+  streaming_2d_image_available_.notify_all();
+  {
+    std::lock_guard<std::mutex> lock(presets_mutex_);
+    stop_preset_dr_updates_ = true;
+  }
+  preset_dr_update_requested_.notify_all();
+  for (auto* thread : { &streaming_thread_, &streaming_2d_capture_thread_, &streaming_2d_publish_thread_,
+                        &preset_dr_update_thread_ })
+  {
+    if (thread->joinable())
+    {
+      thread->join();
+    }
+  }
+}
+
+void ZividCamera::streamingThread()
+{
+  // The settings are not used when playing back recorded captures
+  const std::vector<Zivid::Settings> settings{ backend_->settings() };
+  while (!stop_streaming_ && ros::ok())
+  {
+    try
+    {
+      capture_scheduler_.run({ streaming_priority_, std::nullopt }, [&]() { publishFrame(captureFrame(settings)); });
+    }
+    catch (const std::exception& e)
+    {
+      ROS_INFO("Stopped streaming captures: %s", e.what());
+      return;
+    }
+  }
+}
+
+void ZividCamera::streaming2DCaptureThread()
+{
+  // The intrinsics do not change while streaming, so they are only read once
+  std::optional<Zivid::CameraIntrinsics> intrinsics;
+  while (!stop_streaming_ && ros::ok())
+  {
+    if (streaming_2d_image_publisher_.getNumSubscribers() == 0 &&
+        streaming_2d_camera_info_publisher_.getNumSubscribers() == 0)
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+      continue;
+    }
+
+    try
+    {
+      // The settings are read for every capture, so that changes to capture_2d/frame_0 take effect immediately
+      const auto settings2D = capture2DSettings();
+      auto msg = boost::make_shared<ZividImageMessage>();
+      capture_scheduler_.run({ streaming_priority_, std::nullopt }, [&]() {
+        if (!intrinsics)
+        {
+          intrinsics = backend_->intrinsics();
+        }
+        msg->image = std::make_shared<const Zivid::Image<Zivid::RGBA8>>(captureImage2D(settings2D));
+        msg->header = makeHeader();
+      });
+      auto camera_info = makeCameraInfo(msg->header, msg->image->width(), msg->image->height(), *intrinsics);
+
+      // Hand the image over to the publishing thread. If it is still busy with the previous image, that image is
+      // replaced, so that slow subscribers never slow down the capture loop.
+      {
+        std::lock_guard<std::mutex> lock(streaming_2d_mutex_);
+        streaming_2d_statistics_.num_captured++;
+        if (streaming_2d_pending_image_)
+        {
+          streaming_2d_statistics_.num_dropped++;
+        }
+        streaming_2d_pending_image_ = std::move(msg);
+        streaming_2d_pending_camera_info_ = std::move(camera_info);
+      }
+      streaming_2d_image_available_.notify_one();
+    }
+    catch (const std::exception& e)
+    {
+      ROS_WARN_THROTTLE(10, "2D streaming capture failed: %s", e.what());
+      std::this_thread::sleep_for(std::chrono::seconds(1));
+    }
+  }
+}
+
+void ZividCamera::streaming2DPublishThread()
+{
+  // The scheduling was checked at startup, and the thread only publishes, so it keeps the scheduling
+  try
+  {
+    applyThreadScheduling(pthread_self(), publish_thread_scheduling_);
+  }
+  catch (const std::exception& e)
+  {
+    ROS_WARN("Failed to apply the publish thread scheduling to the 2D streaming thread: %s", e.what());
+  }
+
+  while (true)
+  {
+    std::unique_lock<std::mutex> lock(streaming_2d_mutex_);
+    streaming_2d_image_available_.wait(lock, [this] { return stop_streaming_ || streaming_2d_pending_image_; });
+    if (stop_streaming_)
+    {
+      return;
+    }
+    const ZividImageMessageConstPtr image = std::move(streaming_2d_pending_image_);
+    const auto camera_info = std::move(streaming_2d_pending_camera_info_);
+    lock.unlock();
+
+    // The image is serialized straight from the Zivid::Image buffer
+    streaming_2d_image_publisher_.publish(image);
+    streaming_2d_camera_info_publisher_.publish(camera_info);
+
+    lock.lock();
+    streaming_2d_statistics_.num_published++;
+  }
+}
+
+void ZividCamera::streaming2DDiagnostics(diagnostic_updater::DiagnosticStatusWrapper& status)
+{
+  Streaming2DStatistics statistics;
+  {
+    std::lock_guard<std::mutex> lock(streaming_2d_mutex_);
+    statistics = streaming_2d_statistics_;
+  }
+
+  const auto now = std::chrono::steady_clock::now();
+  const auto elapsed = std::chrono::duration<double>(now - streaming_2d_last_diagnostics_time_).count();
+  const auto num_published = statistics.num_published - streaming_2d_last_diagnostics_statistics_.num_published;
+  const auto fps = elapsed > 0.0 ? static_cast<double>(num_published) / elapsed : 0.0;
+  const auto num_dropped = statistics.num_dropped - streaming_2d_last_diagnostics_statistics_.num_dropped;
+  streaming_2d_last_diagnostics_time_ = now;
+  streaming_2d_last_diagnostics_statistics_ = statistics;
+
+  if (num_dropped > 0)
+  {
+    status.summary(diagnostic_msgs::DiagnosticStatus::WARN, "Images dropped because publishing is too slow");
+  }
+  else
+  {
+    status.summary(diagnostic_msgs::DiagnosticStatus::OK, fps > 0.0 ? "Streaming" : "Idle");
+  }
+  status.add("Frame rate", fps);
+  status.add("Captured images", statistics.num_captured);
+  status.add("Published images", statistics.num_published);
+  status.add("Dropped images", statistics.num_dropped);
 }
 
 void ZividCamera::onCameraConnectionKeepAliveTimeout(const ros::TimerEvent&)
@@ -227,289 +933,1357 @@ void ZividCamera::onCameraConnectionKeepAliveTimeout(const ros::TimerEvent&)
   }
 }
 
-void ZividCamera::reconnectToCameraIfNecessary()
+void ZividCamera::reconnectToCameraIfNecessary()
+{
+  ROS_DEBUG_STREAM(__func__ << ", threadid=" << std::this_thread::get_id());
+
+  // The reconnect replaces the camera handle of the backend, so it must not run while a capture uses the camera
+  capture_scheduler_.run({ camera_reconnect_priority, std::nullopt }, [this]() {
+    if (backend_->isConnected())
+    {
+      setCameraStatus(CameraStatus::Connected);
+    }
+    else
+    {
+      setCameraStatus(CameraStatus::Disconnected);
+      if (backend_->reconnectIfAvailable())
+      {
+        setCameraStatus(CameraStatus::Connected);
+      }
+    }
+  });
+}
+
+void ZividCamera::setCameraStatus(CameraStatus camera_status)
+{
+  if (camera_status_ != camera_status)
+  {
+    std::stringstream ss;
+    ss << "Camera status changed to " << toString(camera_status) << " (was " << toString(camera_status_) << ")";
+    if (camera_status == CameraStatus::Connected)
+    {
+      ROS_INFO_STREAM(ss.str());
+    }
+    else
+    {
+      ROS_WARN_STREAM(ss.str());
+    }
+    camera_status_ = camera_status;
+  }
+}
+
+bool ZividCamera::cameraInfoModelNameServiceHandler(zivid_camera::CameraInfoModelName::Request&,
+                                                    zivid_camera::CameraInfoModelName::Response& res)
+{
+  res.model_name = backend_->modelName();
+  return true;
+}
+
+bool ZividCamera::cameraInfoSerialNumberServiceHandler(zivid_camera::CameraInfoSerialNumber::Request&,
+                                                       zivid_camera::CameraInfoSerialNumber::Response& res)
+{
+  res.serial_number = backend_->serialNumber();
+  return true;
+}
+
+bool ZividCamera::captureServiceHandler(Capture::Request&, Capture::Response&)
+{
+  ROS_DEBUG_STREAM(__func__ << ", threadid=" << std::this_thread::get_id());
+
+  serviceHandlerHandleCameraConnectionLoss();
+
+  capture(captureSettings(), 0, ros::Duration());
+  return true;
+}
+
+bool ZividCamera::captureScheduledServiceHandler(CaptureScheduled::Request& req, CaptureScheduled::Response&)
+{
+  ROS_DEBUG_STREAM(__func__ << ", threadid=" << std::this_thread::get_id());
+
+  serviceHandlerHandleCameraConnectionLoss();
+
+  capture(captureSettings(), req.priority, req.deadline);
+  return true;
+}
+
+bool ZividCamera::captureWithSettingsServiceHandler(CaptureWithSettings::Request& req, CaptureWithSettings::Response&)
+{
+  ROS_DEBUG_STREAM(__func__);
+
+  serviceHandlerHandleCameraConnectionLoss();
+
+  if (req.frames.empty() || req.frames.size() > capture_frame_config_dr_servers_.size())
+  {
+    throw std::runtime_error("capture_with_settings needs between 1 and " +
+                             std::to_string(capture_frame_config_dr_servers_.size()) + " frames, got " +
+                             std::to_string(req.frames.size()));
+  }
+  std::vector<CaptureFrameConfig> frame_configs;
+  frame_configs.reserve(req.frames.size());
+  for (std::size_t i = 0; i < req.frames.size(); i++)
+  {
+    frame_configs.push_back(capture_frame_config_dr_servers_[i]->configFromMessage(req.frames[i]));
+  }
+  const auto general_config = capture_general_config_dr_server_->configFromMessage(req.general);
+
+  const auto settings = captureSettings(general_config, frame_configs);
+  ROS_INFO("Capturing with %zd frames from the request", settings.size());
+  capture(settings, req.priority, req.deadline);
+  return true;
+}
+
+void ZividCamera::capture(const std::vector<Zivid::Settings>& settings, std::int32_t priority,
+                          const ros::Duration& deadline)
+{
+  const auto request = toSchedulerRequest(priority, deadline);
+  const auto run_exclusive = [this, &request](const std::function<void()>& job) {
+    capture_scheduler_.run(request, job);
+  };
+  if (capture_coalescer_)
+  {
+    // Only requests with the same priority share an acquisition, so that a request never waits behind requests with a
+    // lower priority. The deadline of the request that started the acquisition applies to all of them.
+    const auto key = std::to_string(priority) + "\n" + captureCoalescingKey(settings);
+    capture_coalescer_->request(key, run_exclusive, [&]() { publishFrame(captureFrame(settings)); });
+    return;
+  }
+  run_exclusive([&]() { publishFrame(captureFrame(settings)); });
+}
+
+bool ZividCamera::capture2DServiceHandler(Capture2D::Request&, Capture2D::Response&)
+{
+  ROS_DEBUG_STREAM(__func__);
+
+  serviceHandlerHandleCameraConnectionLoss();
+
+  capture2D(0, ros::Duration());
+  return true;
+}
+
+bool ZividCamera::capture2DScheduledServiceHandler(Capture2DScheduled::Request& req, Capture2DScheduled::Response&)
+{
+  ROS_DEBUG_STREAM(__func__);
+
+  serviceHandlerHandleCameraConnectionLoss();
+
+  capture2D(req.priority, req.deadline);
+  return true;
+}
+
+void ZividCamera::capture2D(std::int32_t priority, const ros::Duration& deadline)
+{
+  const auto settings2D = capture2DSettings();
+  capture_scheduler_.run(toSchedulerRequest(priority, deadline), [&]() {
+    const auto image = captureImage2D(settings2D);
+    publishColorImage2D(makeHeader(), image, backend_->intrinsics());
+  });
+}
+
+bool ZividCamera::captureBothServiceHandler(CaptureBoth::Request& req, CaptureBoth::Response&)
+{
+  ROS_DEBUG_STREAM(__func__);
+
+  serviceHandlerHandleCameraConnectionLoss();
+
+  const auto settings = captureSettings();
+  const auto settings2D = capture2DSettings();
+  capture_scheduler_.run(toSchedulerRequest(req.priority, req.deadline),
+                         [&]() { captureBoth(settings, settings2D); });
+  return true;
+}
+
+void ZividCamera::captureBoth(const std::vector<Zivid::Settings>& settings, const Zivid::Settings2D& settings2D)
+{
+  // The 2D image is converted and published while the camera performs the 3D capture. The intrinsics are read before
+  // the 3D capture starts, so that the camera is only used from this thread.
+  const auto intrinsics = backend_->intrinsics();
+  const auto image = captureImage2D(settings2D);
+  const auto header = makeHeader();
+  auto publish_2d = std::async(std::launch::async, [&] { publishColorImage2D(header, image, intrinsics); });
+  auto frame = captureFrame(settings);
+  publish_2d.get();
+
+  // The color image of this capture is the 2D image, so it is not converted from the point cloud
+  publishFrame(std::move(frame), header, false);
+}
+
+void ZividCamera::onCaptureGoal(CaptureGoalHandle goal)
+{
+  ROS_DEBUG_STREAM(__func__ << ", goal id=" << goal.getGoalID().id);
+
+  const auto cancelled = std::make_shared<std::atomic<bool>>(false);
+  {
+    std::lock_guard<std::mutex> lock(capture_goals_mutex_);
+    capture_goals_cancelled_[goal.getGoalID().id] = cancelled;
+  }
+  // The goal is accepted right away, and waits for the camera on the capture callback queue like the service requests
+  goal.setAccepted();
+  capture_callback_queue_.addCallback(boost::make_shared<FunctionCallback>([this, goal, cancelled]() {
+    executeCaptureGoal(goal, *cancelled);
+    std::lock_guard<std::mutex> lock(capture_goals_mutex_);
+    capture_goals_cancelled_.erase(goal.getGoalID().id);
+  }));
+}
+
+void ZividCamera::onCaptureGoalCancel(CaptureGoalHandle goal)
+{
+  ROS_DEBUG_STREAM(__func__ << ", goal id=" << goal.getGoalID().id);
+
+  std::lock_guard<std::mutex> lock(capture_goals_mutex_);
+  const auto it = capture_goals_cancelled_.find(goal.getGoalID().id);
+  if (it != capture_goals_cancelled_.end())
+  {
+    *it->second = true;
+    capture_scheduler_.notifyCancelled();
+  }
+}
+
+void ZividCamera::executeCaptureGoal(CaptureGoalHandle goal, const std::atomic<bool>& cancelled)
+{
+  CaptureResult result;
+  bool started = false;
+  try
+  {
+    serviceHandlerHandleCameraConnectionLoss();
+
+    const auto settings = captureSettings();
+    const auto request = goal.getGoal();
+    capture_scheduler_.run(
+        toSchedulerRequest(request->priority, request->deadline),
+        [&]() {
+          started = true;
+          auto frame = captureFrame(settings);
+          CaptureFeedback feedback;
+          feedback.stage = CaptureFeedback::ACQUIRED;
+          goal.publishFeedback(feedback);
+
+          result.header = makeHeader(frame.timestamp);
+          publishFrame(std::move(frame), result.header);
+          feedback.stage = CaptureFeedback::PUBLISHED;
+          goal.publishFeedback(feedback);
+        },
+        cancelled);
+    goal.setSucceeded(result);
+  }
+  catch (const std::exception& e)
+  {
+    // A goal that is cancelled after its capture has started runs to completion
+    if (cancelled && !started)
+    {
+      goal.setCanceled(result);
+      return;
+    }
+    ROS_ERROR_STREAM("Capture goal " << goal.getGoalID().id << " failed: " << e.what());
+    goal.setAborted(result, e.what());
+  }
+}
+
+std::vector<Zivid::Settings> ZividCamera::captureSettings()
+{
+  std::shared_ptr<const CapturePreset> preset;
+  {
+    std::lock_guard<std::mutex> lock(presets_mutex_);
+    preset = active_preset_;
+  }
+  if (preset)
+  {
+    ROS_INFO("Capturing with preset '%s' (%zd frames)", preset->name.c_str(), preset->settings.size());
+    return preset->settings;
+  }
+
+  std::vector<CaptureFrameConfig> frame_configs;
+  for (const auto& dr_config_server : capture_frame_config_dr_servers_)
+  {
+    const auto config = dr_config_server->config();
+    if (config.enabled)
+    {
+      ROS_DEBUG("Config %s is enabled", dr_config_server->name().c_str());
+      frame_configs.push_back(config);
+    }
+  }
+  auto settings = captureSettings(capture_general_config_dr_server_->config(), frame_configs);
+  ROS_INFO("Capturing with %zd frames", settings.size());
+  return settings;
+}
+
+std::vector<Zivid::Settings> ZividCamera::captureSettings(const CaptureGeneralConfig& general_config,
+                                                          const std::vector<CaptureFrameConfig>& frame_configs)
+{
+  std::vector<Zivid::Settings> settings;
+
+  Zivid::Settings base_setting = backend_->settings();
+  applyCaptureGeneralConfigToZividSettings(general_config, base_setting);
+
+  for (const auto& frame_config : frame_configs)
+  {
+    Zivid::Settings s{ base_setting };
+    applyCaptureFrameConfigToZividSettings(frame_config, s);
+    settings.push_back(std::move(s));
+  }
+
+  if (settings.size() == 0)
+  {
+    throw std::runtime_error("Capture called with 0 enabled frames!");
+  }
+
+  for (std::size_t i = 0; i < settings.size(); i++)
+  {
+    ROS_DEBUG_STREAM("Setting " << i << ": " << settings[i]);
+  }
+  return settings;
+}
+
+Zivid::Settings2D ZividCamera::capture2DSettings()
+{
+  if (capture_2d_frame_config_dr_servers_.empty())
+  {
+    throw std::runtime_error("Internal error: capture_2d_frame_config_dr_servers_ empty");
+  }
+
+  if (!capture_2d_frame_config_dr_servers_[0]->config().enabled)
+  {
+    // 2D capture API in SDK currently only supports single-capture (1 frame). However, we still
+    // verify that frame_0/enabled is set. This is for future-proofing and consistency with 3D API.
+    throw std::runtime_error("Failed to capture: capture_2d/frame_0/enabled is false! Set enabled to true.");
+  }
+
+  Zivid::Settings2D settings2D;
+  applyCapture2DFrameConfigToZividSettings(capture_2d_frame_config_dr_servers_[0]->config(), settings2D);
+  return settings2D;
+}
+
+CapturedFrame ZividCamera::captureFrame(const std::vector<Zivid::Settings>& settings)
+{
+  const ScopedThreadScheduling scheduling(capture_thread_scheduling_);
+  capture_start_time_ = std::chrono::steady_clock::now();
+  auto frame = backend_->capture(settings);
+  capture_latency_.add(std::chrono::steady_clock::now() - capture_start_time_);
+  return frame;
+}
+
+Zivid::Image<Zivid::RGBA8> ZividCamera::captureImage2D(const Zivid::Settings2D& settings2D)
+{
+  const ScopedThreadScheduling scheduling(capture_thread_scheduling_);
+  return backend_->capture2D(settings2D);
+}
+
+void ZividCamera::publishColorImage2D(const std_msgs::Header& header, const Zivid::Image<Zivid::RGBA8>& image,
+                                      const Zivid::CameraIntrinsics& intrinsics)
+{
+  // In lazy mode the 2D image is kept for subscribers that connect later. It is cheap to convert.
+  const bool publish_color_img =
+      shouldPublishColorImg() || (lazy_latched_conversion_ && use_latched_publisher_for_color_image_);
+  const bool publish_color_img_rect = color_image_rect_publisher_.getNumSubscribers() > 0;
+  if (publish_color_img || publish_color_img_rect)
+  {
+    ROS_DEBUG("Publishing color image");
+    const auto camera_info = makeCameraInfo(header, image.width(), image.height(), intrinsics);
+    const auto color_image = makeColorImage(header, image);
+    if (publish_color_img)
+    {
+      color_image_publisher_.publish(color_image, camera_info);
+    }
+    if (publish_color_img_rect)
+    {
+      color_image_rect_publisher_.publish(makeRectifiedImage(*color_image, intrinsics));
+    }
+    if (lazy_latched_conversion_ && use_latched_publisher_for_color_image_)
+    {
+      std::lock_guard<std::mutex> latest_capture_lock(latest_capture_mutex_);
+      latest_capture_.color_image = color_image;
+      latest_capture_.color_camera_info = camera_info;
+    }
+  }
+}
+
+bool ZividCamera::captureAssistantSuggestSettingsServiceHandler(CaptureAssistantSuggestSettings::Request& req,
+                                                                CaptureAssistantSuggestSettings::Response&)
+{
+  ROS_DEBUG_STREAM(__func__ << ": Request: " << req);
+
+  suggestSettings(req.max_capture_time, req.ambient_light_frequency, "", false);
+  return true;
+}
+
+bool ZividCamera::captureAssistantSuggestSettingsCachedServiceHandler(
+    CaptureAssistantSuggestSettingsCached::Request& req, CaptureAssistantSuggestSettingsCached::Response& res)
+{
+  ROS_DEBUG_STREAM(__func__ << ": Request: " << req);
+
+  res.from_cache = suggestSettings(req.max_capture_time, req.ambient_light_frequency, req.scene_tag, req.refresh);
+  return true;
+}
+
+bool ZividCamera::suggestSettings(const ros::Duration& max_capture_time_duration,
+                                  std::uint8_t ambient_light_frequency_value, const std::string& scene_tag,
+                                  bool refresh)
+{
+  const auto max_capture_time = std::chrono::round<std::chrono::milliseconds>(
+      std::chrono::duration<double>{ max_capture_time_duration.toSec() });
+  const auto ambient_light_frequency = [ambient_light_frequency_value]() {
+    switch (ambient_light_frequency_value)
+    {
+      case CaptureAssistantSuggestSettings::Request::AMBIENT_LIGHT_FREQUENCY_NONE:
+        return Zivid::CaptureAssistant::AmbientLightFrequency::none;
+      case CaptureAssistantSuggestSettings::Request::AMBIENT_LIGHT_FREQUENCY_50HZ:
+        return Zivid::CaptureAssistant::AmbientLightFrequency::hz50;
+      case CaptureAssistantSuggestSettings::Request::AMBIENT_LIGHT_FREQUENCY_60HZ:
+        return Zivid::CaptureAssistant::AmbientLightFrequency::hz60;
+    }
+    throw std::runtime_error("Unhandled AMBIENT_LIGHT_FREQUENCY value: " +
+                             std::to_string(ambient_light_frequency_value));
+  }();
+
+  Zivid::CaptureAssistant::SuggestSettingsParameters suggest_settings_parameters(max_capture_time,
+                                                                                 ambient_light_frequency);
+
+  const SuggestedSettingsKey cache_key{ max_capture_time, ambient_light_frequency_value, scene_tag };
+  std::vector<Zivid::Settings> suggested_settings;
+  bool from_cache = false;
+  if (suggested_settings_cache_ && !refresh)
+  {
+    if (auto cached = suggested_settings_cache_->get(cache_key, std::chrono::steady_clock::now()))
+    {
+      ROS_INFO_STREAM("Using the cached suggested settings for parameters: " << suggest_settings_parameters
+                                                                             << ", scene tag: '" << scene_tag << "'");
+      suggested_settings = std::move(*cached);
+      from_cache = true;
+    }
+  }
+
+  if (!from_cache)
+  {
+    serviceHandlerHandleCameraConnectionLoss();
+
+    ROS_INFO_STREAM("Getting suggested settings using parameters: " << suggest_settings_parameters);
+    // Suggesting settings captures with the camera, so it is scheduled like the captures
+    capture_scheduler_.run(toSchedulerRequest(capture_assistant_priority_, ros::Duration()),
+                           [&]() { suggested_settings = backend_->suggestSettings(suggest_settings_parameters); });
+
+    if (suggested_settings.empty())
+    {
+      throw std::runtime_error("The suggestSettings function returned 0 settings!");
+    }
+    if (suggested_settings.size() > capture_frame_config_dr_servers_.size())
+    {
+      throw std::runtime_error("The number of suggested settings (" + std::to_string(suggested_settings.size()) +
+                               ") is larger than the number of dynamic_reconfigure capture/frame_<n> servers (" +
+                               std::to_string(capture_frame_config_dr_servers_.size()) +
+                               "). Increase launch parameter num_capture_frames. See README.md for more "
+                               "information.");
+    }
+
+    ROS_INFO_STREAM("CaptureAssistant::suggestSettings returned " << suggested_settings.size() << " settings");
+    if (suggested_settings_cache_)
+    {
+      suggested_settings_cache_->put(cache_key, suggested_settings, std::chrono::steady_clock::now());
+    }
+  }
+
+  std::vector<CaptureFrameConfig> frame_configs;
+  for (std::size_t i = 0; i < suggested_settings.size(); i++)
+  {
+    ROS_DEBUG_STREAM("Updating setting " << i << " to " << suggested_settings[i]);
+    frame_configs.push_back(zividSettingsToConfig<CaptureFrameConfig>(suggested_settings[i]));
+  }
+  deactivatePreset("the Capture Assistant has suggested new settings");
+  std::lock_guard<std::mutex> lock(capture_config_update_mutex_);
+  setCaptureConfigs(zividSettingsToConfig<CaptureGeneralConfig>(suggested_settings[0]), frame_configs);
+
+  return from_cache;
+}
+
+bool ZividCamera::clearSuggestedSettingsCacheServiceHandler(ClearSuggestedSettingsCache::Request& req,
+                                                             ClearSuggestedSettingsCache::Response& res)
+{
+  ROS_DEBUG_STREAM(__func__ << ": Request: " << req);
+
+  const auto scene_tag = req.all ? std::optional<std::string>() : std::optional<std::string>(req.scene_tag);
+  res.num_cleared = static_cast<std::uint32_t>(suggested_settings_cache_->clear(scene_tag));
+  ROS_INFO("Cleared %u cached suggested settings", res.num_cleared);
+  return true;
+}
+
+void ZividCamera::setCaptureConfigs(const CaptureGeneralConfig& general_config,
+                                    const std::vector<CaptureFrameConfig>& frame_configs)
+{
+  capture_general_config_dr_server_->setConfig(general_config);
+
+  for (std::size_t i = 0; i < frame_configs.size(); i++)
+  {
+    auto config = frame_configs[i];
+    config.enabled = true;
+    capture_frame_config_dr_servers_[i]->setConfig(config);
+  }
+
+  // Any other frames that are enabled must be disabled
+  for (std::size_t i = frame_configs.size(); i < capture_frame_config_dr_servers_.size(); i++)
+  {
+    if (capture_frame_config_dr_servers_[i]->config().enabled)
+    {
+      ROS_INFO_STREAM("Frame config " << i << " was enabled, so disabling it");
+      auto config = capture_frame_config_dr_servers_[i]->config();
+      config.enabled = false;
+      capture_frame_config_dr_servers_[i]->setConfig(config);
+    }
+  }
+}
+
+void ZividCamera::serviceHandlerHandleCameraConnectionLoss()
+{
+  reconnectToCameraIfNecessary();
+  if (camera_status_ != CameraStatus::Connected)
+  {
+    throw std::runtime_error("Unable to capture since the camera is not connected. Please re-connect the camera and "
+                             "try again.");
+  }
+}
+
+bool ZividCamera::isConnectedServiceHandler(IsConnected::Request&, IsConnected::Response& res)
+{
+  res.is_connected = camera_status_ == CameraStatus::Connected;
+  return true;
+}
+
+bool ZividCamera::selectPresetServiceHandler(SelectPreset::Request& req, SelectPreset::Response&)
+{
+  ROS_DEBUG_STREAM(__func__ << ": Request: " << req);
+
+  std::lock_guard<std::mutex> lock(presets_mutex_);
+  if (req.name.empty())
+  {
+    ROS_INFO("Capturing with the capture/general and capture/frame_<n> configs");
+    active_preset_.reset();
+    pending_preset_dr_update_.reset();
+    return true;
+  }
+  const auto it = presets_.find(req.name);
+  if (it == presets_.end())
+  {
+    throw std::runtime_error("There is no preset named '" + req.name + "'");
+  }
+  ROS_INFO("Capturing with preset '%s'", req.name.c_str());
+  active_preset_ = it->second;
+  pending_preset_dr_update_ = it->second;
+  preset_dr_update_requested_.notify_one();
+  return true;
+}
+
+bool ZividCamera::savePresetServiceHandler(SavePreset::Request& req, SavePreset::Response&)
+{
+  ROS_DEBUG_STREAM(__func__ << ": Request: " << req);
+
+  if (req.name.empty())
+  {
+    throw std::runtime_error("The name of the preset can not be empty");
+  }
+  auto preset = std::make_shared<CapturePreset>();
+  preset->name = req.name;
+  preset->general_config = capture_general_config_dr_server_->config();
+  for (const auto& dr_config_server : capture_frame_config_dr_servers_)
+  {
+    const auto config = dr_config_server->config();
+    if (config.enabled)
+    {
+      preset->frame_configs.push_back(config);
+    }
+  }
+  preset->settings = captureSettings(preset->general_config, preset->frame_configs);
+
+  ROS_INFO("Saving preset '%s' with %zd frames", req.name.c_str(), preset->settings.size());
+  std::lock_guard<std::mutex> lock(presets_mutex_);
+  presets_[req.name] = std::move(preset);
+  return true;
+}
+
+void ZividCamera::loadPresets()
+{
+  // presets is a map from preset names to {general: {<parameter>: <value>}, frames: [{<parameter>: <value>}]}
+  XmlRpc::XmlRpcValue presets;
+  if (!priv_.getParam("presets", presets))
+  {
+    return;
+  }
+  if (presets.getType() != XmlRpc::XmlRpcValue::TypeStruct)
+  {
+    throw std::runtime_error("presets must be a map from preset names to {general: {...}, frames: [{...}]}");
+  }
+
+  for (auto& [name, parameters] : presets)
+  {
+    const auto context = "presets/" + name;
+    if (parameters.getType() != XmlRpc::XmlRpcValue::TypeStruct || !parameters.hasMember("frames") ||
+        parameters["frames"].getType() != XmlRpc::XmlRpcValue::TypeArray)
+    {
+      throw std::runtime_error(context + " must be {general: {...}, frames: [{...}]}");
+    }
+    auto& frames = parameters["frames"];
+    if (frames.size() == 0 || static_cast<std::size_t>(frames.size()) > capture_frame_config_dr_servers_.size())
+    {
+      throw std::runtime_error(context + " must have between 1 and " +
+                               std::to_string(capture_frame_config_dr_servers_.size()) + " frames");
+    }
+
+    // The parameters that are not given keep the value of the config at startup
+    auto preset = std::make_shared<CapturePreset>();
+    preset->name = name;
+    preset->general_config = capture_general_config_dr_server_->config();
+    if (parameters.hasMember("general"))
+    {
+      preset->general_config = capture_general_config_dr_server_->configFromMessage(
+          toConfigMessage<CaptureGeneralConfig>(parameters["general"], context + "/general"));
+    }
+    for (int i = 0; i < frames.size(); i++)
+    {
+      preset->frame_configs.push_back(capture_frame_config_dr_servers_[static_cast<std::size_t>(i)]->configFromMessage(
+          toConfigMessage<CaptureFrameConfig>(frames[i], context + "/frames/" + std::to_string(i))));
+    }
+    preset->settings = captureSettings(preset->general_config, preset->frame_configs);
+
+    ROS_INFO("Loaded preset '%s' with %zd frames", name.c_str(), preset->settings.size());
+    presets_[name] = std::move(preset);
+  }
+}
+
+void ZividCamera::deactivatePreset(const std::string& reason)
+{
+  std::lock_guard<std::mutex> lock(presets_mutex_);
+  if (active_preset_)
+  {
+    ROS_INFO("Not capturing with preset '%s' any more, since %s", active_preset_->name.c_str(), reason.c_str());
+    active_preset_.reset();
+  }
+  pending_preset_dr_update_.reset();
+}
+
+void ZividCamera::presetDRUpdateThread()
+{
+  while (true)
+  {
+    std::shared_ptr<const CapturePreset> preset;
+    {
+      std::unique_lock<std::mutex> lock(presets_mutex_);
+      preset_dr_update_requested_.wait(lock, [this]() { return stop_preset_dr_updates_ || pending_preset_dr_update_; });
+      if (stop_preset_dr_updates_)
+      {
+        return;
+      }
+      preset = std::move(pending_preset_dr_update_);
+      pending_preset_dr_update_.reset();
+    }
+
+    std::lock_guard<std::mutex> lock(capture_config_update_mutex_);
+    {
+      // The configs may have been changed by other means after the preset was selected
+      std::lock_guard<std::mutex> presets_lock(presets_mutex_);
+      if (active_preset_ != preset)
+      {
+        continue;
+      }
+    }
+    ROS_DEBUG("Updating the capture configs to preset '%s'", preset->name.c_str());
+    setCaptureConfigs(preset->general_config, preset->frame_configs);
+  }
+}
+
+void ZividCamera::publishFrame(CapturedFrame&& captured_frame, const std::optional<std_msgs::Header>& header_override,
+                               bool publish_color)
+{
+  const ScopedThreadScheduling scheduling(publish_thread_scheduling_);
+  // Cleared below if the transform of the point clouds to the target frame is not available
+  bool publish_points = shouldPublishPoints();
+  bool publish_compressed_points = shouldPublishCompressedPoints();
+  bool publish_points_with_normals = shouldPublishPointsWithNormals();
+  bool publish_points_stats = shouldPublishPointsStatistics();
+  bool write_points_to_shared_memory = shm_transport_enabled_;
+  const bool publish_color_img = publish_color && shouldPublishColorImg();
+  const bool publish_depth_img = shouldPublishDepthImg();
+  const bool publish_color_img_rect = publish_color && color_image_rect_publisher_.getNumSubscribers() > 0;
+  const bool publish_depth_img_rect = depth_image_rect_publisher_.getNumSubscribers() > 0;
+  const bool publish_previews = std::any_of(preview_levels_.begin(), preview_levels_.end(),
+                                            [](const auto& level) { return level.hasSubscribers(); });
+
+  if (publish_points || publish_compressed_points || publish_points_with_normals || publish_points_stats ||
+      publish_color_img || publish_depth_img || publish_color_img_rect || publish_depth_img_rect || publish_previews ||
+      shm_transport_enabled_ || recorder_ || lazy_latched_conversion_)
+  {
+    if (!processor_chain_.empty())
+    {
+      ROS_DEBUG("Running the point cloud processors");
+      processor_chain_.process(captured_frame.point_cloud, *thread_pool_);
+    }
+
+    if (memory_bounded_publishing_ && captured_frame.frame &&
+        !(recorder_ && recorder_->parameters().format == RecordingFormat::Zdf))
+    {
+      // The point cloud has already been copied out of the Zivid::Frame, so the frame is only needed for recording
+      captured_frame.frame.reset();
+    }
+
+    // Shared by the recorder and the lazily converted latched topics
+    const auto frame = std::make_shared<const CapturedFrame>(std::move(captured_frame));
+    const auto header = header_override ? *header_override : makeHeader(frame->timestamp);
+    const auto& point_cloud = frame->point_cloud;
+    LatestCapture latest_capture{ header, lazy_latched_conversion_ ? frame : nullptr };
+
+    // The transform to the target frame is looked up once, and applied while converting each point cloud. If it is
+    // not available, only the outputs that are not in the target frame are published for this capture.
+    latest_capture.points_header = header;
+    latest_capture.points_transform = PointTransform::millimetersToMeters();
+    if (publish_points || publish_compressed_points || publish_points_with_normals || publish_points_stats ||
+        publish_previews || write_points_to_shared_memory ||
+        (lazy_latched_conversion_ && use_latched_publisher_for_points_))
+    {
+      latest_capture.points_transform = lookupPointsTransform(latest_capture.points_header);
+      if (!latest_capture.points_transform)
+      {
+        publish_points = false;
+        publish_compressed_points = false;
+        publish_points_with_normals = false;
+        publish_points_stats = false;
+        write_points_to_shared_memory = false;
+      }
+    }
+    const auto& points_header = latest_capture.points_header;
+    const auto points_transform = latest_capture.points_transform.value_or(PointTransform::millimetersToMeters());
+
+    if (write_points_to_shared_memory)
+    {
+      ROS_DEBUG("Writing points to shared memory");
+      writePointsToSharedMemory(points_header, point_cloud, points_transform);
+    }
+
+    // Each message is released as soon as it has been published, unless it is kept for subscribers that connect
+    // later. Only the point cloud and one message (and the messages derived from it) are alive at the same time.
+    const bool keep_messages = lazy_latched_conversion_;
+
+    // The statistics are computed in the pass that converts the points, or in a separate pass without output if the
+    // points are not published
+    PointCloudStatistics points_statistics{};
+    if (publish_points || publish_compressed_points)
+    {
+      const auto points = makePointCloud2(points_header, point_cloud, points_transform,
+                                          publish_points_stats ? &points_statistics : nullptr);
+      if (publish_points)
+      {
+        ROS_DEBUG("Publishing points");
+        points_publisher_.publish(points);
+      }
+      if (publish_compressed_points)
+      {
+        ROS_DEBUG("Publishing compressed points");
+        const auto compressed_points = makeCompressedPointCloud(*points);
+        compressed_points_publisher_.publish(compressed_points);
+        if (keep_messages)
+        {
+          latest_capture.compressed_points = compressed_points;
+        }
+      }
+      if (keep_messages)
+      {
+        latest_capture.points = points;
+      }
+    }
+    else if (publish_points_stats)
+    {
+      points_statistics = transformPointsWithStatistics(point_cloud, points_transform, points_stats_parameters_,
+                                                        nullptr, *thread_pool_);
+    }
+
+    if (publish_points_stats)
+    {
+      ROS_DEBUG("Publishing points statistics");
+      points_stats_publisher_.publish(makePointCloudStats(points_header, point_cloud, points_statistics));
+    }
+
+    if (publish_points_with_normals)
+    {
+      ROS_DEBUG("Publishing points with normals");
+      points_with_normals_publisher_.publish(makePointCloud2WithNormals(points_header, point_cloud, points_transform));
+    }
+
+    // The camera_info of the lazily converted images is made from the intrinsics of the capture, since the camera may
+    // be in use by another capture when a subscriber connects
+    const bool keep_intrinsics =
+        lazy_latched_conversion_ && (use_latched_publisher_for_color_image_ || use_latched_publisher_for_depth_image_);
+    if (publish_color_img || publish_depth_img || publish_color_img_rect || publish_depth_img_rect || keep_intrinsics)
+    {
+      latest_capture.intrinsics = backend_->intrinsics();
+    }
+
+    if (publish_color_img || publish_depth_img || publish_color_img_rect || publish_depth_img_rect)
+    {
+      const auto& intrinsics = *latest_capture.intrinsics;
+      const auto camera_info = makeCameraInfo(header, point_cloud.width(), point_cloud.height(), intrinsics);
+
+      // The rectified images are remapped from the raw images
+      if (publish_color_img || publish_color_img_rect)
+      {
+        const auto color_image = makeColorImage(header, point_cloud);
+        if (publish_color_img)
+        {
+          ROS_DEBUG("Publishing color image");
+          color_image_publisher_.publish(color_image, camera_info);
+        }
+        if (publish_color_img_rect)
+        {
+          ROS_DEBUG("Publishing rectified color image");
+          color_image_rect_publisher_.publish(makeRectifiedImage(*color_image, intrinsics));
+        }
+        if (keep_messages)
+        {
+          latest_capture.color_image = color_image;
+          latest_capture.color_camera_info = camera_info;
+        }
+      }
+
+      if (publish_depth_img || publish_depth_img_rect)
+      {
+        const auto depth_image = makeDepthImage(header, point_cloud);
+        if (publish_depth_img)
+        {
+          ROS_DEBUG("Publishing depth image");
+          depth_image_publisher_.publish(depth_image, camera_info);
+        }
+        if (publish_depth_img_rect)
+        {
+          ROS_DEBUG("Publishing rectified depth image");
+          depth_image_rect_publisher_.publish(makeRectifiedImage(*depth_image, intrinsics));
+        }
+        if (keep_messages)
+        {
+          latest_capture.depth_image = depth_image;
+          latest_capture.depth_camera_info = camera_info;
+        }
+      }
+    }
+
+    if (publish_previews)
+    {
+      publishPreviews(header, points_header, latest_capture.points_transform, point_cloud);
+    }
+
+    if (recorder_)
+    {
+      recordFrame(header, frame);
+    }
+
+    if (lazy_latched_conversion_)
+    {
+      // Keep the capture, and the messages that were already converted, for subscribers that connect later
+      std::lock_guard<std::mutex> lock(latest_capture_mutex_);
+      if (!publish_color)
+      {
+        // Keep the color image that was published for this capture
+        latest_capture.color_image = latest_capture_.color_image;
+        latest_capture.color_camera_info = latest_capture_.color_camera_info;
+      }
+      latest_capture_ = std::move(latest_capture);
+    }
+  }
+
+  if (memory_bounded_publishing_)
+  {
+    // Return the memory of the released buffers to the operating system, so that it is not counted as resident
+    malloc_trim(0);
+  }
+  updateCaptureMemoryStatistics();
+
+  const auto capture_to_publish = std::chrono::steady_clock::now() - capture_start_time_;
+  capture_to_publish_latency_.add(capture_to_publish);
+  if (capture_to_publish_deadline_ > 0.0 &&
+      capture_to_publish > std::chrono::duration<double>(capture_to_publish_deadline_))
+  {
+    num_missed_deadlines_++;
+    ROS_WARN_THROTTLE(10, "Capture-to-publish time %.1f ms exceeded the deadline of %.1f ms",
+                      std::chrono::duration<double, std::milli>(capture_to_publish).count(),
+                      1000.0 * capture_to_publish_deadline_);
+  }
+}
+
+void ZividCamera::updateCaptureMemoryStatistics()
+{
+  try
+  {
+    const auto usage = readProcessMemoryUsage();
+    // The peak since the previous capture was published covers the acquisition and the publishing of this capture
+    resetPeakResidentMemory();
+    std::lock_guard<std::mutex> lock(capture_memory_statistics_mutex_);
+    auto& statistics = capture_memory_statistics_;
+    statistics.num_captures++;
+    statistics.last_peak_bytes = usage.peak_resident_bytes;
+    statistics.last_steady_state_bytes = usage.resident_bytes;
+    statistics.max_peak_bytes = std::max(statistics.max_peak_bytes, usage.peak_resident_bytes);
+    ROS_DEBUG("Capture memory: peak %.1f MB, after publishing %.1f MB",
+              static_cast<double>(usage.peak_resident_bytes) / (1024.0 * 1024.0),
+              static_cast<double>(usage.resident_bytes) / (1024.0 * 1024.0));
+  }
+  catch (const std::exception& e)
+  {
+    ROS_WARN_THROTTLE(60, "Failed to read the memory usage: %s", e.what());
+  }
+}
+
+void ZividCamera::captureMemoryDiagnostics(diagnostic_updater::DiagnosticStatusWrapper& status)
+{
+  CaptureMemoryStatistics statistics;
+  {
+    std::lock_guard<std::mutex> lock(capture_memory_statistics_mutex_);
+    statistics = capture_memory_statistics_;
+  }
+  constexpr double bytes_per_mb = 1024.0 * 1024.0;
+  status.summary(diagnostic_msgs::DiagnosticStatus::OK,
+                 memory_bounded_publishing_ ? "Memory-bounded publishing" : "Publishing");
+  status.add("Captures", statistics.num_captures);
+  status.add("Last capture peak RSS MB", static_cast<double>(statistics.last_peak_bytes) / bytes_per_mb);
+  status.add("Last capture steady-state RSS MB",
+             static_cast<double>(statistics.last_steady_state_bytes) / bytes_per_mb);
+  status.add("Max capture peak RSS MB", static_cast<double>(statistics.max_peak_bytes) / bytes_per_mb);
+}
+
+void ZividCamera::latencyDiagnostics(diagnostic_updater::DiagnosticStatusWrapper& status)
+{
+  const auto milliseconds = [](std::chrono::nanoseconds duration) {
+    return std::chrono::duration<double, std::milli>(duration).count();
+  };
+  const auto capture = capture_latency_.takeWindow();
+  const auto capture_to_publish = capture_to_publish_latency_.takeWindow();
+  const auto num_missed_deadlines = num_missed_deadlines_.exchange(0);
+
+  if (num_missed_deadlines > 0)
+  {
+    status.summary(diagnostic_msgs::DiagnosticStatus::WARN, "Capture-to-publish deadline missed");
+  }
+  else
+  {
+    status.summary(diagnostic_msgs::DiagnosticStatus::OK, "OK");
+  }
+  status.add("Captures", capture_to_publish.count);
+  status.add("Mean capture time ms", milliseconds(capture.mean));
+  status.add("Max capture time ms", milliseconds(capture.max));
+  status.add("Mean capture-to-publish time ms", milliseconds(capture_to_publish.mean));
+  status.add("Max capture-to-publish time ms", milliseconds(capture_to_publish.max));
+  status.add("Max capture-to-publish time since start ms", milliseconds(capture_to_publish_latency_.maxOverall()));
+  status.add("Max conversion thread wakeup latency ms", milliseconds(thread_pool_->takeMaxWakeupLatency()));
+  status.add("Missed deadlines", num_missed_deadlines);
+}
+
+void ZividCamera::captureSchedulerDiagnostics(diagnostic_updater::DiagnosticStatusWrapper& status)
+{
+  const auto milliseconds = [](std::chrono::nanoseconds duration) {
+    return std::chrono::duration<double, std::milli>(duration).count();
+  };
+  const auto statistics = capture_scheduler_.takeWaitStatistics();
+  const bool any_expired =
+      std::any_of(statistics.begin(), statistics.end(), [](const auto& s) { return s.num_expired > 0; });
+  if (any_expired)
+  {
+    status.summary(diagnostic_msgs::DiagnosticStatus::WARN, "Capture requests dropped at their deadline");
+  }
+  else
+  {
+    status.summary(diagnostic_msgs::DiagnosticStatus::OK, "OK");
+  }
+  status.add("Waiting requests", capture_scheduler_.numWaiting());
+  for (const auto& priority_statistics : statistics)
+  {
+    const auto prefix = "Priority " + std::to_string(priority_statistics.priority) + " ";
+    status.add(prefix + "requests", priority_statistics.wait.count);
+    status.add(prefix + "mean wait ms", milliseconds(priority_statistics.wait.mean));
+    status.add(prefix + "max wait ms", milliseconds(priority_statistics.wait.max));
+    status.add(prefix + "expired requests", priority_statistics.num_expired);
+  }
+}
+
+void ZividCamera::captureCoalescingDiagnostics(diagnostic_updater::DiagnosticStatusWrapper& status)
 {
-  ROS_DEBUG_STREAM(__func__ << ", threadid=" << std::this_thread::get_id());
+  const auto statistics = capture_coalescer_->statistics();
+  status.summary(diagnostic_msgs::DiagnosticStatus::OK, "OK");
+  status.add("Capture requests", statistics.num_requests);
+  status.add("Acquisitions", statistics.num_acquisitions);
+  status.add("Coalesced requests", statistics.num_coalesced);
+  const auto num_satisfied = statistics.num_acquisitions + statistics.num_coalesced;
+  status.add("Requests per acquisition",
+             statistics.num_acquisitions > 0 ?
+                 static_cast<double>(num_satisfied) / static_cast<double>(statistics.num_acquisitions) :
+                 0.0);
+}
+
+void ZividCamera::suggestedSettingsCacheDiagnostics(diagnostic_updater::DiagnosticStatusWrapper& status)
+{
+  status.summary(diagnostic_msgs::DiagnosticStatus::OK, "OK");
+  status.add("Cached suggestions", suggested_settings_cache_->numEntries());
+  status.add("Hits", suggested_settings_cache_->numHits());
+  status.add("Misses", suggested_settings_cache_->numMisses());
+}
 
-  const auto state = camera_.state();
-  if (state.isConnected().value())
+void ZividCamera::loadProcessors()
+{
+  // processors is a list of {name: <name>, type: <plugin type>}, run in the order they are listed
+  XmlRpc::XmlRpcValue processors;
+  if (!priv_.getParam("processors", processors))
   {
-    setCameraStatus(CameraStatus::Connected);
+    return;
   }
-  else
+  if (processors.getType() != XmlRpc::XmlRpcValue::TypeArray)
   {
-    setCameraStatus(CameraStatus::Disconnected);
+    throw std::runtime_error("processors must be a list of {name: <name>, type: <plugin type>}");
+  }
 
-    // The camera handle needs to be refreshed to ensure we get the correct
-    // "available" status. This is a bug in the API.
-    auto cameras = zivid_.cameras();
-    for (auto& c : cameras)
+  processor_loader_ = std::make_unique<pluginlib::ClassLoader<PointCloudProcessor>>(
+      "zivid_camera", "zivid_camera::PointCloudProcessor");
+  for (int i = 0; i < processors.size(); i++)
+  {
+    auto& processor = processors[i];
+    if (processor.getType() != XmlRpc::XmlRpcValue::TypeStruct || !processor.hasMember("name") ||
+        !processor.hasMember("type") || processor["name"].getType() != XmlRpc::XmlRpcValue::TypeString ||
+        processor["type"].getType() != XmlRpc::XmlRpcValue::TypeString)
     {
-      if (camera_.serialNumber() == c.serialNumber())
-      {
-        camera_ = c;
-      }
+      throw std::runtime_error("Entry " + std::to_string(i) +
+                               " of processors must be {name: <name>, type: <plugin type>}");
     }
-
-    if (state.isAvailable().value())
+    const std::string name = processor["name"];
+    const std::string type = processor["type"];
+    ROS_INFO("Loading point cloud processor '%s' of type '%s'", name.c_str(), type.c_str());
+    std::shared_ptr<PointCloudProcessor> instance;
+    try
     {
-      ROS_INFO_STREAM("The camera '" << camera_.serialNumber()
-                                     << "' is not connected but is available. Re-connecting ...");
-      camera_.connect();
-      ROS_INFO("Successfully reconnected to camera!");
-      setCameraStatus(CameraStatus::Connected);
+      instance.reset(processor_loader_->createUnmanagedInstance(type));
     }
-    else
+    catch (const pluginlib::PluginlibException& e)
     {
-      ROS_INFO_STREAM("The camera '" << camera_.serialNumber() << "' is not connected nor available.");
+      throw std::runtime_error("Failed to load point cloud processor '" + name + "': " + e.what());
     }
+    ros::NodeHandle processor_nh(priv_, "processors/" + name);
+    instance->initialize(name, processor_nh);
+    processor_chain_.add(name, std::move(instance));
   }
 }
 
-void ZividCamera::setCameraStatus(CameraStatus camera_status)
+void ZividCamera::processingDiagnostics(diagnostic_updater::DiagnosticStatusWrapper& status)
 {
-  if (camera_status_ != camera_status)
+  const auto milliseconds = [](std::chrono::nanoseconds duration) {
+    return std::chrono::duration<double, std::milli>(duration).count();
+  };
+  status.summary(diagnostic_msgs::DiagnosticStatus::OK, "OK");
+  for (const auto& timing : processor_chain_.takeTimings())
   {
-    std::stringstream ss;
-    ss << "Camera status changed to " << toString(camera_status) << " (was " << toString(camera_status_) << ")";
-    if (camera_status == CameraStatus::Connected)
-    {
-      ROS_INFO_STREAM(ss.str());
-    }
-    else
-    {
-      ROS_WARN_STREAM(ss.str());
-    }
-    camera_status_ = camera_status;
+    status.add(timing.name + " runs", timing.summary.count);
+    status.add(timing.name + " mean time ms", milliseconds(timing.summary.mean));
+    status.add(timing.name + " max time ms", milliseconds(timing.summary.max));
+    status.add(timing.name + " max time since start ms", milliseconds(timing.max_overall));
   }
 }
 
-bool ZividCamera::cameraInfoModelNameServiceHandler(zivid_camera::CameraInfoModelName::Request&,
-                                                    zivid_camera::CameraInfoModelName::Response& res)
-{
-  res.model_name = camera_.modelName();
-  return true;
-}
-
-bool ZividCamera::cameraInfoSerialNumberServiceHandler(zivid_camera::CameraInfoSerialNumber::Request&,
-                                                       zivid_camera::CameraInfoSerialNumber::Response& res)
+void ZividCamera::onPointsSubscriberConnect(const ros::SingleSubscriberPublisher& publisher)
 {
-  res.serial_number = camera_.serialNumber().toString();
-  return true;
+  std::lock_guard<std::mutex> lock(latest_capture_mutex_);
+  if (!latest_capture_.points && latest_capture_.frame && latest_capture_.points_transform)
+  {
+    ROS_DEBUG("Converting points for new subscriber");
+    latest_capture_.points = makePointCloud2(latest_capture_.points_header, latest_capture_.frame->point_cloud,
+                                             *latest_capture_.points_transform);
+  }
+  if (latest_capture_.points)
+  {
+    publisher.publish(latest_capture_.points);
+  }
 }
 
-bool ZividCamera::captureServiceHandler(Capture::Request&, Capture::Response&)
+void ZividCamera::onCompressedPointsSubscriberConnect(const ros::SingleSubscriberPublisher& publisher)
 {
-  ROS_DEBUG_STREAM(__func__ << ", threadid=" << std::this_thread::get_id());
-
-  serviceHandlerHandleCameraConnectionLoss();
-
-  std::vector<Zivid::Settings> settings;
-
-  Zivid::Settings base_setting = camera_.settings();
-  applyCaptureGeneralConfigToZividSettings(capture_general_config_dr_server_->config(), base_setting);
-
-  for (const auto& dr_config_server : capture_frame_config_dr_servers_)
+  std::lock_guard<std::mutex> lock(latest_capture_mutex_);
+  if (!latest_capture_.compressed_points && latest_capture_.frame && latest_capture_.points_transform)
   {
-    if (dr_config_server->config().enabled)
+    ROS_DEBUG("Compressing points for new subscriber");
+    if (!latest_capture_.points)
     {
-      ROS_DEBUG("Config %s is enabled", dr_config_server->name().c_str());
-      Zivid::Settings s{ base_setting };
-      applyCaptureFrameConfigToZividSettings(dr_config_server->config(), s);
-      settings.push_back(std::move(s));
+      latest_capture_.points = makePointCloud2(latest_capture_.points_header, latest_capture_.frame->point_cloud,
+                                               *latest_capture_.points_transform);
     }
+    latest_capture_.compressed_points = makeCompressedPointCloud(*latest_capture_.points);
   }
-
-  if (settings.size() == 0)
-  {
-    throw std::runtime_error("Capture called with 0 enabled frames!");
-  }
-
-  ROS_INFO("Capturing with %zd frames", settings.size());
-  for (std::size_t i = 0; i < settings.size(); i++)
+  if (latest_capture_.compressed_points)
   {
-    ROS_DEBUG_STREAM("Setting " << i << ": " << settings[i]);
+    publisher.publish(latest_capture_.compressed_points);
   }
-  publishFrame(Zivid::HDR::capture(camera_, settings));
-  return true;
 }
 
-bool ZividCamera::capture2DServiceHandler(Capture::Request&, Capture::Response&)
+void ZividCamera::onColorImageSubscriberConnect(const image_transport::SingleSubscriberPublisher& publisher)
 {
-  ROS_DEBUG_STREAM(__func__);
-
-  serviceHandlerHandleCameraConnectionLoss();
-
-  if (capture_2d_frame_config_dr_servers_.empty())
-  {
-    throw std::runtime_error("Internal error: capture_2d_frame_config_dr_servers_ empty");
-  }
-
-  if (!capture_2d_frame_config_dr_servers_[0]->config().enabled)
+  std::lock_guard<std::mutex> lock(latest_capture_mutex_);
+  if (!latest_capture_.color_image && latest_capture_.frame)
   {
-    // 2D capture API in SDK currently only supports single-capture (1 frame). However, we still
-    // verify that frame_0/enabled is set. This is for future-proofing and consistency with 3D API.
-    throw std::runtime_error("Failed to capture: capture_2d/frame_0/enabled is false! Set enabled to true.");
+    ROS_DEBUG("Converting color image for new subscriber");
+    latest_capture_.color_image = makeColorImage(latest_capture_.header, latest_capture_.frame->point_cloud);
   }
-
-  Zivid::Settings2D settings2D;
-  applyCapture2DFrameConfigToZividSettings(capture_2d_frame_config_dr_servers_[0]->config(), settings2D);
-  auto frame2D = camera_.capture2D(settings2D);
-  if (shouldPublishColorImg())
+  if (latest_capture_.color_image)
   {
-    ROS_DEBUG("Publishing color image");
-    const auto header = makeHeader();
-    auto image = frame2D.image<Zivid::RGBA8>();
-    const auto camera_info = makeCameraInfo(header, image.width(), image.height(), camera_.intrinsics());
-    color_image_publisher_.publish(makeColorImage(header, image), camera_info);
+    publisher.publish(latest_capture_.color_image);
   }
-  return true;
 }
 
-bool ZividCamera::captureAssistantSuggestSettingsServiceHandler(CaptureAssistantSuggestSettings::Request& req,
-                                                                CaptureAssistantSuggestSettings::Response&)
+void ZividCamera::onDepthImageSubscriberConnect(const image_transport::SingleSubscriberPublisher& publisher)
 {
-  ROS_DEBUG_STREAM(__func__ << ": Request: " << req);
-
-  serviceHandlerHandleCameraConnectionLoss();
-
-  const auto max_capture_time =
-      std::chrono::round<std::chrono::milliseconds>(std::chrono::duration<double>{ req.max_capture_time.toSec() });
-  const auto ambient_light_frequency = [&req]() {
-    switch (req.ambient_light_frequency)
-    {
-      case CaptureAssistantSuggestSettings::Request::AMBIENT_LIGHT_FREQUENCY_NONE:
-        return Zivid::CaptureAssistant::AmbientLightFrequency::none;
-      case CaptureAssistantSuggestSettings::Request::AMBIENT_LIGHT_FREQUENCY_50HZ:
-        return Zivid::CaptureAssistant::AmbientLightFrequency::hz50;
-      case CaptureAssistantSuggestSettings::Request::AMBIENT_LIGHT_FREQUENCY_60HZ:
-        return Zivid::CaptureAssistant::AmbientLightFrequency::hz60;
-    }
-    throw std::runtime_error("Unhandled AMBIENT_LIGHT_FREQUENCY value: " + std::to_string(req.ambient_light_frequency));
-  }();
-
-  Zivid::CaptureAssistant::SuggestSettingsParameters suggest_settings_parameters(max_capture_time,
-                                                                                 ambient_light_frequency);
-  ROS_INFO_STREAM("Getting suggested settings using parameters: " << suggest_settings_parameters);
-  const auto suggested_settings{ Zivid::CaptureAssistant::suggestSettings(camera_, suggest_settings_parameters) };
-
-  if (suggested_settings.empty())
+  std::lock_guard<std::mutex> lock(latest_capture_mutex_);
+  if (!latest_capture_.depth_image && latest_capture_.frame)
   {
-    throw std::runtime_error("The suggestSettings function returned 0 settings!");
+    ROS_DEBUG("Converting depth image for new subscriber");
+    latest_capture_.depth_image = makeDepthImage(latest_capture_.header, latest_capture_.frame->point_cloud);
   }
-  if (suggested_settings.size() > capture_frame_config_dr_servers_.size())
+  if (latest_capture_.depth_image)
   {
-    throw std::runtime_error("The number of suggested settings (" + std::to_string(suggested_settings.size()) + ") " +
-                             "is larger than the number of dynamic_reconfigure capture/frame_<n> servers (" +
-                             std::to_string(capture_frame_config_dr_servers_.size()) + "). Increase launch parameter " +
-                             "num_capture_frames. See README.md for more information.");
+    publisher.publish(latest_capture_.depth_image);
   }
+}
 
-  ROS_INFO_STREAM("CaptureAssistant::suggestSettings returned " << suggested_settings.size() << " settings");
+void ZividCamera::onColorCameraInfoSubscriberConnect(const ros::SingleSubscriberPublisher& publisher)
+{
+  std::lock_guard<std::mutex> lock(latest_capture_mutex_);
+  publishLatestCameraInfo(latest_capture_.color_camera_info, publisher);
+}
 
-  capture_general_config_dr_server_->setConfig(zividSettingsToConfig<CaptureGeneralConfig>(suggested_settings[0]));
+void ZividCamera::onDepthCameraInfoSubscriberConnect(const ros::SingleSubscriberPublisher& publisher)
+{
+  std::lock_guard<std::mutex> lock(latest_capture_mutex_);
+  publishLatestCameraInfo(latest_capture_.depth_camera_info, publisher);
+}
 
-  for (std::size_t i = 0; i < suggested_settings.size(); i++)
+void ZividCamera::publishLatestCameraInfo(sensor_msgs::CameraInfoConstPtr& camera_info,
+                                          const ros::SingleSubscriberPublisher& publisher)
+{
+  if (!camera_info && latest_capture_.frame && latest_capture_.intrinsics)
   {
-    ROS_DEBUG_STREAM("Updating setting " << i << " to " << suggested_settings[i]);
-    auto config = zividSettingsToConfig<CaptureFrameConfig>(suggested_settings[i]);
-    config.enabled = true;
-    capture_frame_config_dr_servers_[i]->setConfig(config);
+    const auto& point_cloud = latest_capture_.frame->point_cloud;
+    camera_info =
+        makeCameraInfo(latest_capture_.header, point_cloud.width(), point_cloud.height(), *latest_capture_.intrinsics);
   }
-
-  // Any other frames that are enabled must be disabled
-  for (std::size_t i = suggested_settings.size(); i < capture_frame_config_dr_servers_.size(); i++)
+  if (camera_info)
   {
-    if (capture_frame_config_dr_servers_[i]->config().enabled)
-    {
-      ROS_INFO_STREAM("Frame config " << i << " was enabled, so disabling it");
-      auto config = capture_frame_config_dr_servers_[i]->config();
-      config.enabled = false;
-      capture_frame_config_dr_servers_[i]->setConfig(config);
-    }
+    publisher.publish(camera_info);
   }
-
-  return true;
 }
 
-void ZividCamera::serviceHandlerHandleCameraConnectionLoss()
+void ZividCamera::recordFrame(const std_msgs::Header& header, std::shared_ptr<const CapturedFrame> frame)
 {
-  reconnectToCameraIfNecessary();
-  if (camera_status_ != CameraStatus::Connected)
+  const RecordingMetadata metadata{ header.seq, header.stamp.sec, header.stamp.nsec, header.frame_id };
+  if (!recorder_->record(metadata, std::move(frame)))
   {
-    throw std::runtime_error("Unable to capture since the camera is not connected. Please re-connect the camera and "
-                             "try again.");
+    ROS_WARN_THROTTLE(10, "Dropped capture %u from recording because the queue is full (%lu dropped in total)",
+                      header.seq, static_cast<unsigned long>(recorder_->statistics().num_dropped));
   }
 }
 
-bool ZividCamera::isConnectedServiceHandler(IsConnected::Request&, IsConnected::Response& res)
+void ZividCamera::recorderDiagnostics(diagnostic_updater::DiagnosticStatusWrapper& status)
 {
-  res.is_connected = camera_status_ == CameraStatus::Connected;
-  return true;
+  const auto statistics = recorder_->statistics();
+  if (!statistics.last_error.empty())
+  {
+    status.summary(diagnostic_msgs::DiagnosticStatus::ERROR, "Failed to write captures: " + statistics.last_error);
+  }
+  else if (statistics.num_dropped > 0)
+  {
+    status.summary(diagnostic_msgs::DiagnosticStatus::WARN, "Captures dropped because the recording queue was full");
+  }
+  else
+  {
+    status.summary(diagnostic_msgs::DiagnosticStatus::OK, "Recording");
+  }
+  status.add("Recorded captures", statistics.num_recorded);
+  status.add("Dropped captures", statistics.num_dropped);
+  status.add("Failed captures", statistics.num_failed);
+  status.add("Queued captures", statistics.queue_length);
+  status.add("Queued MB", static_cast<double>(statistics.queue_bytes) / (1024.0 * 1024.0));
 }
 
-void ZividCamera::publishFrame(Zivid::Frame&& frame)
+void ZividCamera::publishPreviews(const std_msgs::Header& header, const std_msgs::Header& points_header,
+                                  const std::optional<PointTransform>& points_transform,
+                                  const Zivid::PointCloud& point_cloud)
 {
-  const bool publish_points = shouldPublishPoints();
-  const bool publish_color_img = shouldPublishColorImg();
-  const bool publish_depth_img = shouldPublishDepthImg();
+  const auto intrinsics = backend_->intrinsics();
 
-  if (publish_points || publish_color_img || publish_depth_img)
+  // Each level is decimated from the finest already computed level whose factor divides its own factor
+  std::vector<std::pair<std::size_t, Zivid::PointCloud>> computed_levels;
+  for (const auto& level : preview_levels_)
   {
-    const auto header = makeHeader();
-    const auto point_cloud = frame.getPointCloud();
+    if (!level.hasSubscribers())
+    {
+      continue;
+    }
+
+    std::size_t source_factor = 1;
+    const Zivid::PointCloud* source = &point_cloud;
+    for (auto it = computed_levels.rbegin(); it != computed_levels.rend(); ++it)
+    {
+      if (level.factor % it->first == 0)
+      {
+        source_factor = it->first;
+        source = &it->second;
+        break;
+      }
+    }
+    ROS_DEBUG("Computing preview level %zu from level %zu", level.factor, source_factor);
+    computed_levels.emplace_back(level.factor,
+                                 decimatePointCloud(*source, level.factor / source_factor, preview_depth_reduction_,
+                                                    *thread_pool_));
+    const auto& preview = computed_levels.back().second;
 
-    if (publish_points)
+    if (points_transform && level.points_publisher.getNumSubscribers() > 0)
     {
-      ROS_DEBUG("Publishing points");
-      points_publisher_.publish(makePointCloud2(header, point_cloud));
+      level.points_publisher.publish(makePointCloud2(points_header, preview, *points_transform));
     }
 
+    const bool publish_color_img = level.color_image_publisher.getNumSubscribers() > 0;
+    const bool publish_depth_img = level.depth_image_publisher.getNumSubscribers() > 0;
     if (publish_color_img || publish_depth_img)
     {
-      const auto camera_info = makeCameraInfo(header, point_cloud.width(), point_cloud.height(), camera_.intrinsics());
-
+      const auto camera_info = makeCameraInfo(header, preview.width(), preview.height(), intrinsics, level.factor);
       if (publish_color_img)
       {
-        ROS_DEBUG("Publishing color image");
-        color_image_publisher_.publish(makeColorImage(header, point_cloud), camera_info);
+        level.color_image_publisher.publish(makeColorImage(header, preview), camera_info);
       }
-
       if (publish_depth_img)
       {
-        ROS_DEBUG("Publishing depth image");
-        depth_image_publisher_.publish(makeDepthImage(header, point_cloud), camera_info);
+        level.depth_image_publisher.publish(makeDepthImage(header, preview), camera_info);
       }
     }
   }
 }
 
+void ZividCamera::writePointsToSharedMemory(const std_msgs::Header& header, const Zivid::PointCloud& point_cloud,
+                                            const PointTransform& transform)
+{
+  const auto data_size = point_cloud.size() * sizeof(Zivid::Point);
+  if (!shm_writer_)
+  {
+    ROS_INFO("Creating shared-memory point cloud transport '%s' with %d slots of %zu bytes",
+             shm_transport_name_.c_str(), shm_transport_num_slots_, data_size);
+    shm_writer_ = std::make_unique<ShmPointCloudWriter>(
+        shm_transport_name_, static_cast<std::size_t>(shm_transport_num_slots_), data_size, shm_transport_permissions_);
+  }
+  else if (data_size > shm_writer_->slotCapacity())
+  {
+    // For example after the file camera or the playback backend switched to a file with a higher resolution
+    ROS_INFO("Re-creating shared-memory point cloud transport '%s' with slots of %zu bytes",
+             shm_transport_name_.c_str(), data_size);
+    try
+    {
+      shm_writer_->resize(data_size);
+    }
+    catch (const std::exception&)
+    {
+      shm_writer_.reset();
+      throw;
+    }
+  }
+
+  uint8_t* data = shm_writer_->beginWrite(data_size);
+  if (data == nullptr)
+  {
+    ROS_WARN_THROTTLE(10, "Dropped frame on shared-memory transport '%s' (%lu dropped in total). Either all slots are "
+                          "leased by readers, or the frame is larger than the slots.",
+                      shm_transport_name_.c_str(), static_cast<unsigned long>(shm_writer_->numDroppedFrames()));
+    return;
+  }
+  copyPointsInMeters(point_cloud, transform, data, *thread_pool_);
+
+  ShmPointCloudMetadata metadata{};
+  metadata.width = static_cast<uint32_t>(point_cloud.width());
+  metadata.height = static_cast<uint32_t>(point_cloud.height());
+  metadata.point_step = sizeof(Zivid::Point);
+  metadata.row_step = metadata.point_step * metadata.width;
+  metadata.data_size = data_size;
+  metadata.stamp_sec = header.stamp.sec;
+  metadata.stamp_nsec = header.stamp.nsec;
+  metadata.header_seq = header.seq;
+  header.frame_id.copy(metadata.frame_id, sizeof(metadata.frame_id) - 1);
+  shm_writer_->commitWrite(metadata);
+}
+
+std::optional<PointTransform> ZividCamera::lookupPointsTransform(std_msgs::Header& points_header)
+{
+  if (target_frame_.empty())
+  {
+    return PointTransform::millimetersToMeters();
+  }
+  geometry_msgs::TransformStamped transform;
+  try
+  {
+    transform = tf_buffer_->lookupTransform(target_frame_, points_header.frame_id, points_header.stamp,
+                                            ros::Duration(target_frame_timeout_));
+  }
+  catch (const tf2::TransformException& e)
+  {
+    ROS_WARN_THROTTLE(10, "Skipping the point clouds of this capture. Failed to look up the transform from '%s' to "
+                          "'%s': %s",
+                      points_header.frame_id.c_str(), target_frame_.c_str(), e.what());
+    return std::nullopt;
+  }
+  points_header.frame_id = target_frame_;
+  return toPointTransform(transform.transform);
+}
+
 bool ZividCamera::shouldPublishPoints() const
 {
-  return points_publisher_.getNumSubscribers() > 0 || use_latched_publisher_for_points_;
+  return points_publisher_.getNumSubscribers() > 0 || (use_latched_publisher_for_points_ && !lazy_latched_conversion_);
+}
+
+bool ZividCamera::shouldPublishCompressedPoints() const
+{
+  return compressed_points_publisher_.getNumSubscribers() > 0 ||
+         (use_latched_publisher_for_points_ && !lazy_latched_conversion_);
+}
+
+bool ZividCamera::shouldPublishPointsWithNormals() const
+{
+  return points_with_normals_publisher_.getNumSubscribers() > 0;
+}
+
+bool ZividCamera::shouldPublishPointsStatistics() const
+{
+  return points_stats_publisher_.getNumSubscribers() > 0;
+}
+
+bool ZividCamera::PreviewLevel::hasSubscribers() const
+{
+  return points_publisher.getNumSubscribers() > 0 || color_image_publisher.getNumSubscribers() > 0 ||
+         depth_image_publisher.getNumSubscribers() > 0;
 }
 
 bool ZividCamera::shouldPublishColorImg() const
 {
-  return color_image_publisher_.getNumSubscribers() > 0 || use_latched_publisher_for_color_image_;
+  return color_image_publisher_.getNumSubscribers() > 0 ||
+         (use_latched_publisher_for_color_image_ && !lazy_latched_conversion_);
 }
 
 bool ZividCamera::shouldPublishDepthImg() const
 {
-  return depth_image_publisher_.getNumSubscribers() > 0 || use_latched_publisher_for_depth_image_;
+  return depth_image_publisher_.getNumSubscribers() > 0 ||
+         (use_latched_publisher_for_depth_image_ && !lazy_latched_conversion_);
 }
 
-std_msgs::Header ZividCamera::makeHeader()
+std_msgs::Header
+ZividCamera::makeHeader(const std::optional<std::chrono::system_clock::time_point>& timestamp)
 {
   std_msgs::Header header;
   header.seq = header_seq_++;
-  header.stamp = ros::Time::now();
+  if (timestamp)
+  {
+    const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(timestamp->time_since_epoch()).count();
+    header.stamp.fromNSec(static_cast<uint64_t>(ns));
+  }
+  else
+  {
+    header.stamp = ros::Time::now();
+  }
   header.frame_id = frame_id_;
   return header;
 }
 
 sensor_msgs::PointCloud2ConstPtr ZividCamera::makePointCloud2(const std_msgs::Header& header,
-                                                              const Zivid::PointCloud& point_cloud)
+                                                              const Zivid::PointCloud& point_cloud,
+                                                              const PointTransform& transform,
+                                                              PointCloudStatistics* statistics)
 {
   auto msg = boost::make_shared<sensor_msgs::PointCloud2>();
   fillCommonMsgFields(*msg, header, point_cloud.width(), point_cloud.height());
@@ -524,25 +2298,83 @@ sensor_msgs::PointCloud2ConstPtr ZividCamera::makePointCloud2(const std_msgs::He
   msg->fields.push_back(createPointField("c", 12, 7, 1));
   msg->fields.push_back(createPointField("rgb", 16, 7, 1));
 
-  msg->data = std::vector<uint8_t>(reinterpret_cast<const uint8_t*>(point_cloud.dataPtr()),
-                                   reinterpret_cast<const uint8_t*>(point_cloud.dataPtr() + point_cloud.size()));
-
-#pragma omp parallel for
-  for (std::size_t i = 0; i < point_cloud.size(); i++)
+  msg->data.resize(point_cloud.size() * sizeof(Zivid::Point));
+  if (statistics)
   {
-    uint8_t* point_ptr = &(msg->data[i * sizeof(Zivid::Point)]);
-    float* x_ptr = reinterpret_cast<float*>(&(point_ptr[0]));
-    float* y_ptr = reinterpret_cast<float*>(&(point_ptr[4]));
-    float* z_ptr = reinterpret_cast<float*>(&(point_ptr[8]));
-
-    // Convert from mm to m
-    *x_ptr *= 0.001f;
-    *y_ptr *= 0.001f;
-    *z_ptr *= 0.001f;
+    *statistics = transformPointsWithStatistics(point_cloud, transform, points_stats_parameters_, msg->data.data(),
+                                                *thread_pool_);
+  }
+  else
+  {
+    copyPointsInMeters(point_cloud, transform, msg->data.data(), *thread_pool_);
   }
   return msg;
 }
 
+PointCloudStatsConstPtr ZividCamera::makePointCloudStats(const std_msgs::Header& header,
+                                                         const Zivid::PointCloud& point_cloud,
+                                                         const PointCloudStatistics& statistics) const
+{
+  auto msg = boost::make_shared<PointCloudStats>();
+  msg->header = header;
+  msg->height = static_cast<uint32_t>(point_cloud.height());
+  msg->width = static_cast<uint32_t>(point_cloud.width());
+  msg->num_valid_points = static_cast<uint32_t>(statistics.num_valid_points);
+  msg->valid_ratio = statistics.num_points > 0 ? static_cast<float>(statistics.num_valid_points) /
+                                                      static_cast<float>(statistics.num_points) :
+                                                  0.0f;
+  std::copy(statistics.min.begin(), statistics.min.end(), msg->min.begin());
+  std::copy(statistics.max.begin(), statistics.max.end(), msg->max.begin());
+  std::copy(statistics.mean.begin(), statistics.mean.end(), msg->mean.begin());
+  msg->mean_contrast = statistics.mean_contrast;
+  msg->z_histogram_min = points_stats_parameters_.z_histogram_min;
+  msg->z_histogram_max = points_stats_parameters_.z_histogram_max;
+  msg->z_histogram = statistics.z_histogram;
+  return msg;
+}
+
+sensor_msgs::PointCloud2ConstPtr ZividCamera::makePointCloud2WithNormals(const std_msgs::Header& header,
+                                                                         const Zivid::PointCloud& point_cloud,
+                                                                         const PointTransform& transform)
+{
+  auto msg = boost::make_shared<sensor_msgs::PointCloud2>();
+  fillCommonMsgFields(*msg, header, point_cloud.width(), point_cloud.height());
+  msg->point_step = point_with_normal_step;
+  msg->row_step = msg->point_step * msg->width;
+  msg->is_dense = false;
+
+  msg->fields.reserve(8);
+  msg->fields.push_back(createPointField("x", 0, 7, 1));
+  msg->fields.push_back(createPointField("y", 4, 7, 1));
+  msg->fields.push_back(createPointField("z", 8, 7, 1));
+  msg->fields.push_back(createPointField("c", 12, 7, 1));
+  msg->fields.push_back(createPointField("rgb", 16, 7, 1));
+  msg->fields.push_back(createPointField("normal_x", 20, 7, 1));
+  msg->fields.push_back(createPointField("normal_y", 24, 7, 1));
+  msg->fields.push_back(createPointField("normal_z", 28, 7, 1));
+
+  msg->data.resize(point_cloud.size() * point_with_normal_step);
+  copyPointsWithNormalsInMeters(point_cloud, static_cast<std::size_t>(points_with_normals_neighbor_distance_),
+                                transform, msg->data.data(), *thread_pool_);
+  return msg;
+}
+
+CompressedPointCloudConstPtr ZividCamera::makeCompressedPointCloud(const sensor_msgs::PointCloud2& points) const
+{
+  static_assert(sizeof(Zivid::Point) == point_cloud_codec_point_step, "Unexpected point layout");
+  auto msg = boost::make_shared<CompressedPointCloud>();
+  msg->header = points.header;
+  msg->height = points.height;
+  msg->width = points.width;
+  msg->resolution = static_cast<float>(points_compressed_resolution_);
+  msg->rows_per_band = static_cast<uint32_t>(points_compressed_rows_per_band_);
+  auto encoded = encodePointCloud(points.data.data(), points.width, points.height, msg->resolution, msg->rows_per_band,
+                                  *thread_pool_);
+  msg->band_offsets = std::move(encoded.band_offsets);
+  msg->data = std::move(encoded.data);
+  return msg;
+}
+
 sensor_msgs::ImageConstPtr ZividCamera::makeColorImage(const std_msgs::Header& header,
                                                        const Zivid::PointCloud& point_cloud)
 {
@@ -553,14 +2385,12 @@ sensor_msgs::ImageConstPtr ZividCamera::makeColorImage(const std_msgs::Header& h
   msg->step = static_cast<uint32_t>(bytes_per_pixel * point_cloud.width());
   msg->data.resize(msg->step * msg->height);
 
-#pragma omp parallel for
-  for (std::size_t i = 0; i < point_cloud.size(); i++)
-  {
+  thread_pool_->parallelFor(0, point_cloud.size(), [&](std::size_t i) {
     const auto point = point_cloud(i);
     msg->data[3 * i] = point.red();
     msg->data[3 * i + 1] = point.green();
     msg->data[3 * i + 2] = point.blue();
-  }
+  });
   return msg;
 }
 
@@ -586,19 +2416,18 @@ sensor_msgs::ImageConstPtr ZividCamera::makeDepthImage(const std_msgs::Header& h
   msg->step = static_cast<uint32_t>(4 * point_cloud.width());
   msg->data.resize(msg->step * msg->height);
 
-#pragma omp parallel for
-  for (std::size_t i = 0; i < point_cloud.size(); i++)
-  {
+  thread_pool_->parallelFor(0, point_cloud.size(), [&](std::size_t i) {
     float* image_data = reinterpret_cast<float*>(&msg->data[4 * i]);
     // Convert from mm to m
     *image_data = point_cloud(i).z * 0.001f;
-  }
+  });
   return msg;
 }
 
 sensor_msgs::CameraInfoConstPtr ZividCamera::makeCameraInfo(const std_msgs::Header& header, std::size_t width,
                                                             std::size_t height,
-                                                            const Zivid::CameraIntrinsics& intrinsics)
+                                                            const Zivid::CameraIntrinsics& intrinsics,
+                                                            std::size_t decimation_factor)
 {
   auto msg = boost::make_shared<sensor_msgs::CameraInfo>();
   msg->header = header;
@@ -619,11 +2448,19 @@ sensor_msgs::CameraInfoConstPtr ZividCamera::makeCameraInfo(const std_msgs::Head
   //     [fx  0 cx]
   // K = [ 0 fy cy]
   //     [ 0  0  1]
+  // For decimated images pixel (u, v) covers the block of pixels starting at (factor * u, factor * v), and the
+  // center of that block is at (factor * u + (factor - 1) / 2, factor * v + (factor - 1) / 2) in the full image.
   const auto camera_matrix = intrinsics.cameraMatrix();
-  msg->K[0] = camera_matrix.fx().value();
-  msg->K[2] = camera_matrix.cx().value();
-  msg->K[4] = camera_matrix.fy().value();
-  msg->K[5] = camera_matrix.cy().value();
+  const auto scale = 1.0 / static_cast<double>(decimation_factor);
+  const auto offset = 0.5 * (static_cast<double>(decimation_factor) - 1.0);
+  const auto fx = camera_matrix.fx().value() * scale;
+  const auto fy = camera_matrix.fy().value() * scale;
+  const auto cx = (camera_matrix.cx().value() - offset) * scale;
+  const auto cy = (camera_matrix.cy().value() - offset) * scale;
+  msg->K[0] = fx;
+  msg->K[2] = cx;
+  msg->K[4] = fy;
+  msg->K[5] = cy;
   msg->K[8] = 1;
 
   // R (identity)
@@ -635,28 +2472,64 @@ sensor_msgs::CameraInfoConstPtr ZividCamera::makeCameraInfo(const std_msgs::Head
   //     [fx'  0  cx' Tx]
   // P = [ 0  fy' cy' Ty]
   //     [ 0   0   1   0]
-  msg->P[0] = camera_matrix.fx().value();
-  msg->P[2] = camera_matrix.cx().value();
-  msg->P[5] = camera_matrix.fy().value();
-  msg->P[6] = camera_matrix.cy().value();
+  msg->P[0] = fx;
+  msg->P[2] = cx;
+  msg->P[5] = fy;
+  msg->P[6] = cy;
   msg->P[10] = 1;
 
   return msg;
 }
 
+sensor_msgs::ImageConstPtr ZividCamera::makeRectifiedImage(const sensor_msgs::Image& image,
+                                                           const Zivid::CameraIntrinsics& intrinsics)
+{
+  // The remap table only depends on the intrinsics and the resolution, so it is computed once and reused until the
+  // camera (or the resolution) changes
+  const auto model = toPinholeCameraModel(intrinsics);
+  if (!rectification_map_ || !(rectification_map_->model() == model) || rectification_map_->width() != image.width ||
+      rectification_map_->height() != image.height)
+  {
+    ROS_INFO("Computing rectification map for %ux%u images", image.width, image.height);
+    rectification_map_ = std::make_unique<RectificationMap>(model, image.width, image.height);
+  }
+
+  auto msg = boost::make_shared<sensor_msgs::Image>();
+  msg->header = image.header;
+  msg->height = image.height;
+  msg->width = image.width;
+  msg->encoding = image.encoding;
+  msg->is_bigendian = image.is_bigendian;
+  msg->step = image.step;
+  msg->data.resize(image.data.size());
+  if (image.encoding == sensor_msgs::image_encodings::TYPE_32FC1)
+  {
+    rectification_map_->remapNearest(reinterpret_cast<const float*>(image.data.data()),
+                                     reinterpret_cast<float*>(msg->data.data()), *thread_pool_);
+  }
+  else
+  {
+    rectification_map_->remapBilinear(image.data.data(), image.step / image.width, msg->data.data(), *thread_pool_);
+  }
+  return msg;
+}
+
 template <typename ConfigType>
 template <typename ZividSettings>
 ZividCamera::ConfigDRServer<ConfigType>::ConfigDRServer(const std::string& name, ros::NodeHandle& nh,
-                                                        const ZividSettings& defaultSettings)
-  : name_(name), dr_server_(dr_server_mutex_, ros::NodeHandle(nh, name_)), config_(ConfigType::__getDefault__())
+                                                        const ZividSettings& defaultSettings,
+                                                        std::function<void()> on_reconfigured)
+  : name_(name)
+  , dr_server_(dr_server_mutex_, ros::NodeHandle(nh, name_))
+  , config_(ConfigType::__getDefault__())
+  , config_min_(zividSettingsToMinConfig<ConfigType>(defaultSettings))
+  , config_max_(zividSettingsToMaxConfig<ConfigType>(defaultSettings))
+  , on_reconfigured_(std::move(on_reconfigured))
 {
   static_assert(std::is_same_v<ZividSettings, Zivid::Settings> || std::is_same_v<ZividSettings, Zivid::Settings2D>);
 
-  const auto config_min = zividSettingsToMinConfig<ConfigType>(defaultSettings);
-  dr_server_.setConfigMin(config_min);
-
-  const auto config_max = zividSettingsToMaxConfig<ConfigType>(defaultSettings);
-  dr_server_.setConfigMax(config_max);
+  dr_server_.setConfigMin(config_min_);
+  dr_server_.setConfigMax(config_max_);
 
   const auto default_config = zividSettingsToConfig<ConfigType>(defaultSettings);
   dr_server_.setConfigDefault(default_config);
@@ -666,6 +2539,10 @@ ZividCamera::ConfigDRServer<ConfigType>::ConfigDRServer(const std::string& name,
   auto cb = [this](const ConfigType& config, uint32_t /*level*/) {
     ROS_INFO("Configuration '%s' changed", name_.c_str());
     config_ = config;
+    if (on_reconfigured_)
+    {
+      on_reconfigured_();
+    }
   };
   using CallbackType = typename decltype(dr_server_)::CallbackType;
   dr_server_.setCallback(CallbackType(cb));
@@ -674,10 +2551,77 @@ ZividCamera::ConfigDRServer<ConfigType>::ConfigDRServer(const std::string& name,
 template <typename ConfigType>
 void ZividCamera::ConfigDRServer<ConfigType>::setConfig(const ConfigType& cfg)
 {
+  // The server calls the callback that sets config_ with the same mutex locked
+  boost::recursive_mutex::scoped_lock lock(dr_server_mutex_);
   config_ = cfg;
   dr_server_.updateConfig(config_);
 }
 
+template <typename ConfigType>
+ConfigType ZividCamera::ConfigDRServer<ConfigType>::configFromMessage(const dynamic_reconfigure::Config& msg) const
+{
+  const auto& descriptions = ConfigType::__getParamDescriptions__();
+  const auto check_known = [&](const auto& parameters) {
+    for (const auto& parameter : parameters)
+    {
+      if (std::none_of(descriptions.begin(), descriptions.end(),
+                       [&](const auto& description) { return description->name == parameter.name; }))
+      {
+        throw std::runtime_error("Unknown parameter '" + parameter.name + "' for " + name_);
+      }
+    }
+  };
+  check_known(msg.bools);
+  check_known(msg.ints);
+  check_known(msg.strs);
+  check_known(msg.doubles);
+
+  auto config = this->config();
+  // __fromMessage__ takes a non-const reference, but does not modify the message
+  auto msg_copy = msg;
+  if (!config.__fromMessage__(msg_copy))
+  {
+    throw std::runtime_error("Invalid parameters for " + name_);
+  }
+
+  // The parameters of a config message are in the same order for every config of the same type
+  dynamic_reconfigure::Config values;
+  dynamic_reconfigure::Config min_values;
+  dynamic_reconfigure::Config max_values;
+  config.__toMessage__(values);
+  config_min_.__toMessage__(min_values);
+  config_max_.__toMessage__(max_values);
+  const auto check_range = [&](const auto& parameters, const auto& min_parameters, const auto& max_parameters) {
+    for (std::size_t i = 0; i < parameters.size(); i++)
+    {
+      if (parameters[i].value < min_parameters[i].value || parameters[i].value > max_parameters[i].value)
+      {
+        std::ostringstream error;
+        error << name_ << "/" << parameters[i].name << " is " << parameters[i].value << ", which is outside ["
+              << min_parameters[i].value << ", " << max_parameters[i].value << "]";
+        throw std::runtime_error(error.str());
+      }
+    }
+  };
+  check_range(values.ints, min_values.ints, max_values.ints);
+  check_range(values.doubles, min_values.doubles, max_values.doubles);
+  return config;
+}
+
+template <typename Service>
+ros::ServiceServer ZividCamera::advertiseCaptureService(const std::string& name,
+                                                        bool (ZividCamera::*handler)(typename Service::Request&,
+                                                                                     typename Service::Response&))
+{
+  auto options = ros::AdvertiseServiceOptions::create<Service>(
+      name,
+      [this, handler](typename Service::Request& req, typename Service::Response& res) {
+        return (this->*handler)(req, res);
+      },
+      ros::VoidPtr(), &capture_callback_queue_);
+  return nh_.advertiseService(options);
+}
+
 template class ZividCamera::ConfigDRServer<zivid_camera::CaptureGeneralConfig>;
 template class ZividCamera::ConfigDRServer<zivid_camera::CaptureFrameConfig>;
 template class ZividCamera::ConfigDRServer<zivid_camera::Capture2DFrameConfig>;
@@ -0,0 +1,145 @@
+#ifdef __clang__
+#pragma clang diagnostic push
+// Errors to ignore for this entire file
+#pragma clang diagnostic ignored "-Wglobal-constructors"  // error triggered by gtest fixtures
+#endif
+
+#include "capture_coalescer.h"
+
+#include "gtest_include_wrapper.h"
+
+#include <atomic>
+#include <future>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace
+{
+zivid_camera::CaptureCoalescer::RunExclusive lockingWith(std::mutex& capture_mutex)
+{
+  return [&capture_mutex](const std::function<void()>& job) {
+    std::lock_guard<std::mutex> lock(capture_mutex);
+    job();
+  };
+}
+
+void waitForRequests(const zivid_camera::CaptureCoalescer& coalescer, std::uint64_t num_requests)
+{
+  while (coalescer.statistics().num_requests < num_requests)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+}
+}  // namespace
+
+TEST(CaptureCoalescerTest, testPendingRequestsShareOneAcquisition)
+{
+  std::mutex capture_mutex;
+  zivid_camera::CaptureCoalescer coalescer(std::chrono::nanoseconds(0));
+  const auto exclusive = lockingWith(capture_mutex);
+  std::atomic<int> num_acquired_a(0);
+  std::atomic<int> num_acquired_b(0);
+
+  std::vector<std::thread> requests;
+  {
+    // The camera is busy, so the acquisitions stay pending until all the requests have arrived
+    std::lock_guard<std::mutex> busy(capture_mutex);
+    requests.emplace_back([&]() { coalescer.request("a", exclusive, [&]() { num_acquired_a++; }); });
+    waitForRequests(coalescer, 1);
+    for (int i = 0; i < 3; i++)
+    {
+      requests.emplace_back([&]() { coalescer.request("a", exclusive, [&]() { num_acquired_a++; }); });
+    }
+    requests.emplace_back([&]() { coalescer.request("b", exclusive, [&]() { num_acquired_b++; }); });
+    waitForRequests(coalescer, 5);
+  }
+  for (auto& request : requests)
+  {
+    request.join();
+  }
+
+  ASSERT_EQ(num_acquired_a, 1);
+  ASSERT_EQ(num_acquired_b, 1);
+  const auto statistics = coalescer.statistics();
+  ASSERT_EQ(statistics.num_requests, 5U);
+  ASSERT_EQ(statistics.num_acquisitions, 2U);
+  ASSERT_EQ(statistics.num_coalesced, 3U);
+}
+
+TEST(CaptureCoalescerTest, testFreshnessWindowLimitsJoiningInFlightAcquisitions)
+{
+  for (const auto window : { std::chrono::nanoseconds(0), std::chrono::nanoseconds(std::chrono::hours(1)) })
+  {
+    std::mutex capture_mutex;
+    zivid_camera::CaptureCoalescer coalescer(window);
+    const auto exclusive = lockingWith(capture_mutex);
+    std::atomic<int> num_acquired(0);
+    std::promise<void> started;
+    std::promise<void> finish;
+    auto finish_future = finish.get_future().share();
+
+    std::thread first([&]() {
+      coalescer.request("a", exclusive, [&]() {
+        num_acquired++;
+        started.set_value();
+        finish_future.wait();
+      });
+    });
+    started.get_future().wait();
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    std::thread second([&]() { coalescer.request("a", exclusive, [&]() { num_acquired++; }); });
+    waitForRequests(coalescer, 2);
+    finish.set_value();
+    first.join();
+    second.join();
+
+    // With a window of 0 the second request arrives too late to join the first acquisition
+    ASSERT_EQ(num_acquired, window.count() == 0 ? 2 : 1);
+    ASSERT_EQ(coalescer.statistics().num_coalesced, window.count() == 0 ? 0U : 1U);
+  }
+}
+
+TEST(CaptureCoalescerTest, testErrorIsRethrownInJoinedRequests)
+{
+  std::mutex capture_mutex;
+  zivid_camera::CaptureCoalescer coalescer(std::chrono::nanoseconds(0));
+  const auto exclusive = lockingWith(capture_mutex);
+  std::atomic<int> num_errors(0);
+  const auto request = [&]() {
+    try
+    {
+      coalescer.request("a", exclusive, []() { throw std::runtime_error("Capture failed"); });
+    }
+    catch (const std::runtime_error&)
+    {
+      num_errors++;
+    }
+  };
+
+  std::vector<std::thread> requests;
+  {
+    std::lock_guard<std::mutex> busy(capture_mutex);
+    requests.emplace_back(request);
+    waitForRequests(coalescer, 1);
+    requests.emplace_back(request);
+    waitForRequests(coalescer, 2);
+  }
+  for (auto& thread : requests)
+  {
+    thread.join();
+  }
+  ASSERT_EQ(num_errors, 2);
+  ASSERT_EQ(coalescer.statistics().num_acquisitions, 1U);
+
+  // A failed acquisition is not joined by later requests
+  ASSERT_THROW(coalescer.request("a", exclusive, []() { throw std::runtime_error("Capture failed"); }),
+               std::runtime_error);
+  ASSERT_EQ(coalescer.statistics().num_acquisitions, 2U);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,184 @@
+#ifdef __clang__
+#pragma clang diagnostic push
+// Errors to ignore for this entire file
+#pragma clang diagnostic ignored "-Wglobal-constructors"  // error triggered by gtest fixtures
+#endif
+
+#include "capture_recorder.h"
+
+#include "gtest_include_wrapper.h"
+
+#include <dirent.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+constexpr std::size_t width = 5;
+constexpr std::size_t height = 3;
+
+std::shared_ptr<const zivid_camera::CapturedFrame> makeFrame()
+{
+  Zivid::PointCloud point_cloud(width, height);
+  for (std::size_t i = 0; i < point_cloud.size(); i++)
+  {
+    auto& point = point_cloud.dataPtr()[i];
+    point.x = static_cast<float>(i);
+    point.y = 2.0f * static_cast<float>(i);
+    point.z = 1000.0f;
+    point.contrast = 1.0f;
+    point.rgba = static_cast<std::uint32_t>(i);
+  }
+  return std::make_shared<const zivid_camera::CapturedFrame>(
+      zivid_camera::CapturedFrame{ std::move(point_cloud), std::nullopt, std::nullopt });
+}
+
+zivid_camera::RecordingMetadata makeMetadata()
+{
+  return zivid_camera::RecordingMetadata{ 7, 100, 5, "zivid_optical_frame" };
+}
+
+std::vector<char> readFile(const std::string& path)
+{
+  std::ifstream file(path, std::ios::binary);
+  return std::vector<char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+class CaptureRecorderTest : public testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    char directory[] = "/tmp/zivid_camera_recorder_test_XXXXXX";
+    ASSERT_NE(mkdtemp(directory), nullptr);
+    directory_ = directory;
+  }
+
+  void TearDown() override
+  {
+    for (const auto& file : files())
+    {
+      unlink((directory_ + "/" + file).c_str());
+    }
+    rmdir(directory_.c_str());
+  }
+
+  std::vector<std::string> files() const
+  {
+    std::vector<std::string> names;
+    DIR* dir = opendir(directory_.c_str());
+    while (const auto* entry = readdir(dir))
+    {
+      if (entry->d_name[0] != '.')
+      {
+        names.emplace_back(entry->d_name);
+      }
+    }
+    closedir(dir);
+    return names;
+  }
+
+  zivid_camera::CaptureRecorder::Parameters parameters(zivid_camera::RecordingFormat format) const
+  {
+    return zivid_camera::CaptureRecorder::Parameters{ directory_, format, 2, 1024 * 1024, 2 };
+  }
+
+  std::string directory_;
+};
+}  // namespace
+
+TEST_F(CaptureRecorderTest, testChunkedFormat)
+{
+  {
+    zivid_camera::CaptureRecorder recorder(parameters(zivid_camera::RecordingFormat::Chunked));
+    ASSERT_TRUE(recorder.record(makeMetadata(), makeFrame()));
+  }
+
+  ASSERT_EQ(files(), std::vector<std::string>{ "100_000000005_7.zpc" });
+  const auto data = readFile(directory_ + "/100_000000005_7.zpc");
+
+  zivid_camera::RecordingFileHeader header{};
+  ASSERT_GE(data.size(), sizeof(header));
+  std::memcpy(&header, data.data(), sizeof(header));
+  ASSERT_EQ(std::memcmp(header.magic, zivid_camera::recording_file_magic, sizeof(header.magic)), 0);
+  ASSERT_EQ(header.width, width);
+  ASSERT_EQ(header.height, height);
+  ASSERT_EQ(header.point_step, 20U);
+  ASSERT_EQ(header.num_chunks, 2U);
+  ASSERT_EQ(header.header_seq, 7U);
+  ASSERT_STREQ(header.frame_id, "zivid_optical_frame");
+
+  std::vector<zivid_camera::RecordingChunkIndexEntry> index(header.num_chunks);
+  std::memcpy(index.data(), data.data() + sizeof(header), index.size() * sizeof(index[0]));
+  ASSERT_EQ(index[1].first_row, 2U);
+  ASSERT_EQ(index[1].num_rows, 1U);
+  for (const auto& entry : index)
+  {
+    ASSERT_EQ(entry.offset % zivid_camera::recording_chunk_alignment, 0U);
+    ASSERT_EQ(entry.size, entry.num_rows * width * 20U);
+    ASSERT_LE(entry.offset + entry.size, data.size());
+  }
+
+  // The last point, converted to meters
+  float xyz[3];
+  std::memcpy(xyz, data.data() + index[1].offset + (width - 1) * 20U, sizeof(xyz));
+  ASSERT_FLOAT_EQ(xyz[0], 0.014f);
+  ASSERT_FLOAT_EQ(xyz[1], 0.028f);
+  ASSERT_FLOAT_EQ(xyz[2], 1.0f);
+}
+
+TEST_F(CaptureRecorderTest, testPcdFormat)
+{
+  {
+    zivid_camera::CaptureRecorder recorder(parameters(zivid_camera::RecordingFormat::Pcd));
+    ASSERT_TRUE(recorder.record(makeMetadata(), makeFrame()));
+  }
+
+  const auto data = readFile(directory_ + "/100_000000005_7.pcd");
+  const std::string data_line = "DATA binary\n";
+  const auto header_end = std::string(data.begin(), data.end()).find(data_line);
+  ASSERT_NE(header_end, std::string::npos);
+  ASSERT_EQ(data.size(), header_end + data_line.size() + width * height * 20U);
+}
+
+TEST_F(CaptureRecorderTest, testZdfFormatWithoutFrameFallsBackToChunked)
+{
+  {
+    zivid_camera::CaptureRecorder recorder(parameters(zivid_camera::RecordingFormat::Zdf));
+    ASSERT_TRUE(recorder.record(makeMetadata(), makeFrame()));
+  }
+  ASSERT_EQ(files(), std::vector<std::string>{ "100_000000005_7.zpc" });
+}
+
+TEST_F(CaptureRecorderTest, testCaptureIsDroppedWhenQueueIsFull)
+{
+  auto params = parameters(zivid_camera::RecordingFormat::Chunked);
+  params.max_queue_bytes = width * height * 20U - 1;
+  zivid_camera::CaptureRecorder recorder(params);
+  ASSERT_FALSE(recorder.record(makeMetadata(), makeFrame()));
+  const auto statistics = recorder.statistics();
+  ASSERT_EQ(statistics.num_dropped, 1U);
+  ASSERT_EQ(statistics.num_recorded, 0U);
+  ASSERT_EQ(statistics.queue_bytes, 0U);
+}
+
+TEST_F(CaptureRecorderTest, testMissingDirectoryThrows)
+{
+  auto params = parameters(zivid_camera::RecordingFormat::Chunked);
+  params.directory = directory_ + "/does_not_exist";
+  ASSERT_THROW(zivid_camera::CaptureRecorder{ params }, std::runtime_error);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
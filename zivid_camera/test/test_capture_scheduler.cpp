@@ -0,0 +1,171 @@
+#ifdef __clang__
+#pragma clang diagnostic push
+// Errors to ignore for this entire file
+#pragma clang diagnostic ignored "-Wglobal-constructors"  // error triggered by gtest fixtures
+#endif
+
+#include "capture_scheduler.h"
+
+#include "gtest_include_wrapper.h"
+
+#include <atomic>
+#include <future>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace
+{
+// Occupies the scheduler until release() is called, so that the requests under test queue up behind it
+class BlockingJob
+{
+public:
+  explicit BlockingJob(zivid_camera::CaptureScheduler& scheduler)
+    : thread_([this, &scheduler]() {
+      scheduler.run({ 0, std::nullopt }, [this]() {
+        started_.set_value();
+        release_.get_future().wait();
+      });
+    })
+  {
+    started_.get_future().wait();
+  }
+
+  ~BlockingJob()
+  {
+    thread_.join();
+  }
+
+  void release()
+  {
+    release_.set_value();
+  }
+
+private:
+  std::promise<void> started_;
+  std::promise<void> release_;
+  std::thread thread_;
+};
+
+void waitUntilWaiting(zivid_camera::CaptureScheduler& scheduler, std::size_t num_waiting)
+{
+  while (scheduler.numWaiting() < num_waiting)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+}
+}  // namespace
+
+TEST(CaptureSchedulerTest, testJobsRunByPriorityThenDeadlineThenArrival)
+{
+  zivid_camera::CaptureScheduler scheduler;
+  std::mutex order_mutex;
+  std::vector<int> order;
+  const auto now = std::chrono::steady_clock::now();
+  const std::vector<zivid_camera::CaptureScheduler::Request> requests{
+    { 0, std::nullopt },                           // 3
+    { -1, std::nullopt },                          // 5
+    { 0, now + std::chrono::hours(2) },            // 2
+    { 5, std::nullopt },                           // 0
+    { 0, now + std::chrono::hours(1) },            // 1
+    { 0, std::nullopt },                           // 4
+  };
+
+  std::vector<std::thread> threads;
+  {
+    BlockingJob blocking(scheduler);
+    for (std::size_t i = 0; i < requests.size(); i++)
+    {
+      threads.emplace_back([&, i]() {
+        scheduler.run(requests[i], [&, i]() {
+          std::lock_guard<std::mutex> lock(order_mutex);
+          order.push_back(static_cast<int>(i));
+        });
+      });
+      waitUntilWaiting(scheduler, i + 1);
+    }
+    blocking.release();
+  }
+  for (auto& thread : threads)
+  {
+    thread.join();
+  }
+  ASSERT_EQ(order, (std::vector<int>{ 3, 4, 2, 0, 5, 1 }));
+
+  const auto statistics = scheduler.takeWaitStatistics();
+  ASSERT_EQ(statistics.size(), 3U);
+  ASSERT_EQ(statistics[0].priority, -1);
+  ASSERT_EQ(statistics[0].wait.count, 1U);
+  ASSERT_EQ(statistics[1].priority, 0);
+  ASSERT_EQ(statistics[1].wait.count, 5U);
+  ASSERT_EQ(statistics[2].priority, 5);
+  ASSERT_EQ(statistics[2].wait.count, 1U);
+  ASSERT_EQ(scheduler.numWaiting(), 0U);
+}
+
+TEST(CaptureSchedulerTest, testExpiredRequestIsDropped)
+{
+  zivid_camera::CaptureScheduler scheduler;
+  bool expired_job_ran = false;
+  {
+    BlockingJob blocking(scheduler);
+    const zivid_camera::CaptureScheduler::Request request{ 0, std::chrono::steady_clock::now() +
+                                                                   std::chrono::milliseconds(10) };
+    ASSERT_THROW(scheduler.run(request, [&]() { expired_job_ran = true; }), std::runtime_error);
+    blocking.release();
+  }
+  ASSERT_FALSE(expired_job_ran);
+
+  // The scheduler is free again after a failing job
+  ASSERT_THROW(scheduler.run({ 0, std::nullopt }, []() { throw std::runtime_error("Capture failed"); }),
+               std::runtime_error);
+  bool ran = false;
+  scheduler.run({ 0, std::nullopt }, [&]() { ran = true; });
+  ASSERT_TRUE(ran);
+
+  const auto statistics = scheduler.takeWaitStatistics();
+  ASSERT_EQ(statistics.size(), 1U);
+  ASSERT_EQ(statistics[0].num_expired, 1U);
+  ASSERT_EQ(scheduler.takeWaitStatistics()[0].num_expired, 0U);
+}
+
+TEST(CaptureSchedulerTest, testCancelledRequestIsDropped)
+{
+  zivid_camera::CaptureScheduler scheduler;
+  std::atomic<bool> cancelled(false);
+  bool cancelled_job_ran = false;
+  bool next_job_ran = false;
+  {
+    BlockingJob blocking(scheduler);
+    std::thread cancelled_thread([&]() {
+      ASSERT_THROW(scheduler.run({ 5, std::nullopt }, [&]() { cancelled_job_ran = true; }, cancelled),
+                   std::runtime_error);
+    });
+    waitUntilWaiting(scheduler, 1);
+    std::thread next_thread([&]() { scheduler.run({ 0, std::nullopt }, [&]() { next_job_ran = true; }); });
+    waitUntilWaiting(scheduler, 2);
+
+    cancelled = true;
+    scheduler.notifyCancelled();
+    cancelled_thread.join();
+    ASSERT_EQ(scheduler.numWaiting(), 1U);
+    blocking.release();
+    next_thread.join();
+  }
+  ASSERT_FALSE(cancelled_job_ran);
+  ASSERT_TRUE(next_job_ran);
+
+  // A request that is already cancelled does not wait, and is not counted as expired
+  ASSERT_THROW(scheduler.run({ 0, std::nullopt }, []() {}, cancelled), std::runtime_error);
+  for (const auto& statistics : scheduler.takeWaitStatistics())
+  {
+    ASSERT_EQ(statistics.num_expired, 0U);
+  }
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,90 @@
+#ifdef __clang__
+#pragma clang diagnostic push
+// Errors to ignore for this entire file
+#pragma clang diagnostic ignored "-Wglobal-constructors"  // error triggered by gtest fixtures
+#endif
+
+#include "decoded_frame_cache.h"
+
+#include "gtest_include_wrapper.h"
+
+namespace
+{
+constexpr std::size_t point_cloud_bytes = 4 * 2 * sizeof(Zivid::Point);
+
+zivid_camera::CapturedFrame makeFrame(float z)
+{
+  Zivid::PointCloud point_cloud(4, 2);
+  for (std::size_t i = 0; i < point_cloud.size(); i++)
+  {
+    point_cloud.dataPtr()[i].z = z;
+  }
+  return zivid_camera::CapturedFrame{ std::move(point_cloud), std::nullopt, std::nullopt };
+}
+}  // namespace
+
+TEST(DecodedFrameCacheTest, testCachedFrameIsReturnedAsCopy)
+{
+  // More chunks than points, so that the copies are split in chunks of a single point
+  zivid_camera::ThreadPool thread_pool(2, 8);
+  zivid_camera::DecodedFrameCache cache(point_cloud_bytes, thread_pool);
+  ASSERT_FALSE(cache.get("a"));
+  cache.put("a", makeFrame(1.0f));
+
+  auto cached = cache.get("a");
+  ASSERT_TRUE(cached);
+  ASSERT_EQ(cached->point_cloud.width(), 4U);
+  ASSERT_EQ(cached->point_cloud.dataPtr()[7].z, 1.0f);
+
+  cached->point_cloud.dataPtr()[7].z = 2.0f;
+  ASSERT_EQ(cache.get("a")->point_cloud.dataPtr()[7].z, 1.0f);
+  ASSERT_EQ(cache.numHits(), 2U);
+  ASSERT_EQ(cache.numMisses(), 1U);
+}
+
+TEST(DecodedFrameCacheTest, testLeastRecentlyUsedIsEvicted)
+{
+  zivid_camera::ThreadPool thread_pool(2, 8);
+  zivid_camera::DecodedFrameCache cache(2 * point_cloud_bytes, thread_pool);
+  cache.put("a", makeFrame(1.0f));
+  cache.put("b", makeFrame(2.0f));
+  ASSERT_TRUE(cache.get("a"));
+  cache.put("c", makeFrame(3.0f));
+
+  ASSERT_EQ(cache.numEntries(), 2U);
+  ASSERT_EQ(cache.sizeBytes(), 2 * point_cloud_bytes);
+  ASSERT_TRUE(cache.get("a"));
+  ASSERT_FALSE(cache.get("b"));
+  ASSERT_TRUE(cache.get("c"));
+}
+
+TEST(DecodedFrameCacheTest, testZividFrameIsNotCached)
+{
+  zivid_camera::ThreadPool thread_pool(2, 8);
+  zivid_camera::DecodedFrameCache cache(point_cloud_bytes, thread_pool);
+  auto frame = makeFrame(1.0f);
+  frame.frame = Zivid::Frame{};
+  cache.put("a", frame);
+
+  // Only the point cloud counts towards the size limit, since it is all that the cache keeps
+  ASSERT_EQ(cache.sizeBytes(), point_cloud_bytes);
+  auto cached = cache.get("a");
+  ASSERT_TRUE(cached);
+  ASSERT_FALSE(cached->frame);
+  ASSERT_EQ(cached->point_cloud.dataPtr()[0].z, 1.0f);
+}
+
+TEST(DecodedFrameCacheTest, testTooLargeFrameIsNotCached)
+{
+  zivid_camera::ThreadPool thread_pool(2, 8);
+  zivid_camera::DecodedFrameCache cache(point_cloud_bytes - 1, thread_pool);
+  cache.put("a", makeFrame(1.0f));
+  ASSERT_EQ(cache.numEntries(), 0U);
+  ASSERT_FALSE(cache.get("a"));
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
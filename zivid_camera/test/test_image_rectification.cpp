@@ -0,0 +1,126 @@
+#ifdef __clang__
+#pragma clang diagnostic push
+// Errors to ignore for this entire file
+#pragma clang diagnostic ignored "-Wglobal-constructors"  // error triggered by gtest fixtures
+#endif
+
+#include "image_rectification.h"
+
+#include "gtest_include_wrapper.h"
+
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+// Not a multiple of the tile size, to cover partial tiles
+constexpr std::size_t width = 75;
+constexpr std::size_t height = 41;
+
+zivid_camera::PinholeCameraModel makeModel(double k1)
+{
+  return zivid_camera::PinholeCameraModel{ 80.0, 80.0, 37.0, 20.0, k1, 0.0, 0.0, 0.0, 0.0 };
+}
+
+std::vector<std::uint8_t> makeColorImage()
+{
+  std::vector<std::uint8_t> image(width * height * 3);
+  for (std::size_t i = 0; i < image.size(); i++)
+  {
+    image[i] = static_cast<std::uint8_t>((i * 7) % 256);
+  }
+  return image;
+}
+}  // namespace
+
+TEST(ImageRectificationTest, testWithoutDistortionImagesAreUnchanged)
+{
+  const zivid_camera::RectificationMap map(makeModel(0.0), width, height);
+  zivid_camera::ThreadPool thread_pool(4, 2);
+
+  const auto color = makeColorImage();
+  std::vector<std::uint8_t> rectified_color(color.size());
+  map.remapBilinear(color.data(), 3, rectified_color.data(), thread_pool);
+  ASSERT_EQ(rectified_color, color);
+
+  std::vector<float> depth(width * height);
+  for (std::size_t i = 0; i < depth.size(); i++)
+  {
+    depth[i] = i % 5 == 0 ? std::numeric_limits<float>::quiet_NaN() : static_cast<float>(i);
+  }
+  std::vector<float> rectified_depth(depth.size());
+  map.remapNearest(depth.data(), rectified_depth.data(), thread_pool);
+  for (std::size_t i = 0; i < depth.size(); i++)
+  {
+    if (std::isnan(depth[i]))
+    {
+      ASSERT_TRUE(std::isnan(rectified_depth[i]));
+    }
+    else
+    {
+      ASSERT_EQ(rectified_depth[i], depth[i]);
+    }
+  }
+}
+
+TEST(ImageRectificationTest, testBarrelDistortionIsRemoved)
+{
+  // With barrel distortion (k1 < 0) the raw image is compressed towards the center, so each rectified pixel samples
+  // closer to the center, and all rectified pixels sample from inside the raw image
+  const zivid_camera::RectificationMap map(makeModel(-0.5), width, height);
+  zivid_camera::ThreadPool thread_pool(4, 2);
+
+  // Depth image where each pixel holds its column
+  std::vector<float> depth(width * height);
+  for (std::size_t i = 0; i < depth.size(); i++)
+  {
+    depth[i] = static_cast<float>(i % width);
+  }
+  std::vector<float> rectified(depth.size());
+  map.remapNearest(depth.data(), rectified.data(), thread_pool);
+
+  // Center row: x = (u - cx) / fx, and the raw column is fx * x * (1 + k1 * x^2) + cx
+  const std::size_t row = 20;
+  for (std::size_t u = 0; u < width; u++)
+  {
+    const double x = (static_cast<double>(u) - 37.0) / 80.0;
+    const double expected = std::round(80.0 * x * (1.0 - 0.5 * x * x) + 37.0);
+    ASSERT_EQ(rectified[row * width + u], static_cast<float>(expected));
+  }
+  ASSERT_FALSE(std::isnan(rectified[0]));
+  ASSERT_FALSE(std::isnan(rectified[width * height - 1]));
+}
+
+TEST(ImageRectificationTest, testPixelsOutsideRawImage)
+{
+  // Pincushion distortion (k1 > 0) samples outside the raw image near the corners
+  const zivid_camera::RectificationMap map(makeModel(2.0), width, height);
+  zivid_camera::ThreadPool thread_pool(4, 2);
+
+  std::vector<float> depth(width * height, 1.0f);
+  std::vector<float> rectified_depth(depth.size());
+  map.remapNearest(depth.data(), rectified_depth.data(), thread_pool);
+  ASSERT_TRUE(std::isnan(rectified_depth[0]));
+  ASSERT_EQ(rectified_depth[20 * width + 37], 1.0f);
+
+  std::vector<std::uint8_t> color(width * height * 4, 255);
+  std::vector<std::uint8_t> rectified_color(color.size());
+  map.remapBilinear(color.data(), 4, rectified_color.data(), thread_pool);
+  ASSERT_EQ(rectified_color[0], 0);
+  ASSERT_EQ(rectified_color[(20 * width + 37) * 4], 255);
+}
+
+TEST(ImageRectificationTest, testInvalidFocalLengthThrows)
+{
+  auto model = makeModel(0.0);
+  model.fx = 0.0;
+  ASSERT_THROW(zivid_camera::RectificationMap(model, width, height), std::runtime_error);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
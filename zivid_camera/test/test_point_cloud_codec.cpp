@@ -0,0 +1,137 @@
+#ifdef __clang__
+#pragma clang diagnostic push
+// Errors to ignore for this entire file
+#pragma clang diagnostic ignored "-Wglobal-constructors"  // error triggered by gtest fixtures
+#endif
+
+#include "point_cloud_codec.h"
+
+#include "gtest_include_wrapper.h"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+constexpr std::size_t width = 67;
+constexpr std::size_t height = 41;
+constexpr std::size_t rows_per_band = 8;
+
+float readFloat(const std::vector<std::uint8_t>& points, std::size_t point, std::size_t field)
+{
+  float value;
+  std::memcpy(&value, points.data() + point * zivid_camera::point_cloud_codec_point_step + field * 4, sizeof(value));
+  return value;
+}
+
+void writeFloat(std::vector<std::uint8_t>& points, std::size_t point, std::size_t field, float value)
+{
+  std::memcpy(points.data() + point * zivid_camera::point_cloud_codec_point_step + field * 4, &value, sizeof(value));
+}
+
+// A smooth surface with noise, random colors and some missing points, similar to a real capture
+std::vector<std::uint8_t> makePoints()
+{
+  std::mt19937 generator(42);
+  std::uniform_real_distribution<float> noise(-0.0005f, 0.0005f);
+  std::uniform_int_distribution<int> byte(0, 255);
+  std::bernoulli_distribution missing(0.1);
+
+  std::vector<std::uint8_t> points(width * height * zivid_camera::point_cloud_codec_point_step);
+  for (std::size_t row = 0; row < height; row++)
+  {
+    for (std::size_t col = 0; col < width; col++)
+    {
+      const auto i = row * width + col;
+      const bool is_missing = missing(generator);
+      const float nan = std::numeric_limits<float>::quiet_NaN();
+      writeFloat(points, i, 0, is_missing ? nan : 0.001f * static_cast<float>(col) - 0.03f);
+      writeFloat(points, i, 1, is_missing ? nan : 0.001f * static_cast<float>(row) - 0.02f);
+      const float z = 1.0f + 0.01f * std::sin(0.1f * static_cast<float>(col)) + noise(generator);
+      writeFloat(points, i, 2, is_missing ? nan : z);
+      writeFloat(points, i, 3, static_cast<float>(byte(generator)) / 16.0f);
+      for (std::size_t c = 0; c < 4; c++)
+      {
+        points[i * zivid_camera::point_cloud_codec_point_step + 16 + c] = static_cast<std::uint8_t>(byte(generator));
+      }
+    }
+  }
+  return points;
+}
+}  // namespace
+
+TEST(PointCloudCodecTest, testLosslessRoundTripIsExact)
+{
+  zivid_camera::ThreadPool thread_pool(4, 2);
+  const auto points = makePoints();
+  const auto encoded = zivid_camera::encodePointCloud(points.data(), width, height, 0.0f, rows_per_band, thread_pool);
+  ASSERT_EQ(encoded.band_offsets.size(), (height + rows_per_band - 1) / rows_per_band);
+
+  std::vector<std::uint8_t> decoded(points.size());
+  zivid_camera::decodePointCloud(encoded, width, height, 0.0f, rows_per_band, decoded.data(), thread_pool);
+  ASSERT_EQ(std::memcmp(decoded.data(), points.data(), points.size()), 0);
+}
+
+TEST(PointCloudCodecTest, testQuantizedRoundTripIsWithinResolution)
+{
+  constexpr float resolution = 0.0001f;
+  zivid_camera::ThreadPool thread_pool(4, 2);
+  const auto points = makePoints();
+  const auto encoded =
+      zivid_camera::encodePointCloud(points.data(), width, height, resolution, rows_per_band, thread_pool);
+  ASSERT_LT(encoded.data.size(), points.size() / 2);
+
+  std::vector<std::uint8_t> decoded(points.size());
+  zivid_camera::decodePointCloud(encoded, width, height, resolution, rows_per_band, decoded.data(), thread_pool);
+  for (std::size_t i = 0; i < width * height; i++)
+  {
+    for (std::size_t k = 0; k < 3; k++)
+    {
+      const auto original = readFloat(points, i, k);
+      const auto value = readFloat(decoded, i, k);
+      if (std::isnan(original))
+      {
+        ASSERT_TRUE(std::isnan(value));
+      }
+      else
+      {
+        ASSERT_NEAR(value, original, resolution / 2 + 1e-6f);
+      }
+    }
+    ASSERT_EQ(std::memcmp(decoded.data() + i * zivid_camera::point_cloud_codec_point_step + 12,
+                          points.data() + i * zivid_camera::point_cloud_codec_point_step + 12, 8),
+              0);
+  }
+}
+
+TEST(PointCloudCodecTest, testCorruptDataThrows)
+{
+  zivid_camera::ThreadPool thread_pool(4, 2);
+  const auto points = makePoints();
+  auto encoded = zivid_camera::encodePointCloud(points.data(), width, height, 0.0f, rows_per_band, thread_pool);
+  std::vector<std::uint8_t> decoded(points.size());
+
+  auto truncated = encoded;
+  truncated.data.resize(truncated.data.size() / 2);
+  ASSERT_THROW(
+      zivid_camera::decodePointCloud(truncated, width, height, 0.0f, rows_per_band, decoded.data(), thread_pool),
+      std::runtime_error);
+
+  auto missing_band = encoded;
+  missing_band.band_offsets.pop_back();
+  ASSERT_THROW(
+      zivid_camera::decodePointCloud(missing_band, width, height, 0.0f, rows_per_band, decoded.data(), thread_pool),
+      std::runtime_error);
+
+  ASSERT_THROW(zivid_camera::encodePointCloud(points.data(), width, height, 0.0f, 0, thread_pool), std::runtime_error);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
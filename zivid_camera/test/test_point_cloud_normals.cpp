@@ -0,0 +1,136 @@
+#ifdef __clang__
+#pragma clang diagnostic push
+// Errors to ignore for this entire file
+#pragma clang diagnostic ignored "-Wglobal-constructors"  // error triggered by gtest fixtures
+#endif
+
+#include "point_cloud_normals.h"
+
+#include "gtest_include_wrapper.h"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+constexpr std::size_t width = 9;
+constexpr std::size_t height = 7;
+
+// The plane z = 1000 + 0.5 * x (in mm), seen by a camera at the origin
+Zivid::PointCloud makeTiltedPlane()
+{
+  Zivid::PointCloud point_cloud(width, height);
+  for (std::size_t row = 0; row < height; row++)
+  {
+    for (std::size_t col = 0; col < width; col++)
+    {
+      auto& point = point_cloud.dataPtr()[row * width + col];
+      point.x = 10.0f * static_cast<float>(col);
+      point.y = 10.0f * static_cast<float>(row);
+      point.z = 1000.0f + 0.5f * point.x;
+      point.contrast = 1.0f;
+      point.rgba = static_cast<std::uint32_t>(row * width + col);
+    }
+  }
+  return point_cloud;
+}
+
+std::vector<float>
+copyWithNormals(const Zivid::PointCloud& point_cloud, std::size_t neighbor_distance,
+                const zivid_camera::PointTransform& transform = zivid_camera::PointTransform::millimetersToMeters())
+{
+  std::vector<std::uint8_t> data(point_cloud.size() * zivid_camera::point_with_normal_step);
+  zivid_camera::ThreadPool thread_pool(4, 2);
+  zivid_camera::copyPointsWithNormalsInMeters(point_cloud, neighbor_distance, transform, data.data(), thread_pool);
+  std::vector<float> fields(data.size() / sizeof(float));
+  std::memcpy(fields.data(), data.data(), data.size());
+  return fields;
+}
+
+float field(const std::vector<float>& fields, std::size_t point, std::size_t index)
+{
+  return fields[point * zivid_camera::point_with_normal_step / sizeof(float) + index];
+}
+}  // namespace
+
+TEST(PointCloudNormalsTest, testNormalsOfPlanePointTowardsCamera)
+{
+  const auto point_cloud = makeTiltedPlane();
+  const auto fields = copyWithNormals(point_cloud, 2);
+
+  const float expected_length = std::sqrt(0.5f * 0.5f + 1.0f);
+  for (std::size_t i = 0; i < point_cloud.size(); i++)
+  {
+    ASSERT_FLOAT_EQ(field(fields, i, 0), 0.001f * point_cloud.dataPtr()[i].x);
+    ASSERT_FLOAT_EQ(field(fields, i, 2), 0.001f * point_cloud.dataPtr()[i].z);
+    std::uint32_t rgba;
+    std::memcpy(&rgba, &fields[i * zivid_camera::point_with_normal_step / sizeof(float) + 4], sizeof(rgba));
+    ASSERT_EQ(rgba, point_cloud.dataPtr()[i].rgba);
+
+    ASSERT_NEAR(field(fields, i, 5), 0.5f / expected_length, 1e-5f);
+    ASSERT_NEAR(field(fields, i, 6), 0.0f, 1e-5f);
+    ASSERT_NEAR(field(fields, i, 7), -1.0f / expected_length, 1e-5f);
+  }
+}
+
+TEST(PointCloudNormalsTest, testMissingPointsAreHandled)
+{
+  auto point_cloud = makeTiltedPlane();
+  const float nan = std::numeric_limits<float>::quiet_NaN();
+  // A missing point, and a column where all points except one are missing
+  point_cloud.dataPtr()[3 * width + 4].z = nan;
+  for (std::size_t row = 0; row < height; row++)
+  {
+    if (row != 3)
+    {
+      point_cloud.dataPtr()[row * width + 8].z = nan;
+    }
+  }
+
+  const auto fields = copyWithNormals(point_cloud, 1);
+  ASSERT_TRUE(std::isnan(field(fields, 3 * width + 4, 5)));
+  ASSERT_TRUE(std::isnan(field(fields, 3 * width + 8, 5)));
+  // The neighbors of the missing point fall back to one-sided differences
+  ASSERT_LT(field(fields, 3 * width + 3, 7), 0.0f);
+  ASSERT_LT(field(fields, 2 * width + 4, 7), 0.0f);
+}
+
+TEST(PointCloudNormalsTest, testPointsAndNormalsAreTransformed)
+{
+  // Rotate 90 degrees around z and translate, in addition to converting from mm to m
+  const zivid_camera::PointTransform transform{ { 0.0f, -0.001f, 0.0f, 1.0f, 0.001f, 0.0f, 0.0f, 2.0f, 0.0f, 0.0f,
+                                                  0.001f, 3.0f } };
+  const auto point_cloud = makeTiltedPlane();
+  const auto fields = copyWithNormals(point_cloud, 2, transform);
+
+  const float expected_length = std::sqrt(0.5f * 0.5f + 1.0f);
+  for (std::size_t i = 0; i < point_cloud.size(); i++)
+  {
+    const auto& point = point_cloud.dataPtr()[i];
+    ASSERT_FLOAT_EQ(field(fields, i, 0), 1.0f - 0.001f * point.y);
+    ASSERT_FLOAT_EQ(field(fields, i, 1), 2.0f + 0.001f * point.x);
+    ASSERT_FLOAT_EQ(field(fields, i, 2), 3.0f + 0.001f * point.z);
+    ASSERT_NEAR(field(fields, i, 5), 0.0f, 1e-5f);
+    ASSERT_NEAR(field(fields, i, 6), 0.5f / expected_length, 1e-5f);
+    ASSERT_NEAR(field(fields, i, 7), -1.0f / expected_length, 1e-5f);
+  }
+}
+
+TEST(PointCloudNormalsTest, testZeroNeighborDistanceThrows)
+{
+  const auto point_cloud = makeTiltedPlane();
+  std::vector<std::uint8_t> data(point_cloud.size() * zivid_camera::point_with_normal_step);
+  zivid_camera::ThreadPool thread_pool(4, 2);
+  ASSERT_THROW(zivid_camera::copyPointsWithNormalsInMeters(
+                   point_cloud, 0, zivid_camera::PointTransform::millimetersToMeters(), data.data(), thread_pool),
+               std::runtime_error);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,109 @@
+#ifdef __clang__
+#pragma clang diagnostic push
+// Errors to ignore for this entire file
+#pragma clang diagnostic ignored "-Wglobal-constructors"  // error triggered by gtest fixtures
+#endif
+
+#include "point_cloud_processor_chain.h"
+
+#include "gtest_include_wrapper.h"
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+// Adds `offset` to z of every point, and records the order in which the processors run
+class OffsetProcessor : public zivid_camera::PointCloudProcessor
+{
+public:
+  OffsetProcessor(float offset, std::vector<float>& calls)
+    : offset_(offset), calls_(calls)
+  {
+  }
+
+  void initialize(const std::string&, ros::NodeHandle&) override
+  {
+  }
+
+  void process(Zivid::PointCloud& point_cloud, zivid_camera::ThreadPool& thread_pool) override
+  {
+    calls_.push_back(offset_);
+    Zivid::Point* points = point_cloud.dataPtr();
+    const float offset = offset_;
+    thread_pool.parallelFor(0, point_cloud.size(), [points, offset](std::size_t i) { points[i].z += offset; });
+  }
+
+private:
+  float offset_;
+  std::vector<float>& calls_;
+};
+
+class ThrowingProcessor : public zivid_camera::PointCloudProcessor
+{
+public:
+  void initialize(const std::string&, ros::NodeHandle&) override
+  {
+  }
+
+  void process(Zivid::PointCloud&, zivid_camera::ThreadPool&) override
+  {
+    throw std::runtime_error("Processing failed");
+  }
+};
+}  // namespace
+
+TEST(PointCloudProcessorChainTest, testProcessorsRunInOrderInPlace)
+{
+  zivid_camera::ThreadPool thread_pool(2, 2);
+  std::vector<float> calls;
+  zivid_camera::PointCloudProcessorChain chain;
+  ASSERT_TRUE(chain.empty());
+  chain.add("first", std::make_shared<OffsetProcessor>(1.0f, calls));
+  chain.add("second", std::make_shared<OffsetProcessor>(10.0f, calls));
+  ASSERT_FALSE(chain.empty());
+
+  Zivid::PointCloud point_cloud(7, 5);
+  for (std::size_t i = 0; i < point_cloud.size(); i++)
+  {
+    point_cloud.dataPtr()[i].z = static_cast<float>(i);
+  }
+  chain.process(point_cloud, thread_pool);
+  chain.process(point_cloud, thread_pool);
+
+  ASSERT_EQ(calls, (std::vector<float>{ 1.0f, 10.0f, 1.0f, 10.0f }));
+  for (std::size_t i = 0; i < point_cloud.size(); i++)
+  {
+    ASSERT_FLOAT_EQ(point_cloud.dataPtr()[i].z, static_cast<float>(i) + 22.0f);
+  }
+
+  const auto timings = chain.takeTimings();
+  ASSERT_EQ(timings.size(), 2U);
+  ASSERT_EQ(timings[0].name, "first");
+  ASSERT_EQ(timings[1].name, "second");
+  ASSERT_EQ(timings[0].summary.count, 2U);
+  ASSERT_GE(timings[0].max_overall, timings[0].summary.mean);
+  ASSERT_EQ(chain.takeTimings()[1].summary.count, 0U);
+}
+
+TEST(PointCloudProcessorChainTest, testExceptionStopsTheChain)
+{
+  zivid_camera::ThreadPool thread_pool(2, 2);
+  std::vector<float> calls;
+  zivid_camera::PointCloudProcessorChain chain;
+  chain.add("throwing", std::make_shared<ThrowingProcessor>());
+  chain.add("offset", std::make_shared<OffsetProcessor>(1.0f, calls));
+  ASSERT_THROW(chain.add("null", nullptr), std::runtime_error);
+
+  Zivid::PointCloud point_cloud(3, 2);
+  ASSERT_THROW(chain.process(point_cloud, thread_pool), std::runtime_error);
+  ASSERT_TRUE(calls.empty());
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
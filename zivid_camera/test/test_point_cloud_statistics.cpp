@@ -0,0 +1,118 @@
+#ifdef __clang__
+#pragma clang diagnostic push
+// Errors to ignore for this entire file
+#pragma clang diagnostic ignored "-Wglobal-constructors"  // error triggered by gtest fixtures
+#endif
+
+#include "point_cloud_statistics.h"
+
+#include "gtest_include_wrapper.h"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+constexpr std::size_t width = 13;
+constexpr std::size_t height = 11;
+
+// Points at z = 1000 + 10 * col mm, where every third point is missing (NaN)
+Zivid::PointCloud makePointCloud()
+{
+  Zivid::PointCloud point_cloud(width, height);
+  for (std::size_t i = 0; i < point_cloud.size(); i++)
+  {
+    auto& point = point_cloud.dataPtr()[i];
+    const auto col = static_cast<float>(i % width);
+    const auto row = static_cast<float>(i / width);
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    point.x = i % 3 == 0 ? nan : 2.0f * col;
+    point.y = i % 3 == 0 ? nan : -3.0f * row;
+    point.z = i % 3 == 0 ? nan : 1000.0f + 10.0f * col;
+    point.contrast = static_cast<float>(i % 4);
+    point.rgba = static_cast<std::uint32_t>(i);
+  }
+  return point_cloud;
+}
+
+const zivid_camera::PointCloudStatisticsParameters parameters{ 0.995f, 1.095f, 10 };
+}  // namespace
+
+TEST(PointCloudStatisticsTest, testStatisticsMatchSerialComputation)
+{
+  const auto point_cloud = makePointCloud();
+  zivid_camera::ThreadPool thread_pool(4, 3);
+  std::vector<std::uint8_t> dst(point_cloud.size() * sizeof(Zivid::Point));
+  const auto statistics = zivid_camera::transformPointsWithStatistics(
+      point_cloud, zivid_camera::PointTransform::millimetersToMeters(), parameters, dst.data(), thread_pool);
+
+  std::size_t num_valid = 0;
+  double sum_z = 0.0;
+  double sum_contrast = 0.0;
+  float min_y = std::numeric_limits<float>::infinity();
+  std::vector<std::uint32_t> histogram(parameters.z_histogram_bins, 0);
+  for (std::size_t i = 0; i < point_cloud.size(); i++)
+  {
+    const auto& point = point_cloud.dataPtr()[i];
+    Zivid::Point converted;
+    std::memcpy(&converted, dst.data() + i * sizeof(Zivid::Point), sizeof(converted));
+    ASSERT_EQ(converted.rgba, point.rgba);
+    if (std::isnan(point.z))
+    {
+      ASSERT_TRUE(std::isnan(converted.z));
+      continue;
+    }
+    ASSERT_FLOAT_EQ(converted.z, 0.001f * point.z);
+    num_valid++;
+    sum_z += 0.001 * point.z;
+    sum_contrast += point.contrast;
+    min_y = std::min(min_y, 0.001f * point.y);
+    const auto bin = static_cast<std::size_t>((0.001f * point.z - 0.995f) * 100.0f);
+    if (bin < histogram.size())
+    {
+      histogram[bin]++;
+    }
+  }
+
+  ASSERT_EQ(statistics.num_points, point_cloud.size());
+  ASSERT_EQ(statistics.num_valid_points, num_valid);
+  ASSERT_NEAR(statistics.mean[2], sum_z / static_cast<double>(num_valid), 1e-6);
+  ASSERT_NEAR(statistics.mean_contrast, sum_contrast / static_cast<double>(num_valid), 1e-6);
+  ASSERT_FLOAT_EQ(statistics.min[1], min_y);
+  ASSERT_FLOAT_EQ(statistics.min[2], 1.0f);
+  ASSERT_FLOAT_EQ(statistics.max[2], 1.12f);
+  ASSERT_EQ(statistics.z_histogram, histogram);
+  // z = 1.10, 1.11 and 1.12 m are above the histogram range
+  ASSERT_LT(std::accumulate(histogram.begin(), histogram.end(), 0U), num_valid);
+}
+
+TEST(PointCloudStatisticsTest, testAllPointsMissing)
+{
+  zivid_camera::ThreadPool thread_pool(2, 2);
+  auto point_cloud = makePointCloud();
+  for (std::size_t i = 0; i < point_cloud.size(); i++)
+  {
+    point_cloud.dataPtr()[i].z = std::numeric_limits<float>::quiet_NaN();
+  }
+  const auto statistics = zivid_camera::transformPointsWithStatistics(
+      point_cloud, zivid_camera::PointTransform::millimetersToMeters(), parameters, nullptr, thread_pool);
+  ASSERT_EQ(statistics.num_valid_points, 0U);
+  ASSERT_TRUE(std::isnan(statistics.mean[0]));
+  ASSERT_TRUE(std::isnan(statistics.min[2]));
+  ASSERT_EQ(statistics.z_histogram, std::vector<std::uint32_t>(parameters.z_histogram_bins, 0));
+
+  const zivid_camera::PointCloudStatisticsParameters no_bins{ 0.0f, 1.0f, 0 };
+  ASSERT_THROW(zivid_camera::transformPointsWithStatistics(
+                   point_cloud, zivid_camera::PointTransform::millimetersToMeters(), no_bins, nullptr, thread_pool),
+               std::runtime_error);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,79 @@
+#ifdef __clang__
+#pragma clang diagnostic push
+// Errors to ignore for this entire file
+#pragma clang diagnostic ignored "-Wglobal-constructors"  // error triggered by gtest fixtures
+#endif
+
+#include "point_transform.h"
+
+#include "gtest_include_wrapper.h"
+
+#include <cmath>
+
+namespace
+{
+Zivid::Point transformed(const zivid_camera::PointTransform& transform, float x, float y, float z)
+{
+  Zivid::Point point{};
+  point.x = x;
+  point.y = y;
+  point.z = z;
+  point.contrast = 0.5f;
+  point.rgba = 0x11223344U;
+  transform.applyToPoint(point);
+  return point;
+}
+
+void assertPointNear(const Zivid::Point& point, float x, float y, float z)
+{
+  constexpr float tolerance = 1e-5f;
+  ASSERT_NEAR(point.x, x, tolerance);
+  ASSERT_NEAR(point.y, y, tolerance);
+  ASSERT_NEAR(point.z, z, tolerance);
+}
+}  // namespace
+
+TEST(PointTransformTest, testIdentityRotationOnlyConvertsUnitsAndTranslates)
+{
+  const auto transform = zivid_camera::PointTransform::millimetersToMeters({ 0, 0, 0, 1 }, { 0.1, -0.2, 0.3 });
+  const auto point = transformed(transform, 1000.0f, 2000.0f, -500.0f);
+  assertPointNear(point, 1.1f, 1.8f, -0.2f);
+  // Only the coordinates are transformed
+  ASSERT_EQ(point.contrast, 0.5f);
+  ASSERT_EQ(point.rgba, 0x11223344U);
+}
+
+TEST(PointTransformTest, testRotationAboutZ)
+{
+  // 90 degrees about z, which maps x to y and y to -x
+  const double half_angle = std::acos(-1.0) / 4;
+  const std::array<double, 4> rotation{ 0, 0, std::sin(half_angle), std::cos(half_angle) };
+  const auto transform = zivid_camera::PointTransform::millimetersToMeters(rotation, { 1, 0, 0 });
+  assertPointNear(transformed(transform, 1000.0f, 0.0f, 0.0f), 1.0f, 1.0f, 0.0f);
+  assertPointNear(transformed(transform, 0.0f, 1000.0f, 250.0f), 0.0f, 0.0f, 0.25f);
+}
+
+TEST(PointTransformTest, testRotationAboutDiagonal)
+{
+  // 120 degrees about (1, 1, 1), which maps x to y, y to z and z to x
+  const auto transform = zivid_camera::PointTransform::millimetersToMeters({ 0.5, 0.5, 0.5, 0.5 }, { 0, 0, 0 });
+  assertPointNear(transformed(transform, 1000.0f, 2000.0f, 3000.0f), 3.0f, 1.0f, 2.0f);
+
+  // Directions are rotated and scaled, but not translated
+  const auto direction = transform.applyToDirection({ 1000.0f, 0.0f, 0.0f });
+  ASSERT_NEAR(direction[0], 0.0f, 1e-5f);
+  ASSERT_NEAR(direction[1], 1.0f, 1e-5f);
+  ASSERT_NEAR(direction[2], 0.0f, 1e-5f);
+}
+
+TEST(PointTransformTest, testMillimetersToMetersMatchesIdentityTransform)
+{
+  const auto identity = zivid_camera::PointTransform::millimetersToMeters({ 0, 0, 0, 1 }, { 0, 0, 0 });
+  ASSERT_EQ(identity.matrix, zivid_camera::PointTransform::millimetersToMeters().matrix);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
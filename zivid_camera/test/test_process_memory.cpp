@@ -0,0 +1,42 @@
+#ifdef __clang__
+#pragma clang diagnostic push
+// Errors to ignore for this entire file
+#pragma clang diagnostic ignored "-Wglobal-constructors"  // error triggered by gtest fixtures
+#endif
+
+#include "process_memory.h"
+
+#include "gtest_include_wrapper.h"
+
+#include <cstring>
+#include <memory>
+
+TEST(ProcessMemoryTest, testPeakTracksAllocations)
+{
+  const auto before = zivid_camera::readProcessMemoryUsage();
+  ASSERT_GT(before.resident_bytes, 0U);
+  ASSERT_GE(before.peak_resident_bytes, before.resident_bytes);
+
+  constexpr std::size_t size = 64 * 1024 * 1024;
+  {
+    // Touch the memory, so that it becomes resident
+    auto buffer = std::make_unique<char[]>(size);
+    std::memset(buffer.get(), 1, size);
+    const auto during = zivid_camera::readProcessMemoryUsage();
+    ASSERT_GE(during.resident_bytes, before.resident_bytes + size / 2);
+  }
+  const auto after = zivid_camera::readProcessMemoryUsage();
+  ASSERT_GE(after.peak_resident_bytes, before.resident_bytes + size / 2);
+
+  if (zivid_camera::resetPeakResidentMemory())
+  {
+    const auto reset = zivid_camera::readProcessMemoryUsage();
+    ASSERT_LT(reset.peak_resident_bytes, after.peak_resident_bytes);
+  }
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,74 @@
+#ifdef __clang__
+#pragma clang diagnostic push
+// Errors to ignore for this entire file
+#pragma clang diagnostic ignored "-Wglobal-constructors"  // error triggered by gtest fixtures
+#endif
+
+#include "realtime.h"
+
+#include "gtest_include_wrapper.h"
+
+#include <stdexcept>
+#include <vector>
+
+TEST(RealtimeTest, testParseCpuSet)
+{
+  ASSERT_EQ(zivid_camera::parseCpuSet(""), std::vector<int>{});
+  ASSERT_EQ(zivid_camera::parseCpuSet("3"), std::vector<int>{ 3 });
+  ASSERT_EQ(zivid_camera::parseCpuSet("6, 0-2,1"), (std::vector<int>{ 0, 1, 2, 6 }));
+  ASSERT_THROW(zivid_camera::parseCpuSet("2-1"), std::runtime_error);
+  ASSERT_THROW(zivid_camera::parseCpuSet("a"), std::runtime_error);
+  ASSERT_THROW(zivid_camera::parseCpuSet("1-"), std::runtime_error);
+  ASSERT_THROW(zivid_camera::parseCpuSet("-1"), std::runtime_error);
+  ASSERT_THROW(zivid_camera::parseCpuSet("numa:x"), std::runtime_error);
+  ASSERT_THROW(zivid_camera::parseCpuSet("numa:100000"), std::runtime_error);
+}
+
+TEST(RealtimeTest, testScopedAffinityIsRestored)
+{
+  cpu_set_t original;
+  ASSERT_EQ(pthread_getaffinity_np(pthread_self(), sizeof(original), &original), 0);
+  int first_cpu = 0;
+  while (!CPU_ISSET(first_cpu, &original))
+  {
+    first_cpu++;
+  }
+
+  {
+    const zivid_camera::ScopedThreadScheduling scheduling({ { first_cpu }, 0 });
+    cpu_set_t pinned;
+    ASSERT_EQ(pthread_getaffinity_np(pthread_self(), sizeof(pinned), &pinned), 0);
+    ASSERT_EQ(CPU_COUNT(&pinned), 1);
+    ASSERT_TRUE(CPU_ISSET(first_cpu, &pinned));
+  }
+
+  cpu_set_t restored;
+  ASSERT_EQ(pthread_getaffinity_np(pthread_self(), sizeof(restored), &restored), 0);
+  ASSERT_TRUE(CPU_EQUAL(&restored, &original));
+}
+
+TEST(RealtimeTest, testLatencyStatisticsWindows)
+{
+  using std::chrono::nanoseconds;
+  zivid_camera::LatencyStatistics statistics;
+  statistics.add(nanoseconds(10));
+  statistics.add(nanoseconds(30));
+  const auto first = statistics.takeWindow();
+  ASSERT_EQ(first.count, 2U);
+  ASSERT_EQ(first.mean, nanoseconds(20));
+  ASSERT_EQ(first.max, nanoseconds(30));
+
+  statistics.add(nanoseconds(5));
+  const auto second = statistics.takeWindow();
+  ASSERT_EQ(second.count, 1U);
+  ASSERT_EQ(second.max, nanoseconds(5));
+  ASSERT_EQ(statistics.maxOverall(), nanoseconds(30));
+
+  ASSERT_EQ(statistics.takeWindow().count, 0U);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,271 @@
+#ifdef __clang__
+#pragma clang diagnostic push
+// Errors to ignore for this entire file
+#pragma clang diagnostic ignored "-Wglobal-constructors"  // error triggered by gtest fixtures
+#endif
+
+#include "shm_point_cloud_transport.h"
+
+#include "gtest_include_wrapper.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+std::string uniqueSegmentName()
+{
+  return "/zivid_camera_test_" + std::to_string(getpid());
+}
+
+zivid_camera::ShmPointCloudMetadata makeMetadata(std::uint32_t header_seq, std::size_t data_size)
+{
+  zivid_camera::ShmPointCloudMetadata metadata{};
+  metadata.width = static_cast<std::uint32_t>(data_size / 20);
+  metadata.height = 1;
+  metadata.point_step = 20;
+  metadata.row_step = metadata.width * metadata.point_step;
+  metadata.data_size = data_size;
+  metadata.header_seq = header_seq;
+  std::strncpy(metadata.frame_id, "zivid_optical_frame", sizeof(metadata.frame_id) - 1);
+  return metadata;
+}
+
+// Returns the sequence number of the written frame, or 0 if the frame was dropped
+std::uint64_t writeFrame(zivid_camera::ShmPointCloudWriter& writer, std::uint8_t value, std::uint32_t header_seq,
+                         std::size_t data_size = 200)
+{
+  auto* data = writer.beginWrite(data_size);
+  if (data == nullptr)
+  {
+    return 0;
+  }
+  std::memset(data, value, data_size);
+  return writer.commitWrite(makeMetadata(header_seq, data_size));
+}
+}  // namespace
+
+TEST(ShmPointCloudTransportTest, testReaderGetsLatestFrame)
+{
+  zivid_camera::ShmPointCloudWriter writer(uniqueSegmentName(), 3, 200);
+  zivid_camera::ShmPointCloudReader reader(uniqueSegmentName());
+
+  ASSERT_FALSE(reader.acquireLatest());
+
+  const auto first = writeFrame(writer, 1, 10);
+  const auto second = writeFrame(writer, 2, 11);
+  ASSERT_GT(second, first);
+
+  auto lease = reader.acquireLatest();
+  ASSERT_TRUE(lease);
+  ASSERT_EQ(lease.sequence(), second);
+  ASSERT_EQ(lease.metadata().header_seq, 11U);
+  ASSERT_EQ(lease.metadata().data_size, 200U);
+  ASSERT_STREQ(lease.metadata().frame_id, "zivid_optical_frame");
+  ASSERT_EQ(lease.data()[0], 2);
+  ASSERT_EQ(lease.data()[199], 2);
+  ASSERT_TRUE(lease.isValid());
+
+  // There is no frame newer than the one we already have
+  ASSERT_FALSE(reader.acquireLatest(lease.sequence()));
+}
+
+TEST(ShmPointCloudTransportTest, testWriterDoesNotOverwriteLeasedSlots)
+{
+  zivid_camera::ShmPointCloudWriter writer(uniqueSegmentName(), 2, 200);
+  zivid_camera::ShmPointCloudReader reader(uniqueSegmentName());
+
+  writeFrame(writer, 1, 0);
+  auto first_lease = reader.acquireLatest();
+  ASSERT_TRUE(first_lease);
+  writeFrame(writer, 2, 1);
+  auto second_lease = reader.acquireLatest();
+  ASSERT_TRUE(second_lease);
+
+  // Both slots are leased, so the next frame is dropped
+  ASSERT_EQ(writeFrame(writer, 3, 2), 0U);
+  ASSERT_EQ(writer.numDroppedFrames(), 1U);
+  ASSERT_TRUE(first_lease.isValid());
+  ASSERT_EQ(first_lease.data()[0], 1);
+
+  first_lease.release();
+  ASSERT_NE(writeFrame(writer, 4, 3), 0U);
+  ASSERT_TRUE(second_lease.isValid());
+  ASSERT_EQ(second_lease.data()[0], 2);
+}
+
+TEST(ShmPointCloudTransportTest, testExpiredLeaseDoesNotBlockWriter)
+{
+  zivid_camera::ShmPointCloudWriter writer(uniqueSegmentName(), 2, 200);
+  zivid_camera::ShmPointCloudReader reader(uniqueSegmentName(), std::chrono::milliseconds{ 0 });
+
+  writeFrame(writer, 1, 0);
+  auto first_lease = reader.acquireLatest();
+  writeFrame(writer, 2, 1);
+  auto second_lease = reader.acquireLatest();
+  ASSERT_TRUE(first_lease);
+  ASSERT_TRUE(second_lease);
+
+  ASSERT_NE(writeFrame(writer, 3, 2), 0U);
+  ASSERT_FALSE(first_lease.isValid());
+}
+
+TEST(ShmPointCloudTransportTest, testReleaseOfReclaimedLeaseDoesNotReleaseNewerLease)
+{
+  zivid_camera::ShmPointCloudWriter writer(uniqueSegmentName(), 2, 200);
+  zivid_camera::ShmPointCloudReader expiring_reader(uniqueSegmentName(), std::chrono::milliseconds{ 0 });
+  zivid_camera::ShmPointCloudReader reader(uniqueSegmentName());
+
+  writeFrame(writer, 1, 0);
+  auto expired_lease = expiring_reader.acquireLatest();
+  ASSERT_TRUE(expired_lease);
+  writeFrame(writer, 2, 1);
+  // Reclaims the expired lease and overwrites its slot
+  writeFrame(writer, 3, 2);
+  ASSERT_FALSE(expired_lease.isValid());
+
+  // Lease both slots, then release the expired lease, which was on the same slot as the first of them
+  auto first_lease = reader.acquireLatest();
+  ASSERT_EQ(first_lease.data()[0], 3);
+  writeFrame(writer, 4, 3);
+  auto second_lease = reader.acquireLatest();
+  ASSERT_EQ(second_lease.data()[0], 4);
+  expired_lease.release();
+
+  ASSERT_EQ(writeFrame(writer, 5, 4), 0U);
+  ASSERT_TRUE(first_lease.isValid());
+  ASSERT_EQ(first_lease.data()[0], 3);
+}
+
+TEST(ShmPointCloudTransportTest, testConcurrentReadersWithExpiringLeasesSeeConsistentFrames)
+{
+  constexpr std::size_t data_size = 64 * 1024;
+  constexpr std::uint32_t num_frames = 5000;
+  zivid_camera::ShmPointCloudWriter writer(uniqueSegmentName(), 3, data_size);
+
+  std::atomic<bool> stop{ false };
+  std::atomic<std::size_t> num_valid_reads{ 0 };
+  std::atomic<std::size_t> num_inconsistent_reads{ 0 };
+  std::vector<std::thread> readers;
+  for (int i = 0; i < 4; i++)
+  {
+    // Half of the readers use leases that expire almost immediately, so the writer keeps reclaiming leases
+    const auto lease_duration = std::chrono::milliseconds{ i % 2 == 0 ? 0 : 1000 };
+    readers.emplace_back([&, lease_duration]() {
+      zivid_camera::ShmPointCloudReader reader(uniqueSegmentName(), lease_duration);
+      while (!stop)
+      {
+        auto lease = reader.acquireLatest();
+        if (!lease)
+        {
+          continue;
+        }
+        const auto value = static_cast<std::uint8_t>(lease.metadata().header_seq);
+        bool consistent = true;
+        for (std::size_t j = 0; j < data_size; j++)
+        {
+          consistent = consistent && lease.data()[j] == value;
+        }
+        if (lease.isValid())
+        {
+          num_valid_reads++;
+          if (!consistent)
+          {
+            num_inconsistent_reads++;
+          }
+        }
+      }
+    });
+  }
+
+  std::uint32_t num_written = 0;
+  for (std::uint32_t header_seq = 0; header_seq < num_frames; header_seq++)
+  {
+    if (writeFrame(writer, static_cast<std::uint8_t>(header_seq), header_seq, data_size) != 0)
+    {
+      num_written++;
+    }
+  }
+  stop = true;
+  for (auto& reader : readers)
+  {
+    reader.join();
+  }
+
+  ASSERT_GT(num_written, 0U);
+  ASSERT_GT(num_valid_reads.load(), 0U);
+  ASSERT_EQ(num_inconsistent_reads.load(), 0U);
+
+  // All the leases have been released, so every slot can be written again
+  for (std::uint32_t i = 0; i < 3; i++)
+  {
+    ASSERT_NE(writeFrame(writer, 0, 0, data_size), 0U);
+  }
+}
+
+TEST(ShmPointCloudTransportTest, testReaderFollowsResizedSegment)
+{
+  zivid_camera::ShmPointCloudWriter writer(uniqueSegmentName(), 2, 200);
+  zivid_camera::ShmPointCloudReader reader(uniqueSegmentName());
+
+  const auto first = writeFrame(writer, 1, 0);
+  auto old_lease = reader.acquireLatest();
+  ASSERT_TRUE(old_lease);
+
+  const std::size_t large_size = writer.slotCapacity() + 1;
+  ASSERT_EQ(writeFrame(writer, 2, 1, large_size), 0U);
+  writer.resize(large_size);
+  ASSERT_GE(writer.slotCapacity(), large_size);
+  const auto second = writeFrame(writer, 3, 2, large_size);
+  ASSERT_GT(second, first);
+
+  auto new_lease = reader.acquireLatest(old_lease.sequence());
+  ASSERT_TRUE(new_lease);
+  ASSERT_EQ(new_lease.sequence(), second);
+  ASSERT_EQ(new_lease.metadata().data_size, large_size);
+  ASSERT_EQ(new_lease.data()[large_size - 1], 3);
+
+  // The old segment stays mapped while it is leased
+  ASSERT_TRUE(old_lease.isValid());
+  ASSERT_EQ(old_lease.data()[0], 1);
+}
+
+TEST(ShmPointCloudTransportTest, testSegmentIsOnlyAccessibleToOwnerByDefault)
+{
+  zivid_camera::ShmPointCloudWriter writer(uniqueSegmentName(), 2, 200);
+  const int fd = shm_open(uniqueSegmentName().c_str(), O_RDONLY, 0);
+  ASSERT_GE(fd, 0);
+  struct stat st
+  {
+  };
+  ASSERT_EQ(fstat(fd, &st), 0);
+  close(fd);
+  ASSERT_EQ(st.st_mode & 0777U, 0600U);
+}
+
+TEST(ShmPointCloudTransportTest, testTooLargeFrameIsDropped)
+{
+  zivid_camera::ShmPointCloudWriter writer(uniqueSegmentName(), 2, 100);
+  ASSERT_EQ(writer.beginWrite(writer.slotCapacity() + 1), nullptr);
+  ASSERT_EQ(writer.numDroppedFrames(), 1U);
+}
+
+TEST(ShmPointCloudTransportTest, testOpeningMissingSegmentThrows)
+{
+  ASSERT_THROW(zivid_camera::ShmPointCloudReader("/zivid_camera_test_does_not_exist"), std::runtime_error);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
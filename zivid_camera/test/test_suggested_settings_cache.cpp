@@ -0,0 +1,66 @@
+#ifdef __clang__
+#pragma clang diagnostic push
+// Errors to ignore for this entire file
+#pragma clang diagnostic ignored "-Wglobal-constructors"  // error triggered by gtest fixtures
+#endif
+
+#include "suggested_settings_cache.h"
+
+#include "gtest_include_wrapper.h"
+
+namespace
+{
+using std::chrono::milliseconds;
+using std::chrono::seconds;
+
+const std::chrono::steady_clock::time_point start;
+
+zivid_camera::SuggestedSettingsKey makeKey(const std::string& scene_tag)
+{
+  return zivid_camera::SuggestedSettingsKey{ milliseconds(1200), 1, scene_tag };
+}
+}  // namespace
+
+TEST(SuggestedSettingsCacheTest, testSuggestionsExpire)
+{
+  zivid_camera::SuggestedSettingsCache cache(seconds(10));
+  ASSERT_FALSE(cache.get(makeKey(""), start));
+  cache.put(makeKey(""), std::vector<Zivid::Settings>(3), start);
+
+  ASSERT_EQ(cache.get(makeKey(""), start + seconds(9))->size(), 3U);
+  ASSERT_FALSE(cache.get(makeKey("bin"), start + seconds(9)));
+  ASSERT_FALSE((cache.get(zivid_camera::SuggestedSettingsKey{ milliseconds(1000), 1, "" }, start)));
+  ASSERT_FALSE(cache.get(makeKey(""), start + seconds(10)));
+  ASSERT_EQ(cache.numHits(), 1U);
+  ASSERT_EQ(cache.numMisses(), 4U);
+
+  // Expired suggestions are removed when a suggestion is added
+  cache.put(makeKey("bin"), std::vector<Zivid::Settings>(1), start + seconds(10));
+  ASSERT_EQ(cache.numEntries(), 1U);
+  ASSERT_EQ(cache.get(makeKey("bin"), start + seconds(10))->size(), 1U);
+}
+
+TEST(SuggestedSettingsCacheTest, testClearByTag)
+{
+  zivid_camera::SuggestedSettingsCache cache(seconds(10));
+  cache.put(makeKey("bin"), std::vector<Zivid::Settings>(1), start);
+  cache.put(makeKey("table"), std::vector<Zivid::Settings>(1), start);
+  cache.put(zivid_camera::SuggestedSettingsKey{ milliseconds(2000), 0, "table" }, std::vector<Zivid::Settings>(2),
+            start);
+  // Replacing a suggestion does not add an entry
+  cache.put(makeKey("bin"), std::vector<Zivid::Settings>(2), start);
+  ASSERT_EQ(cache.numEntries(), 3U);
+  ASSERT_EQ(cache.get(makeKey("bin"), start)->size(), 2U);
+
+  ASSERT_EQ(cache.clear(std::string("table")), 2U);
+  ASSERT_FALSE(cache.get(makeKey("table"), start));
+  ASSERT_TRUE(cache.get(makeKey("bin"), start));
+  ASSERT_EQ(cache.clear(std::nullopt), 1U);
+  ASSERT_EQ(cache.numEntries(), 0U);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,109 @@
+#ifdef __clang__
+#pragma clang diagnostic push
+// Errors to ignore for this entire file
+#pragma clang diagnostic ignored "-Wglobal-constructors"  // error triggered by gtest fixtures
+#endif
+
+#include "thread_pool.h"
+
+#include "gtest_include_wrapper.h"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+TEST(ThreadPoolTest, testEachIndexIsVisitedOnce)
+{
+  for (std::size_t num_threads : { 1U, 2U, 5U })
+  {
+    zivid_camera::ThreadPool thread_pool(num_threads, 3);
+    ASSERT_EQ(thread_pool.numThreads(), num_threads);
+    for (std::size_t size : { 0U, 1U, 7U, 1000U })
+    {
+      std::vector<std::atomic<int>> visits(size + 10);
+      thread_pool.parallelFor(10, 10 + size, [&](std::size_t i) { visits[i]++; });
+      for (std::size_t i = 0; i < visits.size(); i++)
+      {
+        ASSERT_EQ(visits[i], i < 10 ? 0 : 1);
+      }
+    }
+  }
+}
+
+TEST(ThreadPoolTest, testChunksAreContiguousAndIndexed)
+{
+  zivid_camera::ThreadPool thread_pool(3, 2);
+  ASSERT_EQ(thread_pool.numChunks(100), 6U);
+  ASSERT_EQ(thread_pool.numChunks(4), 4U);
+  std::vector<std::pair<std::size_t, std::size_t>> ranges(thread_pool.numChunks(100));
+  thread_pool.parallelForChunks(0, 100, [&](std::size_t chunk, std::size_t begin, std::size_t end) {
+    ranges[chunk] = { begin, end };
+  });
+  std::size_t expected_begin = 0;
+  for (const auto& range : ranges)
+  {
+    ASSERT_EQ(range.first, expected_begin);
+    ASSERT_LT(range.first, range.second);
+    expected_begin = range.second;
+  }
+  ASSERT_EQ(expected_begin, 100U);
+}
+
+TEST(ThreadPoolTest, testWorkIsSpreadOverThreads)
+{
+  zivid_camera::ThreadPool thread_pool(4, 4);
+  std::mutex mutex;
+  std::set<std::thread::id> thread_ids;
+  thread_pool.parallelFor(0, 64, [&](std::size_t) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    std::lock_guard<std::mutex> lock(mutex);
+    thread_ids.insert(std::this_thread::get_id());
+  });
+  ASSERT_GT(thread_ids.size(), 1U);
+  ASSERT_LE(thread_ids.size(), 4U);
+}
+
+TEST(ThreadPoolTest, testNestedAndConcurrentCalls)
+{
+  zivid_camera::ThreadPool thread_pool(3, 2);
+  std::atomic<std::size_t> sum{ 0 };
+  auto nested = [&]() {
+    thread_pool.parallelFor(0, 10, [&](std::size_t) {
+      thread_pool.parallelFor(0, 100, [&](std::size_t i) { sum += i; });
+    });
+  };
+  std::thread other(nested);
+  nested();
+  other.join();
+  ASSERT_EQ(sum, 2U * 10U * 4950U);
+}
+
+TEST(ThreadPoolTest, testExceptionIsRethrown)
+{
+  zivid_camera::ThreadPool thread_pool(4, 4);
+  std::atomic<std::size_t> num_calls{ 0 };
+  ASSERT_THROW(thread_pool.parallelFor(0, 100,
+                                       [&](std::size_t i) {
+                                         num_calls++;
+                                         if (i == 42)
+                                         {
+                                           throw std::runtime_error("error");
+                                         }
+                                       }),
+               std::runtime_error);
+  // The pool is still usable
+  thread_pool.parallelFor(0, 10, [&](std::size_t) { num_calls++; });
+  ASSERT_GE(num_calls, 10U);
+  ASSERT_THROW(zivid_camera::ThreadPool(2, 0), std::runtime_error);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -8,11 +8,16 @@
 #include <zivid_camera/CameraInfoModelName.h>
 #include <zivid_camera/Capture.h>
 #include <zivid_camera/Capture2D.h>
+#include <zivid_camera/CaptureAction.h>
 #include <zivid_camera/CaptureAssistantSuggestSettings.h>
+#include <zivid_camera/CaptureBoth.h>
+#include <zivid_camera/CaptureWithSettings.h>
 #include <zivid_camera/CaptureFrameConfig.h>
 #include <zivid_camera/Capture2DFrameConfig.h>
 #include <zivid_camera/CaptureGeneralConfig.h>
 #include <zivid_camera/IsConnected.h>
+#include <zivid_camera/SavePreset.h>
+#include <zivid_camera/SelectPreset.h>
 
 #include <Zivid/Application.h>
 #include <Zivid/CaptureAssistant.h>
@@ -20,6 +25,7 @@
 #include <Zivid/Camera.h>
 #include <Zivid/Version.h>
 
+#include <actionlib/client/simple_action_client.h>
 #include <dynamic_reconfigure/client.h>
 #include <sensor_msgs/CameraInfo.h>
 #include <sensor_msgs/PointCloud2.h>
@@ -29,6 +35,9 @@
 
 #include <ros/ros.h>
 
+#include <atomic>
+#include <mutex>
+
 using SecondsD = std::chrono::duration<double>;
 
 namespace
@@ -50,6 +59,8 @@ protected:
   const ros::Duration dr_get_max_wait_duration{ 1 };
   static constexpr auto capture_service_name = "/zivid_camera/capture";
   static constexpr auto capture_2d_service_name = "/zivid_camera/capture_2d";
+  static constexpr auto capture_both_service_name = "/zivid_camera/capture_both";
+  static constexpr auto capture_with_settings_service_name = "/zivid_camera/capture_with_settings";
   static constexpr auto capture_assistant_suggest_settings_service_name = "/zivid_camera/capture_assistant/"
                                                                           "suggest_settings";
   static constexpr auto color_camera_info_topic_name = "/zivid_camera/color/camera_info";
@@ -57,8 +68,16 @@ protected:
   static constexpr auto depth_camera_info_topic_name = "/zivid_camera/depth/camera_info";
   static constexpr auto depth_image_raw_topic_name = "/zivid_camera/depth/image_raw";
   static constexpr auto points_topic_name = "/zivid_camera/points";
+  static constexpr auto preview_2_points_topic_name = "/zivid_camera/preview/2/points";
+  static constexpr auto preview_4_color_camera_info_topic_name = "/zivid_camera/preview/4/color/camera_info";
+  static constexpr auto preview_4_color_image_color_topic_name = "/zivid_camera/preview/4/color/image_color";
+  static constexpr auto preview_4_depth_image_raw_topic_name = "/zivid_camera/preview/4/depth/image_raw";
+  static constexpr auto capture_action_name = "/zivid_camera/capture_action";
   static constexpr size_t num_dr_capture_servers = 10;
 
+  using CaptureActionClient = actionlib::SimpleActionClient<zivid_camera::CaptureAction>;
+  const ros::Duration action_result_wait_duration{ 10 };
+
   class SubscriptionWrapper
   {
   public:
@@ -105,13 +124,25 @@ protected:
   }
 
   void enableFirst3DFrame()
+  {
+    setFirst3DFrameEnabled(true);
+  }
+
+  // The driver is shared by all the tests, so tests that need no frames to be enabled must disable the frame that
+  // earlier tests may have enabled
+  void disableFirst3DFrame()
+  {
+    setFirst3DFrameEnabled(false);
+  }
+
+  void setFirst3DFrameEnabled(bool enabled)
   {
     dynamic_reconfigure::Client<zivid_camera::CaptureFrameConfig> frame_0_client("/zivid_camera/capture/"
                                                                                  "frame_0/");
     sleepAndSpin(dr_get_max_wait_duration);
     zivid_camera::CaptureFrameConfig frame_0_cfg;
     ASSERT_TRUE(frame_0_client.getDefaultConfiguration(frame_0_cfg, dr_get_max_wait_duration));
-    frame_0_cfg.enabled = true;
+    frame_0_cfg.enabled = enabled;
     ASSERT_TRUE(frame_0_client.setConfiguration(frame_0_cfg));
   }
 
@@ -228,6 +259,7 @@ TEST_F(ZividNodeTest, testCapturePublishesTopics)
   sleepAndSpin(short_wait_duration);
   assert_num_topics_received(0);
 
+  disableFirst3DFrame();
   zivid_camera::Capture capture;
   // Capture fails when no frames are enabled
   ASSERT_FALSE(ros::service::call(capture_service_name, capture));
@@ -354,6 +386,48 @@ TEST_F(ZividNodeTest, testCaptureCameraInfo)
   assertCameraInfoForFileCamera(*depth_camera_info);
 }
 
+TEST_F(ZividNodeTest, testCapturePreviews)
+{
+  waitForReady();
+
+  std::optional<sensor_msgs::PointCloud2> points;
+  auto points_sub =
+      subscribe<sensor_msgs::PointCloud2>(preview_2_points_topic_name, [&](const auto& p) { points = *p; });
+  std::optional<sensor_msgs::Image> color_image;
+  auto color_image_sub =
+      subscribe<sensor_msgs::Image>(preview_4_color_image_color_topic_name, [&](const auto& i) { color_image = *i; });
+  std::optional<sensor_msgs::Image> depth_image;
+  auto depth_image_sub =
+      subscribe<sensor_msgs::Image>(preview_4_depth_image_raw_topic_name, [&](const auto& i) { depth_image = *i; });
+  std::optional<sensor_msgs::CameraInfo> camera_info;
+  auto camera_info_sub = subscribe<sensor_msgs::CameraInfo>(preview_4_color_camera_info_topic_name,
+                                                            [&](const auto& r) { camera_info = *r; });
+
+  enableFirst3DFrame();
+  zivid_camera::Capture capture;
+  ASSERT_TRUE(ros::service::call(capture_service_name, capture));
+  sleepAndSpin(short_wait_duration);
+
+  ASSERT_TRUE(points.has_value());
+  ASSERT_EQ(points->width, 960U);
+  ASSERT_EQ(points->height, 600U);
+  ASSERT_EQ(points->data.size(), 960U * 600U * 20U);
+
+  ASSERT_TRUE(color_image.has_value());
+  ASSERT_EQ(color_image->width, 480U);
+  ASSERT_EQ(color_image->height, 300U);
+  ASSERT_EQ(color_image->encoding, "rgb8");
+  ASSERT_TRUE(depth_image.has_value());
+  ASSERT_EQ(depth_image->width, 480U);
+  ASSERT_EQ(depth_image->height, 300U);
+
+  ASSERT_TRUE(camera_info.has_value());
+  ASSERT_EQ(camera_info->width, 480U);
+  ASSERT_EQ(camera_info->height, 300U);
+  assertArrayFloatEq(camera_info->K, std::array<double, 9>{ 2759.12329102 / 4, 0, (958.78460693 - 1.5) / 4, 0,
+                                                            2758.73681641 / 4, (634.94018555 - 1.5) / 4, 0, 0, 1 });
+}
+
 TEST_F(ZividNodeTest, test3DSettingsDynamicReconfigureNodesAreAvailable)
 {
   waitForReady();
@@ -438,6 +512,192 @@ TEST_F(ZividNodeTest, testCapture2D)
   verifyImageAndCameraInfo(*image, *color_camera_info);
 }
 
+TEST_F(ZividNodeTest, testCaptureBoth)
+{
+  waitForReady();
+  enableFirst3DFrame();
+  enableFirst2DFrame();
+
+  std::optional<sensor_msgs::Image> image;
+  std::optional<sensor_msgs::PointCloud2> points;
+  auto color_image_color_sub =
+      subscribe<sensor_msgs::Image>(color_image_color_topic_name, [&](const auto& i) { image = *i; });
+  auto points_sub = subscribe<sensor_msgs::PointCloud2>(points_topic_name, [&](const auto& p) { points = *p; });
+
+  sleepAndSpin(short_wait_duration);
+  zivid_camera::CaptureBoth capture;
+  ASSERT_TRUE(ros::service::call(capture_both_service_name, capture));
+  sleepAndSpin(short_wait_duration);
+
+  // The color image comes from the 2D capture only
+  ASSERT_EQ(color_image_color_sub.numMessages(), 1U);
+  ASSERT_EQ(points_sub.numMessages(), 1U);
+  ASSERT_EQ(image->encoding, "rgba8");
+  ASSERT_EQ(points->width, 1920U);
+  ASSERT_EQ(points->height, 1200U);
+  ASSERT_EQ(image->header.seq, points->header.seq);
+  ASSERT_EQ(image->header.stamp, points->header.stamp);
+}
+
+TEST_F(ZividNodeTest, testCaptureWithSettings)
+{
+  waitForReady();
+
+  auto points_sub = subscribe<sensor_msgs::PointCloud2>(points_topic_name);
+  sleepAndSpin(short_wait_duration);
+
+  // The frames in the request are captured even if no frames are enabled in the configuration
+  zivid_camera::CaptureWithSettings capture;
+  ASSERT_FALSE(ros::service::call(capture_with_settings_service_name, capture));
+  capture.request.frames.resize(2);
+  dynamic_reconfigure::IntParameter iris;
+  iris.name = "iris";
+  iris.value = 20;
+  capture.request.frames[1].ints.push_back(iris);
+  ASSERT_TRUE(ros::service::call(capture_with_settings_service_name, capture));
+  sleepAndSpin(short_wait_duration);
+  ASSERT_EQ(points_sub.numMessages(), 1U);
+
+  auto invalid_capture = capture;
+  invalid_capture.request.frames[1].ints[0].name = "no_such_parameter";
+  ASSERT_FALSE(ros::service::call(capture_with_settings_service_name, invalid_capture));
+  invalid_capture = capture;
+  invalid_capture.request.frames[1].ints[0].value = 100000;
+  ASSERT_FALSE(ros::service::call(capture_with_settings_service_name, invalid_capture));
+  invalid_capture = capture;
+  invalid_capture.request.frames.resize(num_dr_capture_servers + 1);
+  ASSERT_FALSE(ros::service::call(capture_with_settings_service_name, invalid_capture));
+  sleepAndSpin(short_wait_duration);
+  ASSERT_EQ(points_sub.numMessages(), 1U);
+}
+
+TEST_F(ZividNodeTest, testCaptureAction)
+{
+  waitForReady();
+
+  std::optional<sensor_msgs::PointCloud2> points;
+  auto points_sub = subscribe<sensor_msgs::PointCloud2>(points_topic_name, [&](const auto& p) { points = *p; });
+  sleepAndSpin(short_wait_duration);
+
+  CaptureActionClient client(capture_action_name, true);
+  ASSERT_TRUE(client.waitForServer(node_ready_wait_duration));
+
+  // The goal fails when no frames are enabled
+  disableFirst3DFrame();
+  zivid_camera::CaptureGoal goal;
+  client.sendGoal(goal);
+  ASSERT_TRUE(client.waitForResult(action_result_wait_duration));
+  ASSERT_EQ(client.getState(), actionlib::SimpleClientGoalState::ABORTED);
+
+  enableFirst3DFrame();
+
+  std::mutex feedback_mutex;
+  std::vector<std::uint8_t> feedback_stages;
+  bool active = false;
+  client.sendGoal(
+      goal, CaptureActionClient::SimpleDoneCallback(),
+      [&]() {
+        std::lock_guard<std::mutex> lock(feedback_mutex);
+        active = true;
+      },
+      [&](const auto& feedback) {
+        std::lock_guard<std::mutex> lock(feedback_mutex);
+        feedback_stages.push_back(feedback->stage);
+      });
+  ASSERT_TRUE(client.waitForResult(action_result_wait_duration));
+  ASSERT_EQ(client.getState(), actionlib::SimpleClientGoalState::SUCCEEDED);
+  sleepAndSpin(short_wait_duration);
+
+  {
+    std::lock_guard<std::mutex> lock(feedback_mutex);
+    ASSERT_TRUE(active);
+    ASSERT_EQ(feedback_stages, (std::vector<std::uint8_t>{ zivid_camera::CaptureFeedback::ACQUIRED,
+                                                           zivid_camera::CaptureFeedback::PUBLISHED }));
+  }
+
+  // The header of the result is the header of the published messages
+  ASSERT_EQ(points_sub.numMessages(), 1U);
+  const auto result = client.getResult();
+  ASSERT_TRUE(result);
+  ASSERT_EQ(result->header.seq, points->header.seq);
+  ASSERT_EQ(result->header.stamp, points->header.stamp);
+  ASSERT_EQ(result->header.frame_id, points->header.frame_id);
+}
+
+TEST_F(ZividNodeTest, testCaptureActionCancelQueuedGoal)
+{
+  waitForReady();
+  enableFirst3DFrame();
+
+  // Keep the camera busy with some goals, so that the goal that is cancelled is still queued when it is cancelled
+  constexpr std::size_t num_blocking_goals = 3;
+  std::vector<std::unique_ptr<CaptureActionClient>> blocking_clients;
+  for (std::size_t i = 0; i < num_blocking_goals; i++)
+  {
+    blocking_clients.push_back(std::make_unique<CaptureActionClient>(capture_action_name, true));
+    ASSERT_TRUE(blocking_clients.back()->waitForServer(node_ready_wait_duration));
+  }
+  CaptureActionClient client(capture_action_name, true);
+  ASSERT_TRUE(client.waitForServer(node_ready_wait_duration));
+
+  for (auto& blocking_client : blocking_clients)
+  {
+    blocking_client->sendGoal(zivid_camera::CaptureGoal{});
+  }
+
+  std::atomic<std::size_t> num_feedbacks{ 0 };
+  client.sendGoal(zivid_camera::CaptureGoal{}, CaptureActionClient::SimpleDoneCallback(),
+                  CaptureActionClient::SimpleActiveCallback(), [&](const auto&) { num_feedbacks++; });
+  client.cancelGoal();
+
+  ASSERT_TRUE(client.waitForResult(action_result_wait_duration));
+  const auto state = client.getState();
+  ASSERT_TRUE(state == actionlib::SimpleClientGoalState::PREEMPTED ||
+              state == actionlib::SimpleClientGoalState::RECALLED)
+      << "state: " << state.toString();
+
+  for (auto& blocking_client : blocking_clients)
+  {
+    ASSERT_TRUE(blocking_client->waitForResult(action_result_wait_duration));
+    ASSERT_EQ(blocking_client->getState(), actionlib::SimpleClientGoalState::SUCCEEDED);
+  }
+
+  // The cancelled goal never started capturing
+  sleepAndSpin(short_wait_duration);
+  ASSERT_EQ(num_feedbacks, 0U);
+}
+
+TEST_F(ZividNodeTest, testSaveAndSelectPreset)
+{
+  waitForReady();
+
+  zivid_camera::SelectPreset select;
+  select.request.name = "no_such_preset";
+  ASSERT_FALSE(ros::service::call("/zivid_camera/select_preset", select));
+
+  // A preset can not be saved while no frames are enabled
+  disableFirst3DFrame();
+  zivid_camera::SavePreset save;
+  save.request.name = "one_frame";
+  ASSERT_FALSE(ros::service::call("/zivid_camera/save_preset", save));
+  enableFirst3DFrame();
+  ASSERT_TRUE(ros::service::call("/zivid_camera/save_preset", save));
+
+  auto points_sub = subscribe<sensor_msgs::PointCloud2>(points_topic_name);
+  sleepAndSpin(short_wait_duration);
+  select.request.name = "one_frame";
+  ASSERT_TRUE(ros::service::call("/zivid_camera/select_preset", select));
+  zivid_camera::Capture capture;
+  ASSERT_TRUE(ros::service::call(capture_service_name, capture));
+  sleepAndSpin(short_wait_duration);
+  ASSERT_EQ(points_sub.numMessages(), 1U);
+
+  // Leave the driver as the other tests expect it, without a selected preset and with no frames enabled
+  select.request.name = "";
+  ASSERT_TRUE(ros::service::call("/zivid_camera/select_preset", select));
+  disableFirst3DFrame();
+}
+
 TEST_F(ZividNodeTest, test2DSettingsDynamicReconfigureNodesAreAvailable)
 {
   waitForReady();
@@ -0,0 +1,300 @@
+#ifdef __clang__
+#pragma clang diagnostic push
+// Errors to ignore for this entire file
+#pragma clang diagnostic ignored "-Wglobal-constructors"  // error triggered by gtest fixtures
+#endif
+
+#include "zivid_camera.h"
+
+#include <zivid_camera/Capture.h>
+#include <zivid_camera/CaptureFrameConfig.h>
+
+#include <dynamic_reconfigure/client.h>
+#include <sensor_msgs/PointCloud2.h>
+#include <sensor_msgs/Image.h>
+
+#include "gtest_include_wrapper.h"
+
+#include <ros/ros.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <map>
+#include <mutex>
+#include <new>
+#include <optional>
+
+// The performance test either runs the driver in-process, or against a driver that is started as a separate node.
+//
+// In-process, the heap allocations made while capturing, converting and publishing are counted by replacing the
+// global allocation functions. Only allocations that are at least large_allocation_threshold bytes are counted, and
+// only while counting is enabled. The messages are then passed to the subscribers without serialization, so the
+// latency is not checked in this mode.
+//
+// With a separate driver node, the messages are serialized and sent over TCP like in a deployment, and the latency is
+// checked against its budget. The allocations of the driver can not be counted in this mode.
+namespace
+{
+std::atomic<bool> count_large_allocations{ false };
+std::atomic<std::size_t> large_allocation_threshold{ 1024 * 1024 };
+std::atomic<std::size_t> num_large_allocations{ 0 };
+std::atomic<std::size_t> num_large_allocation_bytes{ 0 };
+
+void* countedAllocate(std::size_t size)
+{
+  if (count_large_allocations.load(std::memory_order_relaxed) &&
+      size >= large_allocation_threshold.load(std::memory_order_relaxed))
+  {
+    num_large_allocations++;
+    num_large_allocation_bytes += size;
+  }
+  if (void* ptr = std::malloc(size == 0 ? 1 : size))
+  {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+}  // namespace
+
+void* operator new(std::size_t size)
+{
+  return countedAllocate(size);
+}
+
+void* operator new[](std::size_t size)
+{
+  return countedAllocate(size);
+}
+
+void operator delete(void* ptr) noexcept
+{
+  std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+  std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept
+{
+  std::free(ptr);
+}
+
+class ZividNodePerfTest : public testing::Test
+{
+protected:
+  ZividNodePerfTest() : priv_("~"), spinner_(2)
+  {
+    priv_.param<bool>("driver_in_process", driver_in_process_, true);
+    priv_.param<int>("num_captures", num_captures_, 20);
+    priv_.param<double>("max_median_latency_ms", max_median_latency_ms_, 200.0);
+    priv_.param<double>("max_large_allocations_per_capture", max_large_allocations_per_capture_, 24.0);
+    priv_.param<double>("max_large_allocation_mb_per_capture", max_large_allocation_mb_per_capture_, 256.0);
+    priv_.param<bool>("measure_cache_miss", measure_cache_miss_, false);
+    int threshold;
+    priv_.param<int>("large_allocation_threshold_bytes", threshold, 1024 * 1024);
+    large_allocation_threshold = static_cast<std::size_t>(threshold);
+
+    if (driver_in_process_)
+    {
+      camera_ = std::make_unique<zivid_camera::ZividCamera>(nh_, priv_);
+    }
+    spinner_.start();
+  }
+
+  ~ZividNodePerfTest() override
+  {
+    spinner_.stop();
+  }
+
+  // Enable frame_0 with the default settings, or with another iris than the default if other_settings is true
+  void enableFirst3DFrame(bool other_settings = false)
+  {
+    dynamic_reconfigure::Client<zivid_camera::CaptureFrameConfig> frame_0_client("/zivid_camera/capture/"
+                                                                                 "frame_0/");
+    dr_get_max_wait_duration.sleep();
+    zivid_camera::CaptureFrameConfig frame_0_cfg;
+    ASSERT_TRUE(frame_0_client.getDefaultConfiguration(frame_0_cfg, dr_get_max_wait_duration));
+    frame_0_cfg.enabled = true;
+    if (other_settings)
+    {
+      frame_0_cfg.iris = frame_0_cfg.iris > 0 ? frame_0_cfg.iris - 1 : 1;
+    }
+    ASSERT_TRUE(frame_0_client.setConfiguration(frame_0_cfg));
+  }
+
+  // Duration of a call to the capture service in ms. This includes the capture itself, unlike the latency from the
+  // header stamp.
+  double timedCapture()
+  {
+    zivid_camera::Capture capture;
+    const auto start = std::chrono::steady_clock::now();
+    EXPECT_TRUE(ros::service::call(capture_service_name, capture));
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  }
+
+  // Records the time from the header stamp (set right after the acquisition) until the last of the points, color
+  // and depth messages of a capture is received. This covers conversion and publishing in publishFrame, and with a
+  // separate driver node also the serialization and the transfer of the messages.
+  template <class Type>
+  ros::Subscriber subscribeAndRecordLatency(const std::string& name)
+  {
+    boost::function<void(const boost::shared_ptr<const Type>&)> cb = [this](const auto& msg) {
+      const auto latency = ros::Time::now() - msg->header.stamp;
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto& capture_latency = latencies_[msg->header.seq];
+      capture_latency.latency = std::max(capture_latency.latency, latency);
+      capture_latency.num_messages++;
+    };
+    return nh_.subscribe<Type>(name, 1, cb, ros::VoidConstPtr(), ros::TransportHints().tcpNoDelay());
+  }
+
+  static double median(std::vector<double> values)
+  {
+    std::sort(values.begin(), values.end());
+    const auto n = values.size();
+    return n % 2 == 1 ? values[n / 2] : 0.5 * (values[n / 2 - 1] + values[n / 2]);
+  }
+
+  struct CaptureLatency
+  {
+    ros::Duration latency;
+    std::size_t num_messages = 0;
+  };
+
+  static constexpr auto capture_service_name = "/zivid_camera/capture";
+  static constexpr std::size_t num_messages_per_capture = 3;
+  const ros::Duration node_ready_wait_duration{ 15 };
+  const ros::Duration dr_get_max_wait_duration{ 1 };
+  const ros::Duration message_wait_duration{ 5 };
+
+  ros::NodeHandle nh_;
+  ros::NodeHandle priv_;
+  ros::AsyncSpinner spinner_;
+  bool driver_in_process_;
+  std::unique_ptr<zivid_camera::ZividCamera> camera_;
+  int num_captures_;
+  double max_median_latency_ms_;
+  double max_large_allocations_per_capture_;
+  double max_large_allocation_mb_per_capture_;
+  bool measure_cache_miss_;
+  std::mutex mutex_;
+  std::map<uint32_t, CaptureLatency> latencies_;
+};
+
+TEST_F(ZividNodePerfTest, testCaptureLatencyAndAllocationsAreWithinBudget)
+{
+  ASSERT_TRUE(ros::service::waitForService(capture_service_name, node_ready_wait_duration));
+  ASSERT_GT(num_captures_, 0);
+
+  auto points_sub = subscribeAndRecordLatency<sensor_msgs::PointCloud2>("/zivid_camera/points");
+  auto color_sub = subscribeAndRecordLatency<sensor_msgs::Image>("/zivid_camera/color/image_color");
+  auto depth_sub = subscribeAndRecordLatency<sensor_msgs::Image>("/zivid_camera/depth/image_raw");
+
+  enableFirst3DFrame();
+
+  // Warm-up capture, so that one-time initialization in the SDK and in the driver is not measured
+  zivid_camera::Capture capture;
+  ASSERT_TRUE(ros::service::call(capture_service_name, capture));
+  message_wait_duration.sleep();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    latencies_.clear();
+  }
+
+  num_large_allocations = 0;
+  num_large_allocation_bytes = 0;
+  count_large_allocations = driver_in_process_;
+  std::vector<double> capture_calls_ms;
+  for (int i = 0; i < num_captures_; i++)
+  {
+    capture_calls_ms.push_back(timedCapture());
+    const auto all_messages_received = [&]() {
+      std::lock_guard<std::mutex> lock(mutex_);
+      return latencies_.size() == static_cast<std::size_t>(i + 1) &&
+             latencies_.rbegin()->second.num_messages == num_messages_per_capture;
+    };
+    const auto deadline = ros::Time::now() + message_wait_duration;
+    while (!all_messages_received() && ros::Time::now() < deadline)
+    {
+      ros::Duration{ 0.001 }.sleep();
+    }
+  }
+  count_large_allocations = false;
+
+  std::vector<double> latencies_ms;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& entry : latencies_)
+    {
+      ASSERT_EQ(entry.second.num_messages, num_messages_per_capture)
+          << "Did not receive all messages for capture with seq " << entry.first;
+      latencies_ms.push_back(entry.second.latency.toSec() * 1000.0);
+    }
+  }
+  ASSERT_EQ(latencies_ms.size(), static_cast<std::size_t>(num_captures_));
+
+  // With file_camera_cache_max_mb set, all the captures above are cache hits of the warm-up capture. Captures with
+  // other settings miss the cache, and are decoded by the SDK.
+  std::optional<double> cache_miss_call_ms;
+  if (measure_cache_miss_)
+  {
+    enableFirst3DFrame(true);
+    cache_miss_call_ms = timedCapture();
+  }
+
+  const auto median_latency_ms = median(latencies_ms);
+  const auto median_capture_call_ms = median(capture_calls_ms);
+  ROS_INFO("Median capture service call: %.2f ms", median_capture_call_ms);
+
+  if (driver_in_process_)
+  {
+    const auto large_allocations_per_capture = static_cast<double>(num_large_allocations) / num_captures_;
+    const auto large_allocation_mb_per_capture =
+        static_cast<double>(num_large_allocation_bytes) / (1024.0 * 1024.0) / num_captures_;
+
+    ROS_INFO("Median capture-to-publish latency without serialization: %.2f ms (not checked)", median_latency_ms);
+    ROS_INFO("Large heap allocations per capture: %.2f (budget %.2f)", large_allocations_per_capture,
+             max_large_allocations_per_capture_);
+    ROS_INFO("Large heap allocation MB per capture: %.2f (budget %.2f)", large_allocation_mb_per_capture,
+             max_large_allocation_mb_per_capture_);
+
+    EXPECT_LE(large_allocations_per_capture, max_large_allocations_per_capture_)
+        << "Number of large heap allocations per capture regressed: " << large_allocations_per_capture
+        << " is above the budget of " << max_large_allocations_per_capture_ << ".";
+    EXPECT_LE(large_allocation_mb_per_capture, max_large_allocation_mb_per_capture_)
+        << "Large heap allocation volume per capture regressed: " << large_allocation_mb_per_capture
+        << " MB is above the budget of " << max_large_allocation_mb_per_capture_ << " MB.";
+  }
+  else
+  {
+    ROS_INFO("Median capture-to-publish latency: %.2f ms (budget %.2f ms)", median_latency_ms, max_median_latency_ms_);
+
+    EXPECT_LE(median_latency_ms, max_median_latency_ms_)
+        << "Median capture-to-publish latency regressed: " << median_latency_ms << " ms is above the budget of "
+        << max_median_latency_ms_ << " ms. Check recent changes to publishFrame and the conversion functions.";
+  }
+  if (cache_miss_call_ms)
+  {
+    ROS_INFO("Capture service call with a cache miss: %.2f ms, median with cache hits: %.2f ms", *cache_miss_call_ms,
+             median_capture_call_ms);
+    EXPECT_LT(median_capture_call_ms, *cache_miss_call_ms)
+        << "Captures served from the decoded frame cache are not faster than captures that decode the file.";
+  }
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  ros::init(argc, argv, "test_zivid_camera_perf");
+  ros::NodeHandle nh;
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,142 @@
+#ifdef __clang__
+#pragma clang diagnostic push
+// Errors to ignore for this entire file
+#pragma clang diagnostic ignored "-Wglobal-constructors"  // error triggered by gtest fixtures
+#endif
+
+#include "zivid_image_message.h"
+
+#include "gtest_include_wrapper.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+std_msgs::Header makeHeader()
+{
+  std_msgs::Header header;
+  header.seq = 42;
+  header.stamp = ros::Time(1234, 5678);
+  header.frame_id = "zivid_optical_frame";
+  return header;
+}
+
+std::shared_ptr<const Zivid::Image<Zivid::RGBA8>> makeImage(std::size_t width, std::size_t height)
+{
+  if (width * height == 0)
+  {
+    return std::make_shared<const Zivid::Image<Zivid::RGBA8>>();
+  }
+  std::vector<Zivid::RGBA8> pixels(width * height);
+  for (std::size_t i = 0; i < pixels.size(); i++)
+  {
+    pixels[i].r = static_cast<std::uint8_t>(i);
+    pixels[i].g = static_cast<std::uint8_t>(2 * i);
+    pixels[i].b = static_cast<std::uint8_t>(3 * i);
+    pixels[i].a = 255;
+  }
+  return std::make_shared<const Zivid::Image<Zivid::RGBA8>>(width, height, pixels.data(),
+                                                            pixels.data() + pixels.size());
+}
+
+// The sensor_msgs::Image that the driver publishes for the same image when it copies the pixels
+sensor_msgs::Image makeEquivalentImage(const std_msgs::Header& header, const Zivid::Image<Zivid::RGBA8>& image)
+{
+  sensor_msgs::Image msg;
+  msg.header = header;
+  msg.height = static_cast<std::uint32_t>(image.height());
+  msg.width = static_cast<std::uint32_t>(image.width());
+  msg.encoding = sensor_msgs::image_encodings::RGBA8;
+  msg.is_bigendian = 0;
+  msg.step = static_cast<std::uint32_t>(sizeof(Zivid::RGBA8) * image.width());
+  const auto* data = reinterpret_cast<const std::uint8_t*>(image.dataPtr());
+  msg.data = std::vector<std::uint8_t>(data, data + image.size() * sizeof(Zivid::RGBA8));
+  return msg;
+}
+
+template <typename Message>
+std::vector<std::uint8_t> serialize(const Message& msg)
+{
+  std::vector<std::uint8_t> buffer(ros::serialization::serializationLength(msg));
+  ros::serialization::OStream stream(buffer.data(), static_cast<std::uint32_t>(buffer.size()));
+  ros::serialization::serialize(stream, msg);
+  return buffer;
+}
+
+template <typename Message>
+std::vector<std::uint8_t> serializeForPublishing(const Message& msg)
+{
+  const auto serialized = ros::serialization::serializeMessage(msg);
+  return std::vector<std::uint8_t>(serialized.buf.get(), serialized.buf.get() + serialized.num_bytes);
+}
+
+void assertSerializedLikeImage(std::size_t width, std::size_t height)
+{
+  zivid_camera::ZividImageMessage msg;
+  msg.header = makeHeader();
+  msg.image = makeImage(width, height);
+  const auto expected = makeEquivalentImage(msg.header, *msg.image);
+
+  ASSERT_EQ(ros::serialization::serializationLength(msg), ros::serialization::serializationLength(expected));
+  ASSERT_EQ(serialize(msg), serialize(expected));
+  ASSERT_EQ(serializeForPublishing(msg), serializeForPublishing(expected));
+}
+}  // namespace
+
+TEST(ZividImageMessageTest, testSerializesToTheSameBytesAsImage)
+{
+  assertSerializedLikeImage(5, 3);
+}
+
+TEST(ZividImageMessageTest, testSerializesEmptyImageToTheSameBytesAsImage)
+{
+  assertSerializedLikeImage(0, 0);
+}
+
+TEST(ZividImageMessageTest, testSerializesSinglePixelImageToTheSameBytesAsImage)
+{
+  assertSerializedLikeImage(1, 1);
+}
+
+TEST(ZividImageMessageTest, testDeserializesAsImage)
+{
+  zivid_camera::ZividImageMessage msg;
+  msg.header = makeHeader();
+  msg.image = makeImage(4, 2);
+
+  auto buffer = serialize(msg);
+  sensor_msgs::Image image;
+  ros::serialization::IStream stream(buffer.data(), static_cast<std::uint32_t>(buffer.size()));
+  ros::serialization::deserialize(stream, image);
+
+  const auto expected = makeEquivalentImage(msg.header, *msg.image);
+  ASSERT_EQ(image.header.seq, expected.header.seq);
+  ASSERT_EQ(image.header.stamp, expected.header.stamp);
+  ASSERT_EQ(image.header.frame_id, expected.header.frame_id);
+  ASSERT_EQ(image.height, expected.height);
+  ASSERT_EQ(image.width, expected.width);
+  ASSERT_EQ(image.encoding, expected.encoding);
+  ASSERT_EQ(image.is_bigendian, expected.is_bigendian);
+  ASSERT_EQ(image.step, expected.step);
+  ASSERT_EQ(image.data, expected.data);
+}
+
+TEST(ZividImageMessageTest, testHasTheTraitsOfImage)
+{
+  using ZividImageTraits = ros::message_traits::MD5Sum<zivid_camera::ZividImageMessage>;
+  using ImageTraits = ros::message_traits::MD5Sum<sensor_msgs::Image>;
+  ASSERT_EQ(std::string(ZividImageTraits::value()), std::string(ImageTraits::value()));
+  ASSERT_EQ(std::string(ros::message_traits::datatype<zivid_camera::ZividImageMessage>()),
+            std::string(ros::message_traits::datatype<sensor_msgs::Image>()));
+  ASSERT_EQ(std::string(ros::message_traits::definition<zivid_camera::ZividImageMessage>()),
+            std::string(ros::message_traits::definition<sensor_msgs::Image>()));
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}